@@ -0,0 +1,8 @@
+#!/bin/sh
+# command line tools (Linux), the game itself is built with build.bat
+c++ ./src/perft.cpp -O2 -march=native -Wall -o perft
+c++ ./src/perft.cpp -O2 -march=native -Wall -DSCL_960_CASTLING=1 -o perft960
+c++ ./src/bench.cpp -O2 -march=native -Wall -DSCL_THREADS=1 -DSCL_NNUE=1 -pthread -o bench
+c++ ./src/bench.cpp -O2 -march=native -Wall -DSCL_SEARCH_NEGAMAX=0 -o benchlegacy
+c++ ./src/uci.cpp -O2 -march=native -Wall -DSCL_THREADS=1 -DSCL_NNUE=1 -pthread -o uci
+c++ ./src/match.cpp -O2 -march=native -Wall -DSCL_NNUE=1 -pthread -o match
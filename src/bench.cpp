@@ -0,0 +1,436 @@
+// Search benchmark, build with build.sh. Searches a set of positions to a fixed
+// depth and reports searched nodes and time, so that changes to the search can
+// be compared at equal depth. The signature mode prints just the total node
+// count, which only changes when the search or evaluation behaves differently,
+// and the speed in nps. The nnue mode times the NNUE accumulator, the hash mode
+// checks that the largest transposition table (UCI's Hash maximum) works.
+
+#define SCL_COUNT_EVALUATED_POSITIONS 1
+#define SCL_TRANSPOSITION_TABLE_SIZE 16
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "smallchesslib.h"
+
+const char* bench_positions[] = {
+    SCL_FEN_START,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "rnbqkb1r/pp2pppp/3p1n2/8/3NP3/8/PPP2PPP/RNBQKB1R w KQkq - 1 5",
+    "r1bq1rk1/ppp2ppp/2np1n2/2b1p3/2B1P3/2PP1N2/PP3PPP/RNBQ1RK1 w - - 1 7",
+    "2r3k1/pp3ppp/4p3/3pP3/3P4/P4N2/1P3PPP/2R3K1 w - - 0 24",
+    "8/5pk1/6p1/8/3K4/8/5PPP/8 w - - 0 40",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "4r1k1/1q3ppp/p7/1p1Q4/8/1P4P1/P4P1P/3R2K1 b - - 0 28",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+    "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+    "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+    "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+    "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+    "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+    "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+    "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+    "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+    "2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+    "8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+    "7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+    "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+    "8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1",
+    "8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+    "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+    "1r3k2/4q3/2Pp3b/3Bp3/2Q2p2/1p1P2P1/1P2KP2/3N4 w - - 0 1",
+    "8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1",
+    "5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90",
+    "4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+    "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+    "3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+    "4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+    "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+    "8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+    "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+    "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+    "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+    "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+    "6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+    "8/8/8/8/8/6k1/6p1/6K1 w - - 0 1",
+    "7k/7P/6K1/8/3B4/8/8/8 b - - 0 1",
+};
+
+double time_ms() {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct bench_result {
+    uint64_t nodes;
+    double time;
+};
+
+bench_result run_bench(int depth, int extra_depth, bool print) {
+    bench_result result = { 0, 0 };
+    int count = sizeof(bench_positions) / sizeof(bench_positions[0]);
+
+    for (int i = 0; i < count; i++) {
+        SCL_Board board;
+        uint8_t from, to;
+        char promotion;
+        char move_string[8];
+
+        SCL_boardFromFEN(board, bench_positions[i]);
+        SCL_transpositionTableClear(&SCL_transpositionTable);
+        SCL_positionsEvaluated = 0;
+
+        double start = time_ms();
+        int16_t score = SCL_getAIMove(board, depth, extra_depth, 0, SCL_boardEvaluateStatic, 0, 0, 255, 255,
+                                      &from, &to, &promotion);
+        double time = time_ms() - start;
+
+        result.nodes += SCL_positionsEvaluated;
+        result.time += time;
+
+        if (print) {
+            printf("  %2d %-6s %6d %10lu nodes %8.1f ms\n", i + 1,
+                   SCL_moveToString(board, from, to, promotion, move_string), score,
+                   (unsigned long)SCL_positionsEvaluated, time);
+        }
+    }
+
+    return result;
+}
+
+int run_signature(int depth, int extra_depth) {
+    int count = sizeof(bench_positions) / sizeof(bench_positions[0]);
+
+    SCL_transpositionTableInit(&SCL_transpositionTable, SCL_TRANSPOSITION_TABLE_SIZE);
+    bench_result result = run_bench(depth, extra_depth, false);
+
+    printf("%d positions, depth %d, extension depth %d, %d MB transposition table\n", count, depth, extra_depth,
+           SCL_TRANSPOSITION_TABLE_SIZE);
+    printf("signature %llu\ntime %.1f ms\nnps %.0f\n", (unsigned long long)result.nodes, result.time,
+           result.nodes * 1000.0 / result.time);
+
+    return 0;
+}
+
+// Allocates and clears a table of the size, then stores and probes an entry in
+// its first and last bucket.
+int run_hash(int size_mb) {
+    double start = time_ms();
+
+    if (!SCL_transpositionTableInit(&SCL_transpositionTable, size_mb)) {
+        printf("%d MB transposition table couldn't be allocated\n", size_mb);
+        return 1;
+    }
+
+    uint64_t buckets = (uint64_t)SCL_transpositionTable.bucketMask + 1;
+    uint64_t keys[2] = { 0x1234567800000000ULL, 0x1234567800000000ULL | SCL_transpositionTable.bucketMask };
+    bool ok = true;
+
+    for (int i = 0; i < 2; i++) {
+        SCL_TranspositionEntry entry;
+
+        SCL_transpositionTableStore(&SCL_transpositionTable, keys[i], 5, SCL_BOUND_EXACT, 100 + i, 0);
+        ok = ok && SCL_transpositionTableProbe(&SCL_transpositionTable, keys[i], &entry) && entry.score == 100 + i;
+    }
+
+    printf("%d MB transposition table: %llu buckets (%llu MB) in %.1f ms, %s\n", size_mb,
+           (unsigned long long)buckets, (unsigned long long)(buckets * 64 / (1024 * 1024)), time_ms() - start,
+           ok ? "ok" : "FAILED");
+
+    SCL_transpositionTableInit(&SCL_transpositionTable, SCL_TRANSPOSITION_TABLE_SIZE);
+
+    return ok ? 0 : 1;
+}
+
+uint32_t time_function() {
+    return (uint32_t)time_ms();
+}
+
+SCL_Board info_board;
+
+void print_info(const SCL_SearchInfo* info) {
+    char move_string[8];
+
+    printf("    depth %2d %-6s %6d %10llu nodes %6lu ms %5.1f %% first move cutoffs %5.1f %% pawn hits\n",
+           info->depth,
+           SCL_moveToString(info_board, SCL_moveFrom(info->move), SCL_moveTo(info->move),
+                            SCL_movePromotion(info->move), move_string),
+           info->score, (unsigned long long)info->nodes, (unsigned long)info->time,
+           info->cutoffs ? 100.0 * info->firstMoveCutoffs / info->cutoffs : 0.0,
+           info->pawnTableProbes ? 100.0 * info->pawnTableHits / info->pawnTableProbes : 0.0);
+}
+
+int run_timed(int time, int extra_depth) {
+    int count = sizeof(bench_positions) / sizeof(bench_positions[0]);
+    SCL_SearchLimits limits = {};
+
+    limits.time = time;
+    limits.timeFunction = time_function;
+
+    printf("%d ms per position, extension depth %d\n", time, extra_depth);
+
+    for (int i = 0; i < count; i++) {
+        uint8_t from, to;
+        char promotion;
+
+        SCL_boardFromFEN(info_board, bench_positions[i]);
+        SCL_transpositionTableClear(&SCL_transpositionTable);
+
+        printf("  %2d %s\n", i + 1, bench_positions[i]);
+        SCL_getAIMoveIterative(info_board, &limits, extra_depth, SCL_boardEvaluateTapered, 0, 0, 255, 255,
+                               print_info, &from, &to, &promotion);
+    }
+
+    return 0;
+}
+
+uint64_t last_nodes;
+
+void store_info(const SCL_SearchInfo* info) {
+    last_nodes = info->nodes;
+}
+
+int run_threads(int depth, int extra_depth) {
+    int count = sizeof(bench_positions) / sizeof(bench_positions[0]);
+    int thread_counts[] = { 1, 2, 4, 8, 16 };
+    SCL_SearchLimits limits = {};
+    double single_time = 0;
+    double single_root_time = 0;
+    uint32_t parallel_root_results = 0;
+
+    limits.depth = depth;
+
+    printf("time to depth %d, extension depth %d (Lazy SMP iterative search and root parallel\n"
+           "fixed depth search, whose result hash must be the same for 2 and more threads)\n", depth, extra_depth);
+
+    for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+        int threads = thread_counts[t];
+
+        if (SCL_setThreads(threads) != threads) {
+            printf("  %d threads not available, compile with SCL_THREADS\n", threads);
+            break;
+        }
+
+        uint64_t nodes = 0;
+        double time = 0;
+        double root_time = 0;
+        uint32_t root_results = 0;
+
+        for (int i = 0; i < count; i++) {
+            SCL_Board board;
+            uint8_t from, to;
+            char promotion;
+
+            SCL_boardFromFEN(board, bench_positions[i]);
+            SCL_transpositionTableClear(&SCL_transpositionTable);
+
+            double start = time_ms();
+            SCL_getAIMoveIterative(board, &limits, extra_depth, SCL_boardEvaluateStatic, 0, 0, 255, 255,
+                                   store_info, &from, &to, &promotion);
+            time += time_ms() - start;
+            nodes += last_nodes;
+
+            // root parallel search, deterministic so the results are hashed to compare
+            SCL_transpositionTableClear(&SCL_transpositionTable);
+
+            start = time_ms();
+            int16_t score = SCL_getAIMove(board, depth, extra_depth, 0, SCL_boardEvaluateStatic, 0, 0, 255, 255,
+                                          &from, &to, &promotion);
+            root_time += time_ms() - start;
+            root_results = root_results * 31 + ((from << 8) | to) * 65537 + (uint16_t)score;
+        }
+
+        if (threads == 1) {
+            single_time = time;
+            single_root_time = root_time;
+        } else if (threads == 2) {
+            parallel_root_results = root_results;
+        }
+
+        printf("  %2d threads %9.1f ms %11llu nodes %6.2f x speedup, ", threads, time,
+               (unsigned long long)nodes, single_time / time);
+        printf("root parallel %9.1f ms %6.2f x speedup %08x%s\n", root_time, single_root_time / root_time,
+               root_results, threads > 2 && root_results != parallel_root_results ? " DIFFERENT" : "");
+    }
+
+    SCL_setThreads(1);
+
+    return 0;
+}
+
+#if SCL_NNUE
+// Times computing the NNUE accumulators of the positions from scratch against
+// updating them by making and undoing every legal move (except king moves,
+// which may change the king bucket) and the output layer, for each instruction
+// set the CPU supports. The evaluation sum has to be the same for all of them.
+int run_nnue(const char* file) {
+    int count = sizeof(bench_positions) / sizeof(bench_positions[0]);
+    static SCL_Position positions[sizeof(bench_positions) / sizeof(bench_positions[0])];
+    static SCL_MoveList moves[sizeof(bench_positions) / sizeof(bench_positions[0])];
+    int move_count = 0;
+
+    if (file) {
+        FILE* f = fopen(file, "rb");
+        static uint8_t data[SCL_NNUE_FILE_SIZE + 1];
+        size_t size = f ? fread(data, 1, sizeof(data), f) : 0;
+
+        if (f) {
+            fclose(f);
+        }
+
+        if (!SCL_nnueLoad(&SCL_nnueNetwork, data, (uint32_t)size)) {
+            printf("%s is not a network with %d features and %d neurons\n", file, SCL_NNUE_FEATURES,
+                   SCL_NNUE_HIDDEN);
+            return 1;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        SCL_positionFromFEN(&positions[i], bench_positions[i]);
+        SCL_positionGetMoves(&positions[i], &moves[i]);
+        move_count += moves[i].count;
+    }
+
+    printf("%s network, %d features, %d neurons per perspective, %d positions, %d moves\n",
+           file ? file : "default", SCL_NNUE_FEATURES, SCL_NNUE_HIDDEN, count, move_count);
+
+    uint8_t best = SCL_nnueImplementation;
+    const int rounds = 1000;
+
+    for (uint8_t implementation = SCL_NNUE_SCALAR; implementation <= SCL_NNUE_NEON; implementation++) {
+        if (!SCL_nnueSetImplementation(implementation)) {
+            continue;
+        }
+
+        long evaluation_sum = 0;
+        double start = time_ms();
+
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < count; i++) {
+                SCL_positionNNUERefresh(&positions[i]);
+            }
+        }
+
+        double refresh_time = (time_ms() - start) * 1000000 / ((double)rounds * count);
+        double update_times[2] = { 0, 0 };
+        int updates = 0;
+
+        for (int active = 0; active < 2; active++) {
+            updates = 0;
+            start = time_ms();
+
+            for (int i = 0; i < count; i++) {
+                SCL_Position* position = &positions[i];
+
+                if (active) {
+                    SCL_positionNNUERefresh(position);
+                } else {
+                    position->nnue.active = 0;
+                }
+
+                for (int m = 0; m < moves[i].count; m++) {
+                    uint8_t from = SCL_moveFrom(moves[i].moves[m]);
+
+                    if (SCL_positionPieceType(position, from) == SCL_PIECE_KING) {
+                        continue;
+                    }
+
+                    for (int r = 0; r < rounds; r++) {
+                        SCL_PositionUndo undo = SCL_positionMakeMove(position, from, SCL_moveTo(moves[i].moves[m]),
+                                                                     SCL_movePromotion(moves[i].moves[m]));
+                        SCL_positionUndoMove(position, undo);
+                    }
+
+                    updates += rounds;
+                }
+            }
+
+            update_times[active] = (time_ms() - start) * 1000000 / updates;
+        }
+
+        start = time_ms();
+
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < count; i++) {
+                evaluation_sum += SCL_positionEvaluateNNUE(&positions[i]);
+            }
+        }
+
+        double output_time = (time_ms() - start) * 1000000 / ((double)rounds * count);
+
+        // the update time is what the accumulator adds to making and undoing a move
+        double update_time = update_times[1] - update_times[0];
+
+        printf("  %-6s refresh %7.1f ns, update %6.1f ns (%5.1f x faster), output %5.1f ns, evaluation sum %ld\n",
+               SCL_nnueImplementationName(implementation), refresh_time, update_time, refresh_time / update_time,
+               output_time, evaluation_sum / rounds);
+    }
+
+    SCL_nnueSetImplementation(best);
+
+    return 0;
+}
+#endif
+
+int main(int argc, char** argv) {
+    SCL_init();
+
+    if (argc >= 3 && strcmp(argv[1], "time") == 0) {
+        return run_timed(atoi(argv[2]), argc >= 4 ? atoi(argv[3]) : 3);
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "threads") == 0) {
+        return run_threads(atoi(argv[2]), argc >= 4 ? atoi(argv[3]) : 3);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "signature") == 0) {
+        return run_signature(argc >= 3 ? atoi(argv[2]) : 5, argc >= 4 ? atoi(argv[3]) : 3);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "hash") == 0) {
+        return run_hash(argc >= 3 ? atoi(argv[2]) : 4096);
+    }
+
+#if SCL_NNUE
+    if (argc >= 2 && strcmp(argv[1], "nnue") == 0) {
+        return run_nnue(argc >= 3 ? argv[2] : 0);
+    }
+#endif
+
+    int depth = argc >= 2 ? atoi(argv[1]) : 3;
+    int extra_depth = argc >= 3 ? atoi(argv[2]) : 3;
+    int table_size = argc >= 4 ? atoi(argv[3]) : SCL_TRANSPOSITION_TABLE_SIZE;
+
+    if (depth <= 0) {
+        printf("usage: %s [DEPTH [EXTENSION DEPTH [TABLE MB]] | time MS [EXTENSION DEPTH] |\n"
+               "  threads DEPTH [EXTENSION DEPTH] | signature [DEPTH [EXTENSION DEPTH]] |\n"
+               "  nnue [FILE] | hash [MB]]\n", argv[0]);
+        return 1;
+    }
+
+    printf("depth %d, extension depth %d, no transposition table\n", depth, extra_depth);
+    SCL_transpositionTableInit(&SCL_transpositionTable, 0);
+    bench_result without_table = run_bench(depth, extra_depth, true);
+
+    printf("depth %d, extension depth %d, %d MB transposition table\n", depth, extra_depth, table_size);
+    SCL_transpositionTableInit(&SCL_transpositionTable, table_size);
+    bench_result with_table = run_bench(depth, extra_depth, true);
+
+    printf("nodes %llu -> %llu (%.1f %%), time %.1f ms -> %.1f ms\n",
+           (unsigned long long)without_table.nodes, (unsigned long long)with_table.nodes,
+           100.0 * with_table.nodes / without_table.nodes, without_table.time, with_table.time);
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+// Background AI search, so that the caller (e.g. the render loop) never blocks
+// on it. engine_start copies the position and searches it on its own thread,
+// engine_poll returns the move once the search has finished, engine_stop ends
+// the search early and returns the best move found so far and engine_cancel
+// throws the search away. Include after smallchesslib.h. Only one search runs
+// at a time because the library's transposition table is global.
+//
+// Pondering: start a search without limits on the position after the expected
+// reply (engine_result::ponder). If the opponent plays it, engine_ponderhit
+// turns it into a normal timed search that keeps everything searched so far,
+// otherwise cancel it, the transposition table it filled is still used by the
+// next search.
+//
+// info_function and done_function, if set, are called on the search thread
+// after each completed iteration and with the result once the search ends.
+// evaluation, if set, replaces SCL_boardEvaluateTapered.
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#endif
+
+struct engine_result {
+    uint8_t from;
+    uint8_t to;
+    char promotion;
+    int16_t score;
+    SCL_Move ponder; // expected reply or SCL_MOVE_NONE
+    uint64_t nodes;  // searched, also by helper threads and in the unfinished last iteration
+    uint32_t time;   // ms the search took
+};
+
+struct engine {
+    SCL_SearchInfoFunction info_function;
+    void (*done_function)(const engine_result* result);
+    SCL_StaticEvaluationFunction evaluation;
+    SCL_Board board;
+    SCL_SearchLimits limits;
+    uint8_t extra_depth;
+    uint8_t randomness;
+    uint8_t repetition_from;
+    uint8_t repetition_to;
+    volatile uint8_t stop;
+    volatile uint32_t ponder_time; // set by engine_ponderhit, read by the search
+    volatile uint8_t done;
+    bool running;
+    engine_result result;
+#ifdef _WIN32
+    HANDLE thread;
+#else
+    pthread_t thread;
+#endif
+};
+
+uint32_t engine_time() {
+#ifdef _WIN32
+    return GetTickCount();
+#else
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec * 1000 + now.tv_nsec / 1000000);
+#endif
+}
+
+void engine_search(engine* e) {
+    uint32_t start = engine_time();
+
+    e->result.score = SCL_getAIMoveIterative(e->board, &e->limits, e->extra_depth,
+                                             e->evaluation ? e->evaluation : SCL_boardEvaluateTapered,
+                                             e->randomness ? SCL_randomBetter : 0, e->randomness,
+                                             e->repetition_from, e->repetition_to, e->info_function, &e->result.from,
+                                             &e->result.to, &e->result.promotion);
+    e->result.nodes = SCL_searchNodes;
+    e->result.time = engine_time() - start;
+    e->result.ponder = SCL_getAIPonderMove(e->board, e->result.from, e->result.to, e->result.promotion,
+                                           e->extra_depth);
+
+    if (e->done_function) {
+        e->done_function(&e->result);
+    }
+
+    e->done = 1;
+}
+
+#ifdef _WIN32
+DWORD WINAPI engine_thread(LPVOID data) {
+    engine_search((engine*)data);
+    return 0;
+}
+#else
+void* engine_thread(void* data) {
+    engine_search((engine*)data);
+    return 0;
+}
+#endif
+
+void engine_join(engine* e) {
+#ifdef _WIN32
+    WaitForSingleObject(e->thread, INFINITE);
+    CloseHandle(e->thread);
+#else
+    pthread_join(e->thread, 0);
+#endif
+    e->running = false;
+}
+
+// true from engine_start until the result has been taken by poll or stop
+bool engine_busy(const engine* e) {
+    return e->running || e->done;
+}
+
+// Ends a running search and waits for its thread, the search notices the stop
+// flag within a few hundred nodes.
+void engine_cancel(engine* e) {
+    if (e->running) {
+        e->stop = 1;
+        engine_join(e);
+    }
+
+    e->done = 0;
+}
+
+// Starts searching the position within the limits (all 0 means until stopped),
+// a running search is cancelled first. Depth 1 is always completed so there is
+// always a move to return. Returns false if the thread couldn't be created, in
+// which case the search runs synchronously and the result is ready to poll.
+bool engine_start(engine* e, const SCL_Board board, const SCL_SearchLimits* limits, uint8_t extra_depth,
+                  uint8_t randomness, uint8_t repetition_from, uint8_t repetition_to) {
+    engine_cancel(e);
+
+    SCL_boardCopy(board, e->board);
+    e->limits = *limits;
+    e->limits.timeFunction = engine_time;
+    e->limits.stop = &e->stop;
+    e->limits.newTime = &e->ponder_time;
+    e->extra_depth = extra_depth;
+    e->randomness = randomness;
+    e->repetition_from = repetition_from;
+    e->repetition_to = repetition_to;
+    e->stop = 0;
+    e->ponder_time = 0;
+    e->done = 0;
+    e->running = true;
+
+#ifdef _WIN32
+    e->thread = CreateThread(0, 0, engine_thread, e, 0, 0);
+    bool started = e->thread != 0;
+#else
+    bool started = pthread_create(&e->thread, 0, engine_thread, e) == 0;
+#endif
+
+    if (!started) {
+        engine_search(e);
+        e->running = false;
+    }
+
+    return started;
+}
+
+// Gives a search started without limits (a ponder search) time ms in total,
+// counted from its start, so if it has run longer it returns its move right
+// away.
+void engine_ponderhit(engine* e, uint32_t time) {
+    e->ponder_time = time != 0 ? time : 1;
+}
+
+// Returns true and the move once a search started by engine_start has finished,
+// each search's result is returned only once.
+bool engine_poll(engine* e, engine_result* result) {
+    if (!e->done) {
+        return false;
+    }
+
+    if (e->running) {
+        engine_join(e);
+    }
+
+    e->done = 0;
+    *result = e->result;
+
+    return true;
+}
+
+// Stops the search now and returns the best move of the last completed depth.
+bool engine_stop(engine* e, engine_result* result) {
+    if (e->running) {
+        e->stop = 1;
+        engine_join(e);
+    }
+
+    return engine_poll(e, result);
+}
@@ -3,8 +3,11 @@
 #define WINDOW_WIDTH 738
 #define WINDOW_HEIGHT 767
 
+#define SCL_TRANSPOSITION_TABLE_SIZE 16
+
 #include "smallchesslib.h"
 #include "audio.h"
+#include "engine.h"
 
 SCL_Game game;
 SCL_SquareSet possible_moves;
@@ -18,6 +21,10 @@ bool anim_active = false;
 
 char fen_string[SCL_FEN_MAX_LENGTH] = { 0 };
 
+engine ai = {};
+bool pondering = false;
+SCL_Move ponder_move = SCL_MOVE_NONE;
+
 void copy_to_clipboard() {
     SCL_boardToFEN(game.board, &fen_string[0]);
     const size_t len = strlen(fen_string) + 1;
@@ -54,6 +61,8 @@ void start_piece_animation(char piece) {
 }
 
 void game_init() {
+    engine_cancel(&ai);
+    pondering = false;
     SCL_gameInit(&game, 0);
     SCL_randomBetterSeed(rand());
     SCL_squareSetClear(possible_moves);
@@ -63,26 +72,63 @@ void game_init() {
     anim_active = false;
 }
 
-void ai_move() {
-    uint8_t depth = 2;
+// starts the search on the AI thread, game_update plays the move once it is found
+void ai_start(SCL_Game* position, uint32_t time) {
     uint8_t extraDepth = 3;
-    uint8_t endgameDepth = 1;
-    uint8_t randomness = game.ply < 2 ? 1 : 0;
+    uint8_t randomness = position->ply < 2 ? 1 : 0;
     uint8_t rs0, rs1;
-    uint8_t s0, s1;
-    char promoteTo;
 
-    SCL_gameGetRepetiotionMove(&game, &rs0, &rs1);
-    SCL_getAIMove(game.board, depth, extraDepth, endgameDepth, SCL_boardEvaluateStatic, SCL_randomBetter, randomness, rs0, rs1, &s0, &s1, &promoteTo);
+    // search deeper until the time is used up, depth 1 always completes
+    SCL_SearchLimits limits = {};
+    limits.time = time;
+
+    SCL_gameGetRepetiotionMove(position, &rs0, &rs1);
+    engine_start(&ai, position->board, &limits, extraDepth, randomness, rs0, rs1);
+    pondering = false;
+}
+
+// searches the position after the expected reply while the player thinks
+void ai_ponder(SCL_Move move) {
+    SCL_Game position = game;
+
+    SCL_gameMakeMove(&position, SCL_moveFrom(move), SCL_moveTo(move), SCL_movePromotion(move));
+    ai_start(&position, 0);
+    pondering = true;
+    ponder_move = move;
+}
+
+// the player moved, the AI either already searches the position or starts now
+void ai_player_moved(uint8_t from, uint8_t to, char promotion) {
+    if (!pondering) {
+        return;
+    }
+
+    if (from == SCL_moveFrom(ponder_move) && to == SCL_moveTo(ponder_move) &&
+        (promotion == 0 || SCL_pieceToColor(promotion, 0) == SCL_movePromotion(ponder_move))) {
+        engine_ponderhit(&ai, 500);
+    } else {
+        engine_cancel(&ai);
+    }
+
+    pondering = false;
+}
 
-    char moving_piece = game.board[s0];
+void ai_play(const engine_result* result) {
+    char moving_piece = game.board[result->from];
 
-    last_move_from = s0;
-    last_move_to = s1;
+    last_move_from = result->from;
+    last_move_to = result->to;
 
     start_piece_animation(moving_piece);
 
-    SCL_gameMakeMove(&game, s0, s1, promoteTo);
+    SCL_gameMakeMove(&game, result->from, result->to, result->promotion);
+    trigger_sfx();
+    selected_square = -1;
+    SCL_squareSetClear(possible_moves);
+
+    if (SCL_boardWhitesTurn(game.board) && !SCL_boardGameOver(game.board) && result->ponder != SCL_MOVE_NONE) {
+        ai_ponder(result->ponder);
+    }
 }
 
 void draw_piece_at_pos(vec2 pos, float piece, float piece_color) {
@@ -115,6 +161,9 @@ void game_update() {
     }
 
     if (key_pressed('Z')) {
+        engine_cancel(&ai);
+        pondering = false;
+
         if (SCL_gameUndoMove(&game)) {
             if (SCL_gameUndoMove(&game)) {
                 trigger_sfx();
@@ -127,6 +176,17 @@ void game_update() {
         }
     }
 
+    engine_result ai_result;
+
+    // the search runs while the previous move is animated, its move waits for it
+    if (!anim_active && !pondering) {
+        if (key_pressed('M') && engine_stop(&ai, &ai_result)) {
+            ai_play(&ai_result);
+        } else if (engine_poll(&ai, &ai_result)) {
+            ai_play(&ai_result);
+        }
+    }
+
     if (anim_active) {
         anim_progress += 2.0 * delta_time();
         if (anim_progress >= 1.0f) {
@@ -139,9 +199,8 @@ void game_update() {
 
     } else {
         if (SCL_boardWhitesTurn(game.board)) {
-            if (key_pressed('H')) {
-                ai_move();
-                trigger_sfx();
+            if (key_pressed('H') && (!engine_busy(&ai) || pondering)) {
+                ai_start(&game, 500);
                 selected_square = -1;
                 SCL_squareSetClear(possible_moves);
             }
@@ -149,7 +208,7 @@ void game_update() {
             vec2 mouse_pos = mouse_position();
             int hovered_square = screen_to_square(mouse_pos);
 
-            if (mouse_pressed(0)) {
+            if (mouse_pressed(0) && (!engine_busy(&ai) || pondering)) {
                 if (hovered_square != -1) {
                     char clicked_piece = game.board[hovered_square];
                     if (clicked_piece != '.' && SCL_pieceIsWhite(clicked_piece)) {
@@ -176,6 +235,7 @@ void game_update() {
                         last_move_to = hovered_square;
                         start_piece_animation(moving_piece);
 
+                        ai_player_moved(selected_square, hovered_square, promotion);
                         SCL_gameMakeMove(&game, selected_square, hovered_square, promotion);
                         trigger_sfx();
 
@@ -187,11 +247,8 @@ void game_update() {
                     }
                 }
             }
-        } else if(!anim_active) {
-            ai_move();
-            trigger_sfx();
-            selected_square = -1;
-            SCL_squareSetClear(possible_moves);
+        } else if(!engine_busy(&ai)) {
+            ai_start(&game, 500);
         }
     }
 
@@ -0,0 +1,519 @@
+// Self-play match between two AI configurations, build with build.sh. Games
+// run concurrently on more threads, each pair of games starts from its own
+// opening with colors swapped: a line of the set followed by a few moves picked
+// by a shallow randomized search, never repeated, because the configurations
+// search deterministically and a repeated opening would repeat the whole game
+// and count it in the statistics twice. The match stops early once a sequential
+// probability ratio test (SPRT) decides whether B is ELO1 stronger or ELO0 (not
+// stronger) than A, then prints Elo with 95 % error bars and nps per config.
+// Configurations are runtime settings (evaluation, limits) and one of the
+// compile time specialized searches below (search_config.h), to compare other
+// compile time flags build match with them and compare each build against the
+// same reference config.
+
+#define SCL_THREAD_LOCAL thread_local // own table and random state per thread
+#define SCL_TRANSPOSITION_TABLE_SIZE 16
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "smallchesslib.h"
+
+const char* openings[] = {
+    "e2e4 e7e5 g1f3 b8c6", "e2e4 c7c5 g1f3 d7d6", "e2e4 c7c5 b1c3 b8c6", "e2e4 e7e6 d2d4 d7d5",
+    "e2e4 c7c6 d2d4 d7d5", "e2e4 d7d6 d2d4 g8f6", "e2e4 e7e5 f1c4 g8f6", "e2e4 d7d5 e4d5 d8d5",
+    "e2e4 g8f6 e4e5 f6d5", "e2e4 g7g6 d2d4 f8g7", "d2d4 d7d5 c2c4 e7e6", "d2d4 d7d5 c2c4 c7c6",
+    "d2d4 g8f6 c2c4 e7e6", "d2d4 g8f6 c2c4 g7g6", "d2d4 f7f5 g2g3 g8f6", "d2d4 d7d5 g1f3 g8f6",
+    "c2c4 e7e5 b1c3 g8f6", "c2c4 c7c5 g1f3 b8c6", "g1f3 d7d5 g2g3 g8f6", "g1f3 g8f6 c2c4 e7e6",
+    "e2e4 e7e5 g1f3 g8f6", "d2d4 g8f6 g1f3 d7d5", "b2b3 e7e5 c1b2 b8c6", "e2e4 b8c6 d2d4 d7d5",
+};
+
+#define MAX_GAME_PLY 400 // longer games are adjudicated as draws
+#define RANDOM_OPENING_PLY 4 // moves added to a line of the set to make each opening different
+#define OPENING_ATTEMPTS 100 // tries to find a new opening before a repeated one is accepted
+
+// material only, a weaker evaluation to compare against
+int16_t evaluate_material(SCL_Board board) {
+    int16_t score = 0;
+
+    for (int i = 0; i < 64; i++) {
+        switch (board[i]) {
+            case 'P': score += SCL_VALUE_PAWN; break;
+            case 'N': score += SCL_VALUE_KNIGHT; break;
+            case 'B': score += SCL_VALUE_BISHOP; break;
+            case 'R': score += SCL_VALUE_ROOK; break;
+            case 'Q': score += SCL_VALUE_QUEEN; break;
+            case 'p': score -= SCL_VALUE_PAWN; break;
+            case 'n': score -= SCL_VALUE_KNIGHT; break;
+            case 'b': score -= SCL_VALUE_BISHOP; break;
+            case 'r': score -= SCL_VALUE_ROOK; break;
+            case 'q': score -= SCL_VALUE_QUEEN; break;
+            default: break;
+        }
+    }
+
+    return score;
+}
+
+struct evaluation {
+    const char* name;
+    SCL_StaticEvaluationFunction function;
+};
+
+evaluation evaluations[] = {
+    { "static", SCL_boardEvaluateStatic },
+    { "tapered", SCL_boardEvaluateTapered },
+    { "material", evaluate_material },
+#if SCL_NNUE
+    { "nnue", SCL_boardEvaluateNNUE },
+#endif
+};
+
+// compile time specialized searches, chosen with search=NAME
+
+#define SEARCH_CONFIG_NAME full // all of the features
+#include "search_config.h"
+
+#define SEARCH_CONFIG_NAME no_nmp
+#define SEARCH_CONFIG_PRUNING (SEARCH_PRUNING_ALL & ~SEARCH_NULL_MOVE)
+#include "search_config.h"
+
+#define SEARCH_CONFIG_NAME no_lmr
+#define SEARCH_CONFIG_PRUNING (SEARCH_PRUNING_ALL & ~SEARCH_LATE_REDUCTIONS)
+#include "search_config.h"
+
+#define SEARCH_CONFIG_NAME no_rfp
+#define SEARCH_CONFIG_PRUNING (SEARCH_PRUNING_ALL & ~SEARCH_REVERSE_FUTILITY)
+#include "search_config.h"
+
+#define SEARCH_CONFIG_NAME no_fp
+#define SEARCH_CONFIG_PRUNING (SEARCH_PRUNING_ALL & ~SEARCH_FUTILITY)
+#include "search_config.h"
+
+#define SEARCH_CONFIG_NAME no_mdp
+#define SEARCH_CONFIG_PRUNING (SEARCH_PRUNING_ALL & ~SEARCH_MATE_DISTANCE)
+#include "search_config.h"
+
+#define SEARCH_CONFIG_NAME no_history
+#define SEARCH_CONFIG_ORDERING SEARCH_ORDER_CAPTURES
+#include "search_config.h"
+
+#define SEARCH_CONFIG_NAME no_order
+#define SEARCH_CONFIG_ORDERING SEARCH_ORDER_NONE
+#include "search_config.h"
+
+#define SEARCH_CONFIG_NAME tapered
+#define SEARCH_CONFIG_EVALUATION SCL_boardEvaluateTapered
+#include "search_config.h"
+
+#if SCL_NNUE
+#define SEARCH_CONFIG_NAME nnue
+#define SEARCH_CONFIG_EVALUATION SCL_boardEvaluateNNUE
+#include "search_config.h"
+#endif
+
+struct config {
+    const char* spec;
+    const search_config* search;
+    SCL_StaticEvaluationFunction eval;
+    uint8_t extra_depth;
+    SCL_SearchLimits limits;
+    std::atomic<uint64_t> nodes;
+    std::atomic<uint64_t> time_us;
+};
+
+config configs[2];
+int table_mb = 16;
+int max_games = 20000;
+double elo0 = 0, elo1 = 5;
+
+std::mutex opening_mutex;
+std::vector<std::string> game_openings; // opening of each pair of games, made in order
+std::set<std::string> used_openings;
+
+std::atomic<int> next_game(0);
+std::atomic<bool> stop_match(false);
+std::mutex result_mutex;
+int wins = 0, draws = 0, losses = 0; // from B's point of view
+
+double time_ms() {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t time_function() {
+    return (uint32_t)time_ms();
+}
+
+// Thread safe strtok, returns the next token of *rest (or 0) and moves *rest past it.
+char* next_token(char** rest, const char* separators) {
+    char* token = *rest + strspn(*rest, separators);
+
+    if (*token == 0) {
+        return 0;
+    }
+
+    char* end = token + strcspn(token, separators);
+    *rest = *end ? end + 1 : end;
+    *end = 0;
+
+    return token;
+}
+
+bool parse_config(config* c, const char* spec) {
+    char buffer[256];
+    strncpy(buffer, spec, sizeof(buffer) - 1);
+    buffer[sizeof(buffer) - 1] = 0;
+
+    c->spec = spec;
+    c->search = search_config_find("full");
+    c->eval = SCL_boardEvaluateStatic;
+    c->extra_depth = 3;
+    memset(&c->limits, 0, sizeof(c->limits));
+    c->limits.nodes = 20000;
+    c->limits.timeFunction = time_function;
+
+    char* rest = buffer;
+
+    for (char* item = next_token(&rest, ","); item; item = next_token(&rest, ",")) {
+        char* value = strchr(item, '=');
+
+        if (!value) {
+            return false;
+        }
+
+        *value++ = 0;
+
+        if (strcmp(item, "eval") == 0) {
+            c->eval = 0;
+
+            for (size_t i = 0; i < sizeof(evaluations) / sizeof(evaluations[0]); i++) {
+                if (strcmp(value, evaluations[i].name) == 0) {
+                    c->eval = evaluations[i].function;
+                }
+            }
+
+            if (!c->eval) {
+                return false;
+            }
+        } else if (strcmp(item, "ext") == 0) {
+            c->extra_depth = atoi(value);
+        } else if (strcmp(item, "nodes") == 0) {
+            c->limits.nodes = atoi(value);
+        } else if (strcmp(item, "time") == 0) {
+            c->limits.time = atoi(value);
+        } else if (strcmp(item, "depth") == 0) {
+            c->limits.depth = atoi(value);
+        } else if (strcmp(item, "search") == 0) {
+            c->search = search_config_find(value);
+
+            if (!c->search) {
+                return false;
+            }
+        } else {
+            return false;
+        }
+    }
+
+    return c->search->evaluation == 0 || strstr(spec, "eval=") == 0; // a fixed evaluation can't be changed
+}
+
+void play_opening(SCL_Game* game, const char* opening) {
+    char moves[256];
+    char* rest = moves;
+
+    SCL_gameInit(game, 0);
+    strncpy(moves, opening, sizeof(moves) - 1);
+    moves[sizeof(moves) - 1] = 0;
+
+    for (char* move = next_token(&rest, " "); move; move = next_token(&rest, " ")) {
+        uint8_t from, to;
+        char promotion;
+
+        SCL_stringToMove(move, &from, &to, &promotion);
+        SCL_gameMakeMove(game, from, to, promotion);
+    }
+}
+
+thread_local uint64_t opening_random_state;
+
+uint8_t opening_random() { // splitmix64, the library's generators have too short periods
+    uint64_t r = (opening_random_state += 0x9e3779b97f4a7c15ULL);
+    r = (r ^ (r >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    r = (r ^ (r >> 27)) * 0x94d049bb133111ebULL;
+    return (uint8_t)((r ^ (r >> 31)) >> 56);
+}
+
+// Makes the opening of each pair of games up to the pair, in order so that it doesn't depend on which thread
+// comes first: a line of the set plus RANDOM_OPENING_PLY moves of a randomized depth 2 search, which are drawn
+// again while the opening has already been played.
+std::string get_opening(int pair) {
+    std::lock_guard<std::mutex> lock(opening_mutex);
+    const int opening_count = sizeof(openings) / sizeof(openings[0]);
+    SCL_TranspositionTable no_table = {};
+
+    SCL_transpositionTable = no_table; // stored results would make the moves depend on earlier searches
+
+    while ((int)game_openings.size() <= pair) {
+        int k = (int)game_openings.size();
+        std::string opening;
+
+        for (int attempt = 0; attempt < OPENING_ATTEMPTS; attempt++) {
+            SCL_Game game;
+
+            opening = openings[k % opening_count];
+            opening_random_state = ((uint64_t)k << 16) + attempt;
+            play_opening(&game, opening.c_str());
+
+            for (int i = 0; i < RANDOM_OPENING_PLY && game.state == SCL_GAME_STATE_PLAYING; i++) {
+                uint8_t from, to;
+                char promotion, move[8];
+
+                SCL_getAIMove(game.board, 2, 2, 0, SCL_boardEvaluateStatic, opening_random, 2, 255, 255, &from, &to,
+                              &promotion);
+                SCL_moveToString(game.board, from, to, promotion, move);
+                SCL_gameMakeMove(&game, from, to, promotion);
+                opening = opening + " " + move;
+            }
+
+            if (game.state == SCL_GAME_STATE_PLAYING && used_openings.count(opening) == 0) {
+                break;
+            }
+        }
+
+        used_openings.insert(opening);
+        game_openings.push_back(opening);
+    }
+
+    return game_openings[pair];
+}
+
+// plays one game, returns its state (SCL_GAME_STATE_*), tables are white's and black's (of their searches)
+uint8_t play_game(const char* opening, config* white, config* black, void** tables) {
+    SCL_Game game;
+
+    play_opening(&game, opening);
+
+    while (game.state == SCL_GAME_STATE_PLAYING && game.ply < MAX_GAME_PLY) {
+        int side = SCL_boardWhitesTurn(game.board) ? 0 : 1;
+        config* c = side == 0 ? white : black;
+        uint8_t rs0, rs1, from, to;
+        char promotion;
+
+        SCL_gameGetRepetiotionMove(&game, &rs0, &rs1);
+
+        c->search->table_swap(tables[side]); // each player has its own table
+
+        double start = time_ms();
+        c->search->get_move(game.board, &c->limits, c->extra_depth, c->eval, 0, 0, rs0, rs1, 0, &from, &to,
+                            &promotion);
+        c->time_us += (uint64_t)((time_ms() - start) * 1000);
+        c->nodes += c->search->searched_nodes(); // also the unfinished last iteration, which the time includes
+
+        c->search->table_swap(tables[side]);
+
+        SCL_gameMakeMove(&game, from, to, promotion);
+    }
+
+    return game.state;
+}
+
+// log likelihood ratio of B being elo1 vs elo0 stronger (GSPRT on game results)
+double sprt_llr(int w, int d, int l) {
+    double n = w + d + l;
+
+    if (n == 0) {
+        return 0;
+    }
+
+    double score = (w + 0.5 * d) / n;
+    double variance = (w * (1 - score) * (1 - score) + d * (0.5 - score) * (0.5 - score) + l * score * score) / n;
+
+    if (variance == 0) {
+        // all games have the same result, estimate the variance with half a win and half a loss more
+        double score2 = (w + 0.5 + 0.5 * d) / (n + 1);
+
+        variance = ((w + 0.5) * (1 - score2) * (1 - score2) + d * (0.5 - score2) * (0.5 - score2) +
+                    (l + 0.5) * score2 * score2) / (n + 1);
+    }
+
+    double s0 = 1 / (1 + pow(10, -elo0 / 400));
+    double s1 = 1 / (1 + pow(10, -elo1 / 400));
+
+    return n * (s1 - s0) * (2 * score - s0 - s1) / (2 * variance);
+}
+
+double score_to_elo(double score) {
+    if (score <= 0) return -999;
+    if (score >= 1) return 999;
+    return -400 * log10(1 / score - 1);
+}
+
+void print_result(int w, int d, int l, double llr, double bound) {
+    double n = w + d + l;
+    double score = (w + 0.5 * d) / n;
+    double variance = (w * (1 - score) * (1 - score) + d * (0.5 - score) * (0.5 - score) + l * score * score) / n;
+    double margin = 1.96 * sqrt(variance / n);
+    double elo = score_to_elo(score);
+
+    printf("  %5d games  +%d =%d -%d  elo %+.1f +- %.1f  LLR %.2f (%.2f, %.2f)\n", w + d + l, w, d, l, elo,
+           (score_to_elo(score + margin) - score_to_elo(score - margin)) / 2, llr, -bound, bound);
+    fflush(stdout);
+}
+
+void worker() {
+    void* tables[2]; // A's and B's
+
+    for (int i = 0; i < 2; i++) {
+        tables[i] = configs[i].search->table_new(table_mb);
+    }
+
+    while (!stop_match) {
+        int i = next_game++;
+
+        if (i >= max_games) {
+            break;
+        }
+
+        // B plays white in odd games
+        bool b_white = i % 2;
+        std::string opening = get_opening(i / 2);
+
+        void* game_tables[2] = { tables[b_white ? 1 : 0], tables[b_white ? 0 : 1] };
+
+        for (int j = 0; j < 2; j++) {
+            configs[j].search->table_clear(tables[j]);
+        }
+
+        uint8_t state = play_game(opening.c_str(), &configs[b_white ? 1 : 0], &configs[b_white ? 0 : 1], game_tables);
+
+        bool white_won = state == SCL_GAME_STATE_WHITE_WIN;
+        bool black_won = state == SCL_GAME_STATE_BLACK_WIN;
+
+        std::lock_guard<std::mutex> lock(result_mutex);
+
+        if (stop_match) {
+            break; // decided meanwhile, keep the result the decision was made on
+        }
+
+        if ((white_won && b_white) || (black_won && !b_white)) {
+            wins++;
+        } else if (white_won || black_won) {
+            losses++;
+        } else {
+            draws++;
+        }
+
+        double llr = sprt_llr(wins, draws, losses);
+        double bound = log((1 - 0.05) / 0.05); // alpha = beta = 0.05
+
+        if (llr >= bound || llr <= -bound) {
+            stop_match = true;
+        }
+
+        int games = wins + draws + losses;
+
+        if (games % 20 == 0 && games < max_games && !stop_match) { // main prints the final result
+            print_result(wins, draws, losses, llr, bound);
+        }
+    }
+
+    for (int i = 0; i < 2; i++) {
+        configs[i].search->table_delete(tables[i]);
+    }
+}
+
+int main(int argc, char** argv) {
+    int threads = std::thread::hardware_concurrency();
+    const char* specs[2] = { "eval=static", "eval=static" };
+    int spec_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            max_games = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-hash") == 0 && i + 1 < argc) {
+            table_mb = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-elo") == 0 && i + 2 < argc) {
+            elo0 = atof(argv[++i]);
+            elo1 = atof(argv[++i]);
+        } else if (argv[i][0] != '-' && spec_count < 2) {
+            specs[spec_count++] = argv[i];
+        } else {
+            spec_count = -1;
+            break;
+        }
+    }
+
+    if (spec_count < 0 || !parse_config(&configs[0], specs[0]) || !parse_config(&configs[1], specs[1])) {
+        printf("usage: %s [-g GAMES] [-t THREADS] [-hash MB] [-elo ELO0 ELO1] [CONFIG_A [CONFIG_B]]\n"
+               "  config: comma separated eval=static|tapered|material|nnue, ext=N (extension depth), nodes=N,\n"
+               "  time=MS, depth=N (per move), search=NAME, default eval=static,ext=3,nodes=20000,search=full\n"
+               "  searches:", argv[0]);
+
+        for (int i = 0; i < search_config_count; i++) {
+            printf(" %s", search_configs[i].name);
+
+            if (search_configs[i].evaluation) {
+                printf(" (%s, no eval=)", search_configs[i].evaluation);
+            }
+        }
+
+        printf("\n");
+        return 1;
+    }
+
+    if (threads < 1) {
+        threads = 1;
+    }
+
+    SCL_init(); // for the openings
+
+    for (int i = 0; i < search_config_count; i++) {
+        search_configs[i].init();
+    }
+
+    printf("A: %s\nB: %s\nup to %d games on %d threads, SPRT elo0 %.1f elo1 %.1f\n", configs[0].spec,
+           configs[1].spec, max_games, threads, elo0, elo1);
+
+    double start = time_ms();
+    std::vector<std::thread> workers;
+
+    for (int i = 0; i < threads; i++) {
+        workers.push_back(std::thread(worker));
+    }
+
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
+
+    double llr = sprt_llr(wins, draws, losses);
+    double bound = log((1 - 0.05) / 0.05);
+
+    printf("result after %.1f s (B vs A):\n", (time_ms() - start) / 1000);
+
+    if (wins + draws + losses > 0) {
+        print_result(wins, draws, losses, llr, bound);
+    }
+
+    printf("  SPRT: %s\n", llr >= bound ? "H1 accepted (B is stronger)" :
+           (llr <= -bound ? "H0 accepted (B is not stronger)" : "inconclusive"));
+
+    for (int i = 0; i < 2; i++) {
+        config* c = &configs[i];
+        printf("  %c: %llu nodes %.1f s %.0f nps\n", 'A' + i, (unsigned long long)c->nodes,
+               c->time_us / 1e6, c->time_us ? c->nodes * 1e6 / c->time_us : 0.0);
+    }
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+// Move generation test and benchmark, build with build.sh. Without arguments
+// runs the perft suite and exits with 1 if any count is wrong, which makes it
+// the check to run after every change to the move generator.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+#include "smallchesslib.h"
+
+struct perft_test {
+    const char* name;
+    const char* fen;      // 0 means chess960 start position
+    uint16_t number_960;
+    uint8_t depth;
+    uint64_t nodes;
+};
+
+#if !SCL_960_CASTLING
+perft_test tests[] = {
+    { "start",    SCL_FEN_START, 0, 5, 4865609 },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 0, 4, 4085603 },
+    { "pos3",     "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 0, 6, 11030083 },
+    { "pos4",     "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 0, 5, 15833292 },
+    { "pos5",     "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 0, 4, 2103487 },
+    { "pos6",     "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 0, 4, 3894594 },
+};
+#else
+// counts checked against a pseudo-legal generator with a check filter
+perft_test tests[] = {
+    { "960 #0",   0, 0,   5, 4975808 },
+    { "960 #1",   0, 1,   5, 4863733 },
+    { "960 #2",   0, 2,   5, 4916733 },
+    { "960 #100", 0, 100, 5, 4958510 },
+    { "960 #359", 0, 359, 5, 3891511 },
+    { "960 #518", 0, 518, 5, 4865609 },
+    { "960 #687", 0, 687, 5, 5003601 },
+    { "960 #959", 0, 959, 5, 4973573 },
+};
+#endif
+
+void put_char(char c) {
+    putchar(c);
+}
+
+double time_ms() {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void load_position(SCL_Position* position, const char* fen, uint16_t number_960) {
+    if (fen) {
+        SCL_positionFromFEN(position, fen);
+    } else {
+        SCL_Board board;
+        SCL_boardInit960(board, number_960);
+        SCL_positionFromBoard(position, board);
+    }
+}
+
+int run_suite(bool bulk) {
+    int failed = 0;
+    uint64_t total_nodes = 0;
+    double total_time = 0;
+
+    printf("%s counting\n", bulk ? "bulk" : "full");
+
+    for (size_t i = 0; i < sizeof(tests) / sizeof(tests[0]); i++) {
+        perft_test* test = &tests[i];
+        SCL_Position position;
+
+        load_position(&position, test->fen, test->number_960);
+
+        double start = time_ms();
+        uint64_t nodes = SCL_positionPerft(&position, test->depth, bulk);
+        double time = time_ms() - start;
+
+        bool ok = nodes == test->nodes;
+
+        if (!ok) {
+            failed++;
+        }
+
+        total_nodes += nodes;
+        total_time += time;
+
+        printf("  %-10s depth %d %12llu nodes %9.1f ms %8.2f Mnps  %s\n", test->name, test->depth,
+               (unsigned long long)nodes, time, nodes / (time * 1000.0), ok ? "OK" : "FAILED");
+    }
+
+    printf("  total %llu nodes %.1f ms %.2f Mnps\n", (unsigned long long)total_nodes, total_time,
+           total_nodes / (total_time * 1000.0));
+
+    return failed;
+}
+
+int divide(int depth, const char* position_string, bool bulk) {
+    SCL_Position position;
+    char* end;
+    long number_960 = strtol(position_string, &end, 10);
+
+    if (*end == 0 && number_960 >= 0 && number_960 < 960) {
+        load_position(&position, 0, number_960);
+    } else if (!SCL_positionFromFEN(&position, position_string)) {
+        printf("bad FEN: %s\n", position_string);
+        return 1;
+    }
+
+    double start = time_ms();
+    uint64_t nodes = SCL_positionPerftDivide(&position, depth, bulk, put_char);
+    double time = time_ms() - start;
+
+    printf("\nnodes %llu time %.1f ms %.2f Mnps\n", (unsigned long long)nodes, time,
+           nodes / (time * 1000.0));
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    SCL_init();
+
+    if (argc >= 3 && strcmp(argv[1], "divide") == 0) {
+        return divide(atoi(argv[2]), argc >= 4 ? argv[3] : SCL_FEN_START, true);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "bulk") == 0) {
+        return run_suite(true) != 0;
+    }
+
+    if (argc >= 2) {
+        printf("usage: %s [bulk | divide DEPTH [FEN | CHESS960 NUMBER]]\n", argv[0]);
+        printf("  without arguments runs the perft suite with full and bulk counting\n");
+        return 1;
+    }
+
+    int failed = run_suite(false);
+    failed += run_suite(true);
+
+    if (failed) {
+        printf("%d FAILED\n", failed);
+    }
+
+    return failed != 0;
+}
@@ -0,0 +1,246 @@
+// Compile time specialized AI searches, so that a program can keep differently
+// configured AIs (e.g. to compare them in a match) without the search checking
+// runtime switches in every node. Each configuration is another copy of
+// smallchesslib.h in its own namespace, compiled with its evaluation function
+// (SCL_EVALUATION_FUNCTION), move ordering and pruning features fixed, so the
+// compiler inlines the evaluation and leaves out the unused code. A registry of
+// the configurations picks one at runtime by name.
+//
+// Include after smallchesslib.h, once for each configuration:
+//
+//   #define SEARCH_CONFIG_NAME tapered_no_lmr   // namespace and registry name
+//   #define SEARCH_CONFIG_EVALUATION SCL_boardEvaluateTapered
+//   #define SEARCH_CONFIG_ORDERING SEARCH_ORDER_CAPTURES
+//   #define SEARCH_CONFIG_PRUNING (SEARCH_PRUNING_ALL & ~SEARCH_LATE_REDUCTIONS)
+//   #include "search_config.h"
+//
+// All but the name are optional: without an evaluation each search is given
+// one, the ordering defaults to SEARCH_ORDER_ALL and the pruning to
+// SEARCH_PRUNING_ALL. Other compile time options are the same as those of the
+// program's smallchesslib.h.
+//
+// Each copy has its own global state (precomputed tables, evaluation cache,
+// NNUE network), so call init of every configuration before searching with it
+// and before starting threads, it also copies the program's NNUE network. The
+// program's evaluation functions given to a search are replaced by the copy's
+// ones. A search uses the transposition table swapped in with table_swap on its
+// thread, there is none otherwise.
+
+#ifndef SEARCH_CONFIG_H
+#define SEARCH_CONFIG_H
+
+#include <stdlib.h>
+#include <string.h>
+
+// move ordering policies (SCL_ORDER_MOVES, SCL_QUIET_MOVE_ORDERING)
+#define SEARCH_ORDER_NONE 0     // only the hash move first
+#define SEARCH_ORDER_CAPTURES 1 // then captures by MVV-LVA, quiet moves unordered
+#define SEARCH_ORDER_ALL 2      // then killers, countermove and history ordered quiet moves
+
+// pruning features, combined with |
+#define SEARCH_NULL_MOVE 0x01         // SCL_NULL_MOVE_PRUNING
+#define SEARCH_LATE_REDUCTIONS 0x02   // SCL_LATE_MOVE_REDUCTIONS
+#define SEARCH_REVERSE_FUTILITY 0x04  // SCL_REVERSE_FUTILITY_PRUNING
+#define SEARCH_FUTILITY 0x08          // SCL_FUTILITY_PRUNING
+#define SEARCH_MATE_DISTANCE 0x10     // SCL_MATE_DISTANCE_PRUNING
+#define SEARCH_PRUNING_ALL 0x1f
+
+#define SEARCH_CONFIG_MAX 32
+
+struct search_config {
+    const char* name;
+    const char* evaluation; // name of the fixed evaluation function, 0 if each search is given one
+    void (*init)();
+    int16_t (*get_move)(SCL_Board board, const SCL_SearchLimits* limits, uint8_t extra_depth,
+                        SCL_StaticEvaluationFunction evaluation, SCL_RandomFunction random, uint8_t randomness,
+                        uint8_t repetition_from, uint8_t repetition_to, SCL_SearchInfoFunction info_function,
+                        uint8_t* from, uint8_t* to, char* promotion); // SCL_getAIMoveIterative
+    uint64_t (*searched_nodes)(); // SCL_searchNodes of the last search on this thread
+    void* (*table_new)(uint16_t size_mb);
+    void (*table_delete)(void* table);
+    void (*table_clear)(void* table);
+    void (*table_swap)(void* table); // exchanges the table with the one searches on this thread use
+};
+
+search_config search_configs[SEARCH_CONFIG_MAX];
+int search_config_count = 0;
+
+int search_config_add(const search_config& config) {
+    if (search_config_count < SEARCH_CONFIG_MAX) {
+        search_configs[search_config_count++] = config;
+    }
+
+    return search_config_count;
+}
+
+const search_config* search_config_find(const char* name) {
+    for (int i = 0; i < search_config_count; i++) {
+        if (strcmp(search_configs[i].name, name) == 0) {
+            return &search_configs[i];
+        }
+    }
+
+    return 0;
+}
+
+#define _SEARCH_CONFIG_STRING2(x) #x
+#define _SEARCH_CONFIG_STRING(x) _SEARCH_CONFIG_STRING2(x)
+
+#endif // SEARCH_CONFIG_H
+
+#ifndef SEARCH_CONFIG_NAME
+#error SEARCH_CONFIG_NAME has to be defined before including search_config.h.
+#endif
+
+#ifndef SEARCH_CONFIG_ORDERING
+#define SEARCH_CONFIG_ORDERING SEARCH_ORDER_ALL
+#endif
+
+#ifndef SEARCH_CONFIG_PRUNING
+#define SEARCH_CONFIG_PRUNING SEARCH_PRUNING_ALL
+#endif
+
+// the options of this copy replace the program's ones until it is compiled
+
+#pragma push_macro("SMALLCHESSLIB_H")
+#pragma push_macro("SCL_EVALUATION_FUNCTION")
+#pragma push_macro("SCL_ORDER_MOVES")
+#pragma push_macro("SCL_QUIET_MOVE_ORDERING")
+#pragma push_macro("SCL_NULL_MOVE_PRUNING")
+#pragma push_macro("SCL_LATE_MOVE_REDUCTIONS")
+#pragma push_macro("SCL_REVERSE_FUTILITY_PRUNING")
+#pragma push_macro("SCL_FUTILITY_PRUNING")
+#pragma push_macro("SCL_MATE_DISTANCE_PRUNING")
+
+#undef SMALLCHESSLIB_H
+#undef SCL_EVALUATION_FUNCTION
+#undef SCL_ORDER_MOVES
+#undef SCL_QUIET_MOVE_ORDERING
+#undef SCL_NULL_MOVE_PRUNING
+#undef SCL_LATE_MOVE_REDUCTIONS
+#undef SCL_REVERSE_FUTILITY_PRUNING
+#undef SCL_FUTILITY_PRUNING
+#undef SCL_MATE_DISTANCE_PRUNING
+
+#ifdef SEARCH_CONFIG_EVALUATION
+#define SCL_EVALUATION_FUNCTION SEARCH_CONFIG_EVALUATION
+#endif
+
+#define SCL_ORDER_MOVES (SEARCH_CONFIG_ORDERING != SEARCH_ORDER_NONE)
+#define SCL_QUIET_MOVE_ORDERING (SEARCH_CONFIG_ORDERING == SEARCH_ORDER_ALL)
+#define SCL_NULL_MOVE_PRUNING ((SEARCH_CONFIG_PRUNING & SEARCH_NULL_MOVE) != 0)
+#define SCL_LATE_MOVE_REDUCTIONS ((SEARCH_CONFIG_PRUNING & SEARCH_LATE_REDUCTIONS) != 0)
+#define SCL_REVERSE_FUTILITY_PRUNING ((SEARCH_CONFIG_PRUNING & SEARCH_REVERSE_FUTILITY) != 0)
+#define SCL_FUTILITY_PRUNING ((SEARCH_CONFIG_PRUNING & SEARCH_FUTILITY) != 0)
+#define SCL_MATE_DISTANCE_PRUNING ((SEARCH_CONFIG_PRUNING & SEARCH_MATE_DISTANCE) != 0)
+
+namespace SEARCH_CONFIG_NAME {
+
+#include "smallchesslib.h"
+
+static_assert(sizeof(SCL_SearchLimits) == sizeof(::SCL_SearchLimits), "search limits differ");
+static_assert(sizeof(SCL_SearchInfo) == sizeof(::SCL_SearchInfo), "search info differs");
+
+// The copy's types are distinct from the program's ones but the same structs.
+
+thread_local ::SCL_SearchInfoFunction config_info_function;
+
+void config_info(const SCL_SearchInfo* info) {
+    ::SCL_SearchInfo copy;
+    memcpy(&copy, info, sizeof(copy));
+    config_info_function(&copy);
+}
+
+void config_init() {
+    SCL_init();
+    SCL_transpositionTableInit(&SCL_transpositionTable, 0); // tables come from table_swap
+#if SCL_NNUE
+    static_assert(sizeof(SCL_nnueNetwork) == sizeof(::SCL_nnueNetwork), "NNUE networks differ");
+    memcpy(&SCL_nnueNetwork, &::SCL_nnueNetwork, sizeof(SCL_nnueNetwork));
+#endif
+}
+
+int16_t config_get_move(SCL_Board board, const ::SCL_SearchLimits* limits, uint8_t extra_depth,
+                        SCL_StaticEvaluationFunction evaluation, SCL_RandomFunction random, uint8_t randomness,
+                        uint8_t repetition_from, uint8_t repetition_to, ::SCL_SearchInfoFunction info_function,
+                        uint8_t* from, uint8_t* to, char* promotion) {
+    SCL_SearchLimits copy;
+    memcpy(&copy, limits, sizeof(copy));
+    config_info_function = info_function;
+
+    // the search only recognizes this copy's evaluations and computes them incrementally
+    if (evaluation == ::SCL_boardEvaluateTapered) {
+        evaluation = SCL_boardEvaluateTapered;
+    } else if (evaluation == ::SCL_boardEvaluateStatic) {
+        evaluation = SCL_boardEvaluateStatic;
+    }
+#if SCL_NNUE
+    else if (evaluation == ::SCL_boardEvaluateNNUE) {
+        evaluation = SCL_boardEvaluateNNUE;
+    }
+#endif
+
+    return SCL_getAIMoveIterative(board, &copy, extra_depth, evaluation, random, randomness, repetition_from,
+                                  repetition_to, info_function ? config_info : 0, from, to, promotion);
+}
+
+uint64_t config_searched_nodes() {
+    return SCL_searchNodes;
+}
+
+void* config_table_new(uint16_t size_mb) {
+    SCL_TranspositionTable* table = (SCL_TranspositionTable*)calloc(1, sizeof(SCL_TranspositionTable));
+
+    if (table) {
+        SCL_transpositionTableInit(table, size_mb);
+    }
+
+    return table;
+}
+
+void config_table_delete(void* table) {
+    if (table) {
+        SCL_transpositionTableInit((SCL_TranspositionTable*)table, 0);
+        free(table);
+    }
+}
+
+void config_table_clear(void* table) {
+    SCL_transpositionTableClear((SCL_TranspositionTable*)table);
+}
+
+void config_table_swap(void* table) {
+    SCL_TranspositionTable current = SCL_transpositionTable;
+    SCL_transpositionTable = *(SCL_TranspositionTable*)table;
+    *(SCL_TranspositionTable*)table = current;
+}
+
+const search_config config = {
+    _SEARCH_CONFIG_STRING(SEARCH_CONFIG_NAME),
+#ifdef SEARCH_CONFIG_EVALUATION
+    _SEARCH_CONFIG_STRING(SEARCH_CONFIG_EVALUATION),
+#else
+    0,
+#endif
+    config_init, config_get_move, config_searched_nodes, config_table_new, config_table_delete,
+    config_table_clear, config_table_swap,
+};
+
+int config_index = search_config_add(config);
+
+} // namespace SEARCH_CONFIG_NAME
+
+#pragma pop_macro("SMALLCHESSLIB_H")
+#pragma pop_macro("SCL_EVALUATION_FUNCTION")
+#pragma pop_macro("SCL_ORDER_MOVES")
+#pragma pop_macro("SCL_QUIET_MOVE_ORDERING")
+#pragma pop_macro("SCL_NULL_MOVE_PRUNING")
+#pragma pop_macro("SCL_LATE_MOVE_REDUCTIONS")
+#pragma pop_macro("SCL_REVERSE_FUTILITY_PRUNING")
+#pragma pop_macro("SCL_FUTILITY_PRUNING")
+#pragma pop_macro("SCL_MATE_DISTANCE_PRUNING")
+
+#undef SEARCH_CONFIG_NAME
+#undef SEARCH_CONFIG_EVALUATION
+#undef SEARCH_CONFIG_ORDERING
+#undef SEARCH_CONFIG_PRUNING
@@ -52,12 +52,35 @@
 
 typedef uint8_t (*SCL_RandomFunction)(void);
 
+#if defined(SCL_THREAD_LOCAL) && !defined(_SCL_THREAD_LOCAL_DEFAULT) && \
+  SCL_THREADS
+  // the helper threads would search with their own empty tables
+  #error SCL_THREAD_LOCAL is not to be combined with SCL_THREADS.
+#endif
+
+#ifndef SCL_THREAD_LOCAL
+  /**
+    Storage class of the global state that AI searches change (transposition
+    table, evaluation cache, pawn table, random generator state, evaluated
+    and searched positions counters). Defining it as thread_local
+    (_Thread_local in C11) gives every thread its own state so that more
+    threads can run independent searches at once, e.g. to play more games in
+    parallel. Each thread then has to set up its table with
+    SCL_transpositionTableInit. Not to be combined with SCL_THREADS, whose
+    search threads share one table.
+  */
+  #define SCL_THREAD_LOCAL
+  #define _SCL_THREAD_LOCAL_DEFAULT // not the user's, for including again
+#endif
+
 #if SCL_COUNT_EVALUATED_POSITIONS
-  uint32_t SCL_positionsEvaluated = 0; /**< If enabled by
+  SCL_THREAD_LOCAL uint32_t SCL_positionsEvaluated = 0; /**< If enabled by
                                             SCL_COUNT_EVALUATED_POSITIONS, this
                                             will increment with every
                                             dynamically evaluated position (e.g.
-                                            when AI computes its move). */
+                                            when AI computes its move), added
+                                            once the search and its threads
+                                            finish. */
 #endif
 
 #ifndef SCL_CALL_WDT_RESET
@@ -75,6 +98,15 @@ typedef uint8_t (*SCL_RandomFunction)(void);
                                 the program. */
 #endif
 
+#ifndef SCL_QUIET_MOVE_ORDERING
+  #define SCL_QUIET_MOVE_ORDERING 1 /**< If 1 (and SCL_ORDER_MOVES is 1), quiet
+                                         moves are ordered by the cutoffs they
+                                         caused before (killer moves,
+                                         countermoves and history), otherwise
+                                         they come in generation order after
+                                         captures. */
+#endif
+
 /**
   Returns a pseudorandom byte. This function has a period 256 and returns each
   possible byte value exactly once in the period.
@@ -109,6 +141,52 @@ void SCL_randomBetterSeed(uint16_t seed);
   #define SCL_960_CASTLING 0
 #endif
 
+#ifndef SCL_TRANSPOSITION_TABLE_SIZE
+  #define SCL_TRANSPOSITION_TABLE_SIZE 0 /**< Size in MB of the default
+                                            transposition table which AI uses
+                                            to not search the same position
+                                            again, allocated with malloc by
+                                            SCL_init (e.g. 16 for an engine).
+                                            0 means no table and no dynamic
+                                            memory allocation at all, so that
+                                            programs only using the board
+                                            functions (or running on Arduino)
+                                            don't pay for it. */
+#endif
+
+#if SCL_TRANSPOSITION_TABLE_SIZE != 0
+  #include <stdlib.h>
+#endif
+
+#ifndef SCL_EVALUATION_CACHE_SIZE
+  #define SCL_EVALUATION_CACHE_SIZE 16384 /**< Number of entries (a power of
+                                               two) of the evaluation cache
+                                               which keeps static evaluations
+                                               of searched positions so that a
+                                               slow evaluation function isn't
+                                               called again on the same
+                                               position, 8 bytes each in static
+                                               memory. 0 means no cache. */
+#endif
+
+#ifndef SCL_PAWN_TABLE_SIZE
+  #define SCL_PAWN_TABLE_SIZE 1024 /**< Number of entries (a power of two) of
+                                        the pawn table which caches the pawn
+                                        structure evaluation by pawn positions,
+                                        40 bytes each in static memory. 0 means
+                                        no table. */
+#endif
+
+#ifndef SCL_NNUE
+  /**
+    If set, the library includes an efficiently updatable neural network
+    (NNUE) evaluation, SCL_boardEvaluateNNUE. Positions then also keep the
+    first layer of the network updated with each move, and the network takes
+    about 400 KB of static memory.
+  */
+  #define SCL_NNUE 0
+#endif
+
 #ifndef SCL_ALPHA_BETA
   /**
     Turns alpha-beta pruning (AI optimization) on or off. This can gain
@@ -118,6 +196,97 @@ void SCL_randomBetterSeed(uint16_t seed);
   #define SCL_ALPHA_BETA 1
 #endif
 
+#ifndef SCL_SEARCH_NEGAMAX
+  /**
+    Selects the AI search algorithm. 1 is negamax alpha-beta search with
+    principal variation search, aspiration windows and repetition detection,
+    0 is an older simpler search that only uses one bound for alpha-beta
+    pruning, which is smaller but searches more positions.
+  */
+  #define SCL_SEARCH_NEGAMAX 1
+#endif
+
+#ifndef SCL_QUIESCENCE_CHECKS
+  /**
+    If 1, quiescence search (which the AI uses at the end of the searched depth
+    to not stop in the middle of exchanges) tries quiet moves giving check in
+    its first ply besides captures. This helps find mates at the cost of more
+    searched positions.
+  */
+  #define SCL_QUIESCENCE_CHECKS 0
+#endif
+
+/* The following options turn on selective search, i.e. searching moves that
+   are unlikely to matter less deep or not at all. Unlike alpha-beta pruning
+   this can change AI decisions (it can miss things), but the AI gets much
+   deeper in the same time, which makes it stronger overall. They only apply to
+   SCL_SEARCH_NEGAMAX search with SCL_ALPHA_BETA. */
+
+#ifndef SCL_NULL_MOVE_PRUNING
+  #define SCL_NULL_MOVE_PRUNING 1 /**< If 1, AI lets the opponent move twice in
+                                       a row with reduced depth and if it still
+                                       can't get below beta, the position is
+                                       cut off. This isn't tried without pieces
+                                       other than pawns as then having to move
+                                       is often a disadvantage (zugzwang). */
+#endif
+
+#ifndef SCL_LATE_MOVE_REDUCTIONS
+  #define SCL_LATE_MOVE_REDUCTIONS 1 /**< If 1, quiet moves late in the move
+                                          order are searched with less depth
+                                          (growing logarithmically with depth
+                                          and move number) and only searched
+                                          again fully if they turn out good. */
+#endif
+
+#ifndef SCL_REVERSE_FUTILITY_PRUNING
+  #define SCL_REVERSE_FUTILITY_PRUNING 1 /**< If 1, positions near the end of
+                                              the searched depth whose static
+                                              evaluation is above beta by a
+                                              margin are cut off without
+                                              search. */
+#endif
+
+#ifndef SCL_FUTILITY_PRUNING
+  #define SCL_FUTILITY_PRUNING 1 /**< If 1, quiet moves near the end of the
+                                      searched depth are skipped if the static
+                                      evaluation is below alpha by a margin
+                                      (they're unlikely to raise it). */
+#endif
+
+#ifndef SCL_MATE_DISTANCE_PRUNING
+  #define SCL_MATE_DISTANCE_PRUNING 1 /**< If 1, AI doesn't search positions in
+                                           which it can't find a shorter mate
+                                           than one it has already found. This
+                                           doesn't change AI decisions. */
+#endif
+
+#ifndef SCL_THREADS
+  /**
+    If 1, AI can search with more threads (see SCL_setThreads), using Windows
+    threads on Windows and POSIX threads elsewhere (link with -pthread). 0
+    keeps the library free of any threading and system headers, e.g. for
+    embedded platforms.
+  */
+  #define SCL_THREADS 0
+#endif
+
+#if SCL_THREADS
+  #include <stdlib.h>
+
+  #ifdef _WIN32
+    #include <windows.h>
+    typedef HANDLE _SCL_Thread;
+    typedef struct { CRITICAL_SECTION lock; } _SCL_Lock;
+    #define _SCL_THREAD_FUNCTION(name) DWORD WINAPI name(LPVOID data)
+  #else
+    #include <pthread.h>
+    typedef pthread_t _SCL_Thread;
+    typedef struct { pthread_mutex_t lock; } _SCL_Lock;
+    #define _SCL_THREAD_FUNCTION(name) void *name(void *data)
+  #endif
+#endif
+
 /**
   A set of game squares as a bit array, each bit representing one game square.
   Useful for representing e.g. possible moves. To easily iterate over the set
@@ -164,7 +333,7 @@ uint8_t SCL_squareSetGetRandom(const SCL_SquareSet squareSet,
   { command }\
   SCL_SQUARE_SET_ITERATE_END
 
-#define SCL_BOARD_STATE_SIZE 69
+#define SCL_BOARD_STATE_SIZE 77
 
 /**
   Represents chess board state as a string in this format:
@@ -196,8 +365,10 @@ uint8_t SCL_squareSetGetRandom(const SCL_SquareSet squareSet,
       the last pawn move or capture.
     - 67: Extra byte, left for storing additional info in variants. For normal
       chess this byte should always be 0.
-    - 68: The last byte is always 0 to properly terminate the string in case
-      someone tries to print it.
+    - 68: Always 0 to properly terminate the string in case someone tries to
+      print it.
+    - 69-76: 64 bit Zobrist key of the position (little endian), kept up to
+      date by the library functions, see SCL_boardKey.
   - The state is designed so as to be simple and also print-friendly, i.e. you
     can simply print it with line break after 8 characters to get a human
     readable representation of the board.
@@ -215,6 +386,7 @@ typedef char SCL_Board[SCL_BOARD_STATE_SIZE];
 #define SCL_BOARD_PLY_BYTE 65
 #define SCL_BOARD_MOVE_COUNT_BYTE 66
 #define SCL_BOARD_EXTRA_BYTE 67
+#define SCL_BOARD_KEY_BYTE 69
 
 #if SCL_960_CASTLING
   #define _SCL_EXTRA_BYTE_VALUE (0 | (7 << 3)) // rooks on classic positions
@@ -231,7 +403,9 @@ typedef char SCL_Board[SCL_BOARD_STATE_SIZE];
    46, 46, 46, 46, 46, 46, 46, 46,\
    112,112,112,112,112,112,112,112,\
    114,110,98, 113,107,98, 110,114,\
-   (char) 0xff,0,0,_SCL_EXTRA_BYTE_VALUE,0}
+   (char) 0xff,0,0,_SCL_EXTRA_BYTE_VALUE,0,\
+   (char) 0xf3,(char) 0xdc,(char) 0x46,(char) 0xed,\
+   (char) 0x27,(char) 0xd8,(char) 0x7a,(char) 0x2e}
 
 #define SCL_FEN_START \
   "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
@@ -263,6 +437,7 @@ typedef struct
   uint8_t other;           /**< lowest 7 bits: previous value of target square,
                                 highest bit: if 1 then the move was promotion or
                                 en passant */
+  uint64_t key;            ///< previous Zobrist key
 } SCL_MoveUndo;
 
 #define SCL_GAME_STATE_PLAYING         0x00
@@ -293,8 +468,26 @@ void SCL_boardInit960(SCL_Board board, uint16_t positionNumber);
 
 void SCL_boardDisableCastling(SCL_Board board);
 
+/**
+  Gets a 32 bit hash of the position, folded from its Zobrist key.
+*/
 uint32_t SCL_boardHash32(const SCL_Board board);
 
+/**
+  Gets the 64 bit Zobrist key of the position, which is stored in the board
+  state and updated by SCL_boardMakeMove and SCL_boardUndoMove, so it costs
+  nothing to get. The key covers the pieces, castling rights, en passant file
+  (only if en passant capture is actually possible) and the player to move,
+  but not the move counters.
+*/
+uint64_t SCL_boardKey(const SCL_Board board);
+
+/**
+  Recomputes the Zobrist key of the board. Library functions keep the key up to
+  date, this only has to be called after modifying the board state directly.
+*/
+void SCL_boardUpdateKey(SCL_Board board);
+
 #define SCL_PHASE_OPENING 0
 #define SCL_PHASE_MIDGAME 1
 #define SCL_PHASE_ENDGAME 2
@@ -361,7 +554,8 @@ int16_t SCL_boardEvaluateStatic(SCL_Board board);
   Dynamic evaluation function (search), i.e. unlike SCL_boardEvaluateStatic,
   this one performs a recursive search for deeper positions to get a more
   accurate score. Of course, this is much slower and hugely dependent on
-  baseDepth (you mostly want to keep this under 5).
+  baseDepth (you mostly want to keep this under 5). extensionExtraDepth is the
+  same as in SCL_getAIMove.
 */
 int16_t SCL_boardEvaluateDynamic(SCL_Board board, uint8_t baseDepth,
   uint8_t extensionExtraDepth, SCL_StaticEvaluationFunction evalFunction);
@@ -378,7 +572,7 @@ uint8_t SCL_boardDead(SCL_Board board);
 /**
   Tests whether given player is in check.
 */
-uint8_t SCL_boardCheck(SCL_Board board, uint8_t white);
+uint8_t SCL_boardCheck(const SCL_Board board, uint8_t white);
 
 /**
   Checks whether given move resets the move counter (used in the 50 move rule).
@@ -425,9 +619,10 @@ uint8_t SCL_boardGetPosition(SCL_Board board);
 /**
   Returns 1 if the square is attacked by player of given color. This is used to
   examine checks, so for performance reasons the functions only checks whether
-  or not the square is attacked (not the number of attackers).
+  or not the square is attacked (not the number of attackers). The board isn't
+  modified, so this can be called from multiple threads at once.
 */
-uint8_t SCL_boardSquareAttacked(SCL_Board board, uint8_t square,
+uint8_t SCL_boardSquareAttacked(const SCL_Board board, uint8_t square,
   uint8_t byWhite);
 
 /**
@@ -638,8 +833,10 @@ int16_t SCL_pieceValuePositive(char piece);
   return value is the value of the move (with the same semantics as the value
   of an evaluation function). baseDepth is depth in plys to which all moves will
   be checked. If baseDepth 0 is passed, the function makes a random move and
-  returns the evaluation of the board. extensionExtraDepth is extra depth for
-  checking specific situations like exchanges and checks. endgameExtraDepth is
+  returns the evaluation of the board. extensionExtraDepth is the maximum depth
+  of quiescence search which after baseDepth only searches captures (so that
+  AI doesn't e.g. take a defended piece with a queen), 0 means positions at
+  baseDepth are just statically evaluated. endgameExtraDepth is
   extra depth which is added to baseDepth in the endgame. If the randomness
   function is 0, AI will always make the first best move it finds, if it is
   not 0 and randomness is 0, AI will randomly pick between the equally best
@@ -734,2173 +931,7062 @@ static inline char *SCL_squareToString(uint8_t square, char *string);
 */
 uint8_t SCL_stringToSquare(const char *square);
 
-//=============================================================================
-// privates:
+/**
+  Set of squares as a 64 bit number, bit N representing square N (i.e. A1 is
+  the least significant bit, H8 the most significant one). This is the same
+  layout as SCL_SquareSet, but bitboards allow fast move generation with bit
+  operations.
+*/
+typedef uint64_t SCL_Bitboard;
+
+#define SCL_BITBOARD_EMPTY ((SCL_Bitboard) 0)
+#define SCL_BITBOARD_SQUARE(s) (((SCL_Bitboard) 1) << (s))
+
+#define SCL_PIECE_PAWN   0
+#define SCL_PIECE_KNIGHT 1
+#define SCL_PIECE_BISHOP 2
+#define SCL_PIECE_ROOK   3
+#define SCL_PIECE_QUEEN  4
+#define SCL_PIECE_KING   5
+#define SCL_PIECE_NONE   6
+
+#if SCL_NNUE
+#ifndef SCL_NNUE_HIDDEN
+  #define SCL_NNUE_HIDDEN 64 /**< Number of neurons of the NNUE hidden layer of
+                                  each perspective, a multiple of 32. */
+#endif
 
-#define SCL_UNUSED(v) (void)(v)
+#if SCL_NNUE_HIDDEN % 32 != 0 || SCL_NNUE_HIDDEN < 32
+  #error SCL_NNUE_HIDDEN has to be a multiple of 32 (the SIMD block size).
+#endif
 
-uint8_t SCL_currentRandom8 = 0;
+#define SCL_NNUE_KING_BUCKETS 4
 
-uint16_t SCL_currentRandom16 = 0;
+/**
+  Number of NNUE input features of one perspective: each piece (own and the
+  opponent's) on each square for each bucket of the own king's square.
+*/
+#define SCL_NNUE_FEATURES (SCL_NNUE_KING_BUCKETS * 12 * SCL_BOARD_SQUARES)
 
-void SCL_randomSimpleSeed(uint8_t seed)
+/**
+  Accumulator of NNUE evaluation, the hidden layer of the network computed for
+  the pieces of a position from white's and black's perspective, which is
+  updated by each move instead of being computed again.
+*/
+typedef struct
 {
-  SCL_currentRandom8 = seed;
-}
+  int16_t values[2][SCL_NNUE_HIDDEN]; ///< white's (0) and black's (1) view
+  uint8_t buckets[2];         ///< king buckets the values are computed for
+  uint8_t stale[2];           /**< perspectives to be computed from scratch,
+                                   set when the king changes its bucket */
+  uint8_t active;             /**< 0 until the accumulator is first computed,
+                                   moves only update it after that */
+} SCL_NNUEAccumulator;
+#endif
 
-uint8_t SCL_randomSimple(void)
+/**
+  Chess position represented by bitboards. This is an optional alternative to
+  SCL_Board meant for fast move generation and search. The position contains
+  SCL_Board which is always kept in sync with the bitboards, so all SCL_board*
+  functions that don't modify the board can be used on it directly, but the
+  position has to only be modified with SCL_position* functions.
+*/
+typedef struct
 {
-  SCL_currentRandom8 *= 13;
-  SCL_currentRandom8 += 7;
-  return SCL_currentRandom8;
-}
+  SCL_Board board;
+  SCL_Bitboard pieces[6];     ///< pieces of both colors, by SCL_PIECE_* type
+  SCL_Bitboard colors[2];     ///< all white (index 0) and black (1) pieces
+  SCL_Bitboard occupied;      ///< all pieces
+  int16_t score[2];           /**< tapered material and piece-square score of
+                                   the opening (index 0) and endgame (1),
+                                   positive favoring white */
+  uint8_t phase;              ///< 24 at the start, 0 with no pieces but pawns
+  uint64_t pawnKey;           ///< Zobrist key of just the pawns
+#if SCL_NNUE
+  SCL_NNUEAccumulator nnue;
+#endif
+} SCL_Position;
 
-uint8_t SCL_randomBetter(void)
+/**
+  Holds an info required to undo a move made with SCL_positionMakeMove.
+*/
+typedef struct
 {
-  SCL_currentRandom16 *= 13;
-  SCL_currentRandom16 += 7;
-  return (SCL_currentRandom16 % 256) ^ (SCL_currentRandom16 / 256);
-}
+  SCL_MoveUndo boardUndo;
+  uint8_t squares[4];         ///< squares changed by the move
+  uint8_t squareCount;
+} SCL_PositionUndo;
 
-void SCL_randomBetterSeed(uint16_t seed)
-{
-  SCL_currentRandom16 = seed;
-}
+/**
+  Initializes the library's precomputed tables. This is done automatically by
+  functions that create boards and positions, so calling this is only needed
+  if a board is set up in another way (e.g. from SCL_BOARD_START_STATE).
+  Calling this multiple times is harmless.
+*/
+void SCL_init(void);
 
-void SCL_squareSetClear(SCL_SquareSet squareSet)
-{
-  for (uint8_t i = 0; i < 8; ++i)
-    squareSet[i] = 0;
-}
+void SCL_positionFromBoard(SCL_Position *position, const SCL_Board board);
+void SCL_positionToBoard(const SCL_Position *position, SCL_Board board);
 
-uint8_t SCL_stringToSquare(const char *square)
-{
-  return (square[1] - '1') * 8 +
-    (square[0] - ((square[0] >= 'A' && square[0] <= 'Z') ? 'A' : 'a'));
-}
+/**
+  Same as SCL_boardFromFEN but for bitboard position.
+*/
+uint8_t SCL_positionFromFEN(SCL_Position *position, const char *string);
 
-char *SCL_moveToString(SCL_Board board, uint8_t s0, uint8_t s1,
-  char promotion, char *string)
-{
-  char *result = string;
+/**
+  Same as SCL_boardToFEN but for bitboard position.
+*/
+uint8_t SCL_positionToFEN(SCL_Position *position, char *string);
 
-  SCL_squareToString(s0,string);
-  string += 2;
-  string = SCL_squareToString(s1,string);
-  string += 2;
+/**
+  Same as SCL_boardMakeMove, but for bitboard position.
+*/
+SCL_PositionUndo SCL_positionMakeMove(SCL_Position *position,
+  uint8_t squareFrom, uint8_t squareTo, char promotePiece);
 
-  char c = board[s0];
+void SCL_positionUndoMove(SCL_Position *position, SCL_PositionUndo undo);
 
-  if (c == 'p' || c == 'P')
-  {
-    uint8_t rank = s1 / 8;
+static inline uint8_t SCL_positionWhitesTurn(const SCL_Position *position);
 
-    if (rank == 0 || rank == 7)
-    {
-      *string = promotion;
-      string++;
-    }
-  }
+/**
+  Gets the type (SCL_PIECE_*) of piece on given square.
+*/
+static inline uint8_t SCL_positionPieceType(const SCL_Position *position,
+  uint8_t square);
 
-  *string = 0;
+/**
+  Returns the set of pieces of given color that attack given square.
+*/
+SCL_Bitboard SCL_positionAttackers(const SCL_Position *position,
+  uint8_t square, uint8_t byWhite);
 
-  return result;
-}
+/**
+  Same as SCL_boardSquareAttacked, but for bitboard position.
+*/
+uint8_t SCL_positionSquareAttacked(const SCL_Position *position,
+  uint8_t square, uint8_t byWhite);
 
-uint8_t SCL_boardWhitesTurn(SCL_Board board)
-{
-  return (board[SCL_BOARD_PLY_BYTE] % 2) == 0;
-}
+/**
+  Same as SCL_boardCheck, but for bitboard position.
+*/
+uint8_t SCL_positionCheck(const SCL_Position *position, uint8_t white);
 
-uint8_t SCL_coordsToSquare(uint8_t row, uint8_t column)
-{
-  return row * 8 + column;
-}
+/**
+  Same as SCL_boardGetPseudoMoves, but for bitboard position, the result is
+  returned as a bitboard.
+*/
+SCL_Bitboard SCL_positionGetPseudoMoves(const SCL_Position *position,
+  uint8_t pieceSquare, uint8_t checkCastling);
 
-uint8_t SCL_pieceIsWhite(char piece)
-{
-  return piece < 'a';
-}
+/**
+  Cheap static evaluation of a position: material, piece-square tables and pawn
+  structure interpolated between opening and endgame by the game phase. The
+  position keeps the first two updated with each move and the pawn structure
+  mostly comes from the pawn table, so this only takes a few operations.
+  Returns 0 if neither side has enough material to mate. Positive favors white.
+*/
+int16_t SCL_positionEvaluateTapered(const SCL_Position *position);
 
-char *SCL_squareToString(uint8_t square, char *string)
-{
-  string[0] = 'a' + square % 8;
-  string[1] = '1' + square / 8;
+/**
+  Full static evaluation of a position: SCL_positionEvaluateTapered plus piece
+  mobility, attacks and outposts, which takes a pass over the pieces. The
+  latter terms are at most SCL_VALUE_PAWN * 2 in total. Mates and stalemates are NOT
+  recognized. Positive favors white.
+*/
+int16_t SCL_positionEvaluate(const SCL_Position *position);
 
-  return string;
-}
+/**
+  Static evaluation function like SCL_boardEvaluateStatic (it also recognizes
+  mates and stalemates), which scores the board by SCL_positionEvaluate. The AI
+  search recognizes this function and instead of calling it reads the score
+  kept in its position, only adding the mobility and attack terms when the
+  score is close enough to the search window for them to matter, which makes it
+  much faster than other evaluation functions.
+*/
+int16_t SCL_boardEvaluateTapered(SCL_Board board);
 
-uint8_t SCL_squareIsWhite(uint8_t square)
+/**
+  Pawn structure evaluation of a position, which only depends on the pawns.
+*/
+typedef struct
 {
-  return (square % 2) != ((square / 8) % 2);
-}
+  uint64_t key;                ///< pawn key, stored XORed with the rest
+  SCL_Bitboard passed;         ///< passed pawns of both colors
+  SCL_Bitboard attackSpans[2]; /**< squares white's (0) and black's (1) pawns
+                                    attack or can attack by advancing */
+  int16_t score[2];            /**< doubled, isolated, backward and passed pawn
+                                    score of the opening and endgame, positive
+                                    favoring white */
+} SCL_PawnEntry;
 
-char SCL_pieceToColor(uint8_t piece, uint8_t toWhite)
+/**
+  Pawn table, a direct-mapped cache of pawn structure evaluations indexed by
+  the position's pawn key, as pawns move rarely and most evaluated positions
+  share the structure with many others. As in the transposition table, the key
+  is stored XORed with the data so that the table can be shared by threads
+  without locks.
+*/
+typedef struct
 {
-  return (SCL_pieceIsWhite(piece) == toWhite) ?
-    piece : (piece + (toWhite ? -32 : 32));
-}
+  SCL_PawnEntry entries[SCL_PAWN_TABLE_SIZE != 0 ? SCL_PAWN_TABLE_SIZE : 1];
+  uint32_t probes;             ///< for statistics
+  uint32_t hits;
+} SCL_PawnTable;
 
 /**
-  Records the rook starting positions in the board state. This is required in
-  chess 960 in order to be able to correctly perform castling (castling rights
-  knowledge isn't enough as one rook might have moved to the other side and we
-  wouldn't know which one can castle and which not).
+  The table used by SCL_positionEvaluate and SCL_positionEvaluateTapered.
 */
-void _SCL_board960RememberRookPositions(SCL_Board board)
-{
-  uint8_t pos = 0;
-  uint8_t rooks = 2;
+SCL_THREAD_LOCAL SCL_PawnTable SCL_pawnTable;
 
-  while (pos < 8 && rooks != 0)
-  {
-    if (board[pos] == 'R')
-    {
-      board[SCL_BOARD_EXTRA_BYTE] = rooks == 2 ? pos :
-        (board[SCL_BOARD_EXTRA_BYTE] | (pos << 3));
+/**
+  Gets the pawn structure evaluation of a position, from the pawn table if
+  possible.
+*/
+void SCL_positionPawnStructure(const SCL_Position *position,
+  SCL_PawnEntry *entry);
 
-      rooks--;
-    }
+#if SCL_NNUE
+/**
+  NNUE network. Each perspective (white's and black's, each seeing its own
+  pieces as the first six and the board from its side) has SCL_NNUE_HIDDEN
+  neurons, the sum of the bias and the weights of the active input features,
+  i.e. the pieces on their squares for the bucket of the perspective's king
+  square. The neurons of the side to move and then those of the other side
+  are clipped to <0,127> and multiplied by the output weights, and the sum plus
+  the output bias divided by the output divisor is the score for the side to
+  move.
+*/
+typedef struct
+{
+  int16_t featureWeights[SCL_NNUE_FEATURES][SCL_NNUE_HIDDEN];
+  int16_t featureBiases[SCL_NNUE_HIDDEN];
+  int8_t outputWeights[2 * SCL_NNUE_HIDDEN];
+  int32_t outputBias;
+  int32_t outputDivisor;
+} SCL_NNUENetwork;
 
-    pos++;
-  }
-}
+/**
+  The network used by SCL_boardEvaluateNNUE, SCL_init sets it to the one made
+  by SCL_nnueDefaultNetwork.
+*/
+SCL_NNUENetwork SCL_nnueNetwork;
 
-void SCL_boardInit(SCL_Board board)
-{
-  /*
-    We might use SCL_BOARD_START_STATE and copy it to the board, but that might
-    waste RAM on Arduino, so we init the board by code.
-  */
+/**
+  Size of a network file: "SCLNNUE1", the number of features, the number of
+  neurons and the output divisor, then the feature biases, the feature weights
+  (by feature), the output weights and the output bias, all numbers little
+  endian.
+*/
+#define SCL_NNUE_FILE_SIZE (24 + 4 * SCL_NNUE_HIDDEN + \
+  2 * SCL_NNUE_FEATURES * SCL_NNUE_HIDDEN)
 
-  char *b = board;
+/**
+  Makes a network that evaluates material and piece-square tables like
+  SCL_positionEvaluateTapered does halfway between the opening and endgame,
+  meant to be replaced with a trained network.
+*/
+void SCL_nnueDefaultNetwork(SCL_NNUENetwork *network);
 
-  *b = 'R'; b++; *b = 'N'; b++;
-  *b = 'B'; b++; *b = 'Q'; b++;
-  *b = 'K'; b++; *b = 'B'; b++;
-  *b = 'N'; b++; *b = 'R'; b++;
+/**
+  Loads a network from data in the file format (read from a file or embedded
+  in the program). Returns 0 if the data isn't a network of this size, in
+  which case the network isn't changed.
+*/
+uint8_t SCL_nnueLoad(SCL_NNUENetwork *network, const uint8_t *data,
+  uint32_t size);
 
-  char *b2 = board + 48;
+/**
+  Writes a network in the file format, SCL_NNUE_FILE_SIZE bytes.
+*/
+void SCL_nnueSave(const SCL_NNUENetwork *network, uint8_t *data);
 
-  for (uint8_t i = 0; i < 8; ++i, b++, b2++)
-  {
-    *b = 'P';
-    *b2 = 'p';
-  }
+#define SCL_NNUE_SCALAR 0
+#define SCL_NNUE_SSE41  1
+#define SCL_NNUE_AVX2   2
+#define SCL_NNUE_NEON   3
 
-  for (uint8_t i = 0; i < 32; ++i, b++)
-    *b = '.';
+/**
+  Instructions the network is computed with, SCL_init selects the best ones
+  the CPU supports. The results are the same with all of them.
+*/
+uint8_t SCL_nnueImplementation;
 
-  b += 8;
+/**
+  Selects the instructions to compute the network with (SCL_NNUE_*), returns
+  0 if the compiler or the CPU doesn't support them.
+*/
+uint8_t SCL_nnueSetImplementation(uint8_t implementation);
 
-  *b = 'r'; b++; *b = 'n'; b++;
-  *b = 'b'; b++; *b = 'q'; b++;
-  *b = 'k'; b++; *b = 'b'; b++;
-  *b = 'n'; b++; *b = 'r'; b++;
+const char *SCL_nnueImplementationName(uint8_t implementation);
 
-  for (uint8_t i = 0; i < SCL_BOARD_STATE_SIZE - SCL_BOARD_SQUARES; ++i, ++b)
-    *b = 0;
+/**
+  Computes the NNUE accumulator of a position from scratch, after which moves
+  made on the position keep it updated.
+*/
+void SCL_positionNNUERefresh(SCL_Position *position);
 
-  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] = (char) 0xff;
+/**
+  Evaluates a position with SCL_nnueNetwork, first computing its accumulator
+  if it isn't up to date. Returns 0 if neither side has enough material to
+  mate. Positive favors white.
+*/
+int16_t SCL_positionEvaluateNNUE(SCL_Position *position);
 
-#if SCL_960_CASTLING
-  _SCL_board960RememberRookPositions(board);
+/**
+  Static evaluation function like SCL_boardEvaluateStatic (it also recognizes
+  mates and stalemates), which scores the board by SCL_positionEvaluateNNUE.
+  The AI search recognizes this function and evaluates its positions by their
+  accumulators, which moves only change by the weights of a few features.
+*/
+int16_t SCL_boardEvaluateNNUE(SCL_Board board);
 #endif
-}
 
-void _SCL_boardPlaceOnNthAvailable(SCL_Board board, uint8_t pos, char piece)
-{
-  char *c = board;
-
-  while (1)
-  {
-    if (*c == '.')
-    {
-      if (pos == 0)
-        break;
+void SCL_bitboardToSquareSet(SCL_Bitboard bitboard, SCL_SquareSet squareSet);
+SCL_Bitboard SCL_squareSetToBitboard(const SCL_SquareSet squareSet);
 
-      pos--;
-    }
-
-    c++;
-  }
+/**
+  Returns the number of squares in a bitboard.
+*/
+static inline uint8_t SCL_bitboardCount(SCL_Bitboard bitboard);
 
-  *c = piece;
-}
+/**
+  Returns the lowest square in a non-empty bitboard.
+*/
+static inline uint8_t SCL_bitboardFirst(SCL_Bitboard bitboard);
 
-void SCL_boardInit960(SCL_Board board, uint16_t positionNumber)
-{
-  SCL_Board b;
+/**
+  Removes the lowest square from a non-empty bitboard and returns it. Useful
+  for iterating over bitboards:
 
-  SCL_boardInit(b);
+    while (b) { uint8_t square = SCL_bitboardPop(&b); ... }
+*/
+static inline uint8_t SCL_bitboardPop(SCL_Bitboard *bitboard);
 
-  for (uint8_t i = 0; i < SCL_BOARD_STATE_SIZE; ++i)
-    board[i] = ((i >= 8 && i < 56) || i >= 64) ? b[i] : '.';
+/**
+  Move encoded in 16 bits as follows:
 
-  uint8_t helper = positionNumber % 16;
+  ttffffff ppssssss
 
-  board[(helper / 4) * 2] = 'B';
-  board[1 + (helper % 4) * 2] = 'B';
+    ssssss  Start square.
+    ffffff  Target square (for 960 castling this is the square of the rook).
+    pp      Promoted piece: 00 knight, 01 bishop, 10 rook, 11 queen.
+    tt      Move type: 00 normal, 01 promotion, 10 en passant, 11 castling.
 
-  helper = positionNumber / 16;
+  The value 0 (SCL_MOVE_NONE) isn't a valid move.
+*/
+typedef uint16_t SCL_Move;
 
-  // maybe there's a simpler way :)
+#define SCL_MOVE_NONE 0
 
-  _SCL_boardPlaceOnNthAvailable(board,helper % 6,'Q');
-  _SCL_boardPlaceOnNthAvailable(board,0,helper <= 23 ? 'N' : 'R');
+#define SCL_MOVE_NORMAL     0x0000
+#define SCL_MOVE_PROMOTION  0x4000
+#define SCL_MOVE_EN_PASSANT 0x8000
+#define SCL_MOVE_CASTLING   0xc000
 
-  _SCL_boardPlaceOnNthAvailable(board,0,
-    (helper >= 7 && helper <= 23) ? 'R' :
-      (helper > 41 ? 'K' : 'N' ));
+#define SCL_MOVE_PROMOTE_N 0x0000
+#define SCL_MOVE_PROMOTE_B 0x1000
+#define SCL_MOVE_PROMOTE_R 0x2000
+#define SCL_MOVE_PROMOTE_Q 0x3000
 
-  _SCL_boardPlaceOnNthAvailable(board,0,
-    (helper <= 5 || helper >= 54) ? 'R' :
-      (((helper >= 12 && helper <= 23) ||
-      (helper >= 30 && helper <= 41)) ? 'K' : 'N'));
+#define SCL_MOVE(from,to,flags) \
+  ((SCL_Move) ((from) | ((to) << 6) | (flags)))
 
-  _SCL_boardPlaceOnNthAvailable(board,0,
-    (helper <= 11 || (helper <= 29 && helper >= 24)) ? 'K' :
-      (
-        (
-          (helper >= 18 && helper <= 23) ||
-          (helper >= 36 && helper <= 41) ||
-          (helper >= 48 && helper <= 53)
-        ) ? 'R' : 'N'
-      )
-    );
+static inline uint8_t SCL_moveFrom(SCL_Move move);
+static inline uint8_t SCL_moveTo(SCL_Move move);
+static inline uint16_t SCL_moveType(SCL_Move move);
 
-  uint8_t rooks = 0;
+/**
+  Gets the promotion piece of a move as lowercase char ('q', 'r', 'b', 'n'),
+  for moves that aren't promotions 'q' is returned so that the result can
+  always be passed to SCL_boardMakeMove.
+*/
+static inline char SCL_movePromotion(SCL_Move move);
 
-  for (uint8_t i = 0; i < 8; ++i)
-    if (board[i] == 'R')
-      rooks++;
+/**
+  The maximum number of legal moves in any chess position is 218.
+*/
+#define SCL_MOVE_LIST_MAX_LENGTH 256
 
-  _SCL_boardPlaceOnNthAvailable(board,0,rooks == 2 ? 'N' : 'R');
+/**
+  List of moves of all pieces of the player to move.
+*/
+typedef struct
+{
+  SCL_Move moves[SCL_MOVE_LIST_MAX_LENGTH];
+  uint16_t count;
+} SCL_MoveList;
 
-  for (uint8_t i = 0; i < 8; ++i)
-    board[56 + i] = SCL_pieceToColor(board[i],0);
+/**
+  Gets all legal moves of the player to move. Unlike SCL_boardGetMoves this
+  doesn't try the moves, but finds pinned pieces and checking pieces once and
+  then only generates legal moves. Moves are ordered by start square and then
+  by target square, promotions are ordered queen, rook, bishop, knight.
+*/
+void SCL_positionGetMoves(const SCL_Position *position, SCL_MoveList *moves);
 
-#if SCL_960_CASTLING
-  _SCL_board960RememberRookPositions(board);
-#else
-  SCL_boardDisableCastling(board);
-#endif
-}
+/**
+  Same as SCL_positionGetMoves but for SCL_Board.
+*/
+void SCL_boardGetMoveList(const SCL_Board board, SCL_MoveList *moves);
 
-uint8_t SCL_boardsDiffer(SCL_Board b1, SCL_Board b2)
-{
-  const char *p1 = b1, *p2 = b2;
+/**
+  Same as SCL_positionGetMoves but only gets captures (including en passant)
+  and promotions, i.e. the moves searched by quiescence search.
+*/
+void SCL_positionGetCaptures(const SCL_Position *position,
+  SCL_MoveList *moves);
 
-  while (p1 < b1 + SCL_BOARD_STATE_SIZE)
-  {
-    if (*p1 != *p2)
-      return 1;
+/**
+  Counts the leaf nodes of the legal move tree of given depth (perft), used to
+  validate and time move generation. If bulk is non-zero, the moves at the
+  last level are only counted and not made, which measures the generator alone
+  rather than generator plus make/undo.
+*/
+uint64_t SCL_positionPerft(SCL_Position *position, uint8_t depth,
+  uint8_t bulk);
 
-    p1++;
-    p2++;
-  }
+/**
+  Same as SCL_positionPerft but also prints the leaf count of each root move
+  in the "e2e4: 20" format (one move per line) with given function, which is
+  the usual way of finding a wrong move by comparing with another engine.
+*/
+uint64_t SCL_positionPerftDivide(SCL_Position *position, uint8_t depth,
+  uint8_t bulk, SCL_PutCharFunction putCharFunc);
 
-  return 0;
-}
+#define SCL_BOUND_NONE  0x00
+#define SCL_BOUND_EXACT 0x01 ///< score is the exact value of the position
+#define SCL_BOUND_LOWER 0x02 ///< search was cut off, value is at least score
+#define SCL_BOUND_UPPER 0x03 ///< no move reached alpha, value is at most score
 
-void SCL_recordInit(SCL_Record r)
+/**
+  Single transposition table entry as returned by SCL_transpositionTableProbe.
+*/
+typedef struct
 {
-  r[0] = 0 | SCL_RECORD_END;
-  r[1] = 0;
-}
+  uint64_t key;     ///< position key as given by SCL_boardKey
+  int16_t score;    ///< score from the view of the player to move
+  SCL_Move move;    ///< best move found or SCL_MOVE_NONE
+  int8_t depth;     ///< depth the position was searched to
+  uint8_t info;     ///< lowest 2 bits: bound type, other bits: generation
+} SCL_TranspositionEntry;
 
-void SCL_recordFromPGN(SCL_Record r, const char *pgn)
+/**
+  Form in which entries are stored in the table, 16 bytes so that 4 slots (a
+  bucket) fill a 64 byte cache line. The entry without the key is packed into
+  data and the key is stored XORed with it, so an entry torn by two threads
+  writing it at once doesn't match any key and is ignored. This way the table
+  can be shared by threads without locks.
+*/
+typedef struct
 {
-  SCL_Board board;
-
-  SCL_boardInit(board);
+  uint64_t keyData; ///< key XOR data
+  uint64_t data;    ///< score, move, depth and info from the lowest bits
+} SCL_TranspositionSlot;
 
-  SCL_recordInit(r);
+#define SCL_TRANSPOSITION_BUCKET_SIZE 4
 
-  uint8_t state = 0;
-  uint8_t evenMove = 0;
+/**
+  Transposition table, a hash table of searched positions. Entries are in
+  buckets of SCL_TRANSPOSITION_BUCKET_SIZE, the bucket count is a power of two
+  so that the bucket is selected by masking the key. When a bucket is full the
+  entry searched to the lowest depth is replaced, preferring entries left from
+  previous searches (older generations).
+*/
+typedef struct
+{
+  SCL_TranspositionSlot *slots;    ///< 64 byte aligned, 0 means no table
+  uint32_t bucketMask;             ///< number of buckets - 1
+  uint8_t generation;              ///< increased with each new search
+  void *memory;                    ///< allocated memory, for freeing
+  SCL_StaticEvaluationFunction evaluationFunction; /**< the one the stored
+                                                        scores come from */
+} SCL_TranspositionTable;
 
-  while (*pgn != 0)
-  {
-    switch (state)
-    {
-      case 0: // skipping tags and spaces, outside []
-        if (*pgn == '1')
-          state = 2;
-        else if (*pgn == '[')
-          state = 1;
+/**
+  The table used by the AI (SCL_getAIMove, SCL_boardEvaluateDynamic), set up
+  by SCL_init with SCL_TRANSPOSITION_TABLE_SIZE MB. Use
+  SCL_transpositionTableInit to change its size or disable it.
+*/
+SCL_THREAD_LOCAL SCL_TranspositionTable SCL_transpositionTable;
 
-        break;
+/**
+  Allocates the table so that it takes at most sizeMB megabytes, freeing the
+  previous table (the struct must have been zeroed or initialized before).
+  sizeMB 0 just frees the table, disabling it. Returns 1 on success, 0 if the
+  memory couldn't be allocated (the table is then disabled).
+*/
+uint8_t SCL_transpositionTableInit(SCL_TranspositionTable *table,
+  uint16_t sizeMB);
 
-      case 1: // skipping tags and spaces, inside []
-        if (*pgn == ']')
-          state = 0;
+void SCL_transpositionTableClear(SCL_TranspositionTable *table);
 
-        break;
+/**
+  Starts a new generation of entries, call this before each new search so that
+  entries from older searches are replaced first.
+*/
+void SCL_transpositionTableNewSearch(SCL_TranspositionTable *table);
 
-      case 2: // reading move number
-        if (*pgn == '{')
-          state = 3;
-        else if ((*pgn >= 'a' && *pgn <= 'h') || (*pgn >= 'A' && *pgn <= 'Z'))
-        {
-          state = 4;
-          pgn--;
-        }
+/**
+  Finds the entry of given position and copies it to entry, returns 0 if there
+  is none.
+*/
+uint8_t SCL_transpositionTableProbe(const SCL_TranspositionTable *table,
+  uint64_t key, SCL_TranspositionEntry *entry);
 
-        break;
+void SCL_transpositionTableStore(SCL_TranspositionTable *table, uint64_t key,
+  int8_t depth, uint8_t bound, int16_t score, SCL_Move move);
 
-      case 3: // initial comment
-        if (*pgn == '}')
-          state = 2;
+/**
+  Evaluation cache, a direct-mapped table of static evaluations by position
+  key which the AI search consults before calling the evaluation function
+  (except for SCL_boardEvaluateTapered and SCL_boardEvaluateNNUE which the
+  search computes incrementally). Each entry is a single 64 bit word holding
+  the upper 48 bits of the key and the score in the lower 16 bits (the index
+  adds more bits of the key), so an entry is written at once and the cache can
+  be shared by threads without locks.
+*/
+typedef struct
+{
+  uint64_t entries[SCL_EVALUATION_CACHE_SIZE != 0 ?
+    SCL_EVALUATION_CACHE_SIZE : 1];
+  SCL_StaticEvaluationFunction evaluationFunction; /**< the one the stored
+                                                        scores come from */
+} SCL_EvaluationCache;
 
-        break;
+/**
+  The cache used by the AI search.
+*/
+SCL_THREAD_LOCAL SCL_EvaluationCache SCL_evaluationCache;
 
-      case 4: // reading move
-      {
-        char piece = 'p';
-        char promoteTo = 'q';
-        uint8_t castle = 0;
-        uint8_t promotion = 0;
+void SCL_evaluationCacheClear(SCL_EvaluationCache *cache);
 
-        int8_t coords[4];
+/**
+  Function returning time in milliseconds (counted from any point, only
+  differences are used), needed for time limited AI search.
+*/
+typedef uint32_t (*SCL_TimeFunction)(void);
 
-        uint8_t ranks = 0, files = 0;
+/**
+  Limits of the iterative AI search (SCL_getAIMoveIterative), 0 means no limit.
+  Depth 1 is always searched completely so that there is a move to return.
+*/
+typedef struct
+{
+  uint8_t depth;                  ///< maximum depth in ply
+  uint32_t time;                  ///< maximum time in ms, needs timeFunction
+  uint32_t nodes;                 ///< maximum number of searched positions
+  SCL_TimeFunction timeFunction;
+  const volatile uint8_t *stop;   /**< if not 0, the search stops once this
+                                       becomes non-0, which allows stopping it
+                                       from another thread */
+  uint8_t multiPV;                /**< number of best moves (lines) to search,
+                                       0 means 1, at most SCL_MAX_MULTI_PV */
+  const volatile uint32_t *newTime; /**< if not 0, a non-0 value it points to
+                                       replaces time, which allows setting the
+                                       time limit from another thread while
+                                       searching (e.g. on a ponder hit) */
+} SCL_SearchLimits;
+
+#define SCL_MAX_MULTI_PV 16
 
-        for (uint8_t i = 0; i < 4; ++i)
-          coords[i] = -1;
+/**
+  Info about a completed iteration of the iterative AI search.
+*/
+typedef struct
+{
+  uint8_t depth;
+  int16_t score;                  ///< same meaning as in SCL_getAIMove
+  uint64_t nodes;                 ///< positions searched by all iterations
+  uint32_t time;                  ///< ms since start, 0 without time function
+  SCL_Move move;                  ///< best move of the iteration
+  uint8_t multiPV;                /**< 1 for the best move, 2 for the second
+                                       best one etc. with limits' multiPV */
+  uint32_t cutoffs;               ///< nodes in which a move caused a cutoff
+  uint32_t firstMoveCutoffs;      /**< cutoffs by the first searched move, the
+                                       higher part of cutoffs this is, the
+                                       better the move ordering */
+  uint32_t pawnTableProbes;       /**< pawn table lookups of the evaluation
+                                       since the search start */
+  uint32_t pawnTableHits;         ///< lookups which found the pawn structure
+} SCL_SearchInfo;
+
+typedef void (*SCL_SearchInfoFunction)(const SCL_SearchInfo *info);
+
+#define SCL_SEARCH_MAX_PLY 128 ///< maximum distance from the root in AI search
 
-        while (*pgn != ' ' && *pgn != '\n' &&
-          *pgn != '\t' && *pgn != '{' && *pgn != 0)
-        {
-          if (*pgn == '=')
-            promotion = 1;
-          if (*pgn == 'O' || *pgn == '0')
-            castle++;
-          if (*pgn >= 'A' && *pgn <= 'Z')
-          {
-            if (promotion)
-              promoteTo = *pgn;
-            else
-              piece = *pgn;
-          }
-          else if (*pgn >= 'a' && *pgn <= 'h')
-          {
-            coords[files * 2] = *pgn - 'a';
-            files++;
-          }
-          else if (*pgn >= '1' && *pgn <= '8')
-          {
-            coords[1 + ranks * 2] = *pgn - '1';
-            ranks++;
-          }
+/**
+  State of one AI search (which may consist of more iterations). Besides the
+  search path and the search settings this holds move ordering heuristics
+  which learn which quiet moves caused cutoffs so that these are tried first in
+  the rest of the search. Pieces are indexed 0 to 11 as in "PNBRQKpnbrqk".
+  Each searching thread has its own context, the only state the threads share
+  is the transposition table.
+*/
+typedef struct
+{
+  SCL_StaticEvaluationFunction evalFunction;
+  int8_t depthHardLimit;          ///< minus the quiescence search depth
+  int16_t rootEvaluation;         ///< static evaluation used by old search
+  uint64_t nodes;                 ///< searched positions
+  const SCL_SearchLimits *limits; ///< checked during search if not 0
+  uint32_t startTime;             ///< time the limits are counted from
+  uint8_t abort;                  ///< set to stop the search
+  const volatile uint8_t *stop;   ///< if not 0, abort once this becomes non-0
+  uint8_t threads;                ///< threads for root parallel search
+  uint8_t readOnlyTable;          ///< if 1, don't store to the table
+  const SCL_Move *excludedMoves;  ///< root moves not to search (MultiPV)
+  uint8_t excludedCount;
+  uint64_t keys[SCL_SEARCH_MAX_PLY];  ///< position keys on the search path
+  SCL_Move moves[SCL_SEARCH_MAX_PLY]; ///< moves on the search path
+  SCL_Move killers[SCL_SEARCH_MAX_PLY][2]; ///< last quiet cutoff moves by ply
+  SCL_Move counterMoves[12][64];  /**< quiet cutoff move after given move,
+                                       by its piece and target square */
+  int16_t history[12][64];        /**< how often quiet moves by piece and
+                                       target square caused cutoffs */
+  uint32_t cutoffs;
+  uint32_t firstMoveCutoffs;
+} SCL_SearchContext;
 
-          pgn++;
-        }
+/**
+  Iterative deepening version of SCL_getAIMove: searches to depth 1, 2, 3, ...
+  until a limit is reached and returns the move of the last completed
+  iteration, so unlike with a fixed depth the search time is predictable.
+  Iterations are sped up by the transposition table filled by the previous
+  ones. If infoFunc is not 0, it is called after each completed iteration.
+  Other parameters are the same as in SCL_getAIMove.
+*/
+int16_t SCL_getAIMoveIterative(
+  SCL_Board board,
+  const SCL_SearchLimits *limits,
+  uint8_t extensionExtraDepth,
+  SCL_StaticEvaluationFunction evalFunc,
+  SCL_RandomFunction randFunc,
+  uint8_t randomness,
+  uint8_t repetitionMoveFrom,
+  uint8_t repetitionMoveTo,
+  SCL_SearchInfoFunction infoFunc,
+  uint8_t *resultFrom,
+  uint8_t *resultTo,
+  char *resultProm);
 
-        if (castle)
-        {
-          piece = 'K';
+/**
+  Number of positions searched by the last SCL_getAIMoveIterative call,
+  including its unfinished last iteration and the helper threads, unlike the
+  nodes in SCL_SearchInfo which only count completed iterations.
+*/
+SCL_THREAD_LOCAL uint64_t SCL_searchNodes;
 
-          coords[0] = 4;
-          coords[1] = 0;
-          coords[2] = castle < 3 ? 6 : 2;
-          coords[3] = 0;
+/**
+  Returns the opponent's reply to given move that the AI expects, i.e. the best
+  move the last search stored in the transposition table for the position
+  after the move, or SCL_MOVE_NONE if there is none. Call it right after the
+  search with the same extensionExtraDepth. This is the move to ponder on:
+  while the opponent thinks, search the position after the reply so that if
+  it is played, the search is already done or under way.
+*/
+SCL_Move SCL_getAIPonderMove(SCL_Board board, uint8_t from, uint8_t to,
+  char promotion, uint8_t extensionExtraDepth);
 
-          if (evenMove)
-          {
-            coords[1] = 7;
-            coords[3] = 7;
-          }
-        }
+#define SCL_MAX_THREADS 64
 
-        piece = SCL_pieceToColor(piece,evenMove == 0);
+/**
+  Sets the number of threads the AI searches with and returns the number that
+  will be used, which is always 1 unless the library is compiled with
+  SCL_THREADS. SCL_getAIMoveIterative uses the threads for Lazy SMP: they share
+  the transposition table, the main one searches as with one thread while the
+  others (helpers) search the same position with staggered depths, so that
+  together they fill the table faster. This makes the search nondeterministic.
+  SCL_getAIMove without a random function instead divides the root moves
+  between the threads, which is deterministic (the result is the same for any
+  number of threads above 1, but it may differ from the one of the serial
+  search with 1 thread) but gains less.
+*/
+uint8_t SCL_setThreads(uint8_t count);
 
-        if (coords[2] < 0)
-        {
-          coords[2] = coords[0];
-          coords[0] = -1;
-        }
+//=============================================================================
+// privates:
 
-        if (coords[3] < 0)
-        {
-          coords[3] = coords[1];
-          coords[1] = -1;
-        }
+#define SCL_UNUSED(v) (void)(v)
 
-        uint8_t squareTo = coords[3] * 8 + coords[2];
+SCL_THREAD_LOCAL uint8_t SCL_currentRandom8 = 0;
 
-        if (coords[0] < 0 || coords[1] < 0)
-        {
-          // without complete starting coords we have to find the piece
+SCL_THREAD_LOCAL uint16_t SCL_currentRandom16 = 0;
 
-          for (int i = 0; i < SCL_BOARD_SQUARES; ++i)
-            if (board[i] == piece)
-            {
-              SCL_SquareSet s;
-
-              SCL_squareSetClear(s);
+void SCL_randomSimpleSeed(uint8_t seed)
+{
+  SCL_currentRandom8 = seed;
+}
 
-              SCL_boardGetMoves(board,i,s);
+uint8_t SCL_randomSimple(void)
+{
+  SCL_currentRandom8 *= 13;
+  SCL_currentRandom8 += 7;
+  return SCL_currentRandom8;
+}
 
-              if (SCL_squareSetContains(s,squareTo) &&
-                (coords[0] < 0 || coords[0] == i % 8) &&
-                (coords[1] < 0 || coords[1] == i / 8))
-              {
-                coords[0] = i % 8;
-                coords[1] = i / 8;
-                break;
-              }
-            }
-        }
+uint8_t SCL_randomBetter(void)
+{
+  SCL_currentRandom16 *= 13;
+  SCL_currentRandom16 += 7;
+  return (SCL_currentRandom16 % 256) ^ (SCL_currentRandom16 / 256);
+}
 
-        uint8_t squareFrom = coords[1] * 8 + coords[0];
+void SCL_randomBetterSeed(uint16_t seed)
+{
+  SCL_currentRandom16 = seed;
+}
 
-        SCL_boardMakeMove(board,squareFrom,squareTo,promoteTo);
+void SCL_squareSetClear(SCL_SquareSet squareSet)
+{
+  for (uint8_t i = 0; i < 8; ++i)
+    squareSet[i] = 0;
+}
 
-// for some reason tcc bugs here, the above line sets squareFrom to 0 lol
-// can be fixed with doing "squareFrom = coords[1] * 8 + coords[0];" again
+uint8_t SCL_stringToSquare(const char *square)
+{
+  return (square[1] - '1') * 8 +
+    (square[0] - ((square[0] >= 'A' && square[0] <= 'Z') ? 'A' : 'a'));
+}
 
-        SCL_recordAdd(r,squareFrom,squareTo,promoteTo,SCL_RECORD_CONT);
+char *SCL_moveToString(SCL_Board board, uint8_t s0, uint8_t s1,
+  char promotion, char *string)
+{
+  char *result = string;
 
-        while (*pgn == ' ' || *pgn == '\n' || *pgn == '\t' || *pgn == '{')
-        {
-          if (*pgn == '{')
-            while (*pgn != '}')
-              pgn++;
+  SCL_squareToString(s0,string);
+  string += 2;
+  string = SCL_squareToString(s1,string);
+  string += 2;
 
-          pgn++;
-        }
+  char c = board[s0];
 
-        if (*pgn == 0)
-          return;
+  if (c == 'p' || c == 'P')
+  {
+    uint8_t rank = s1 / 8;
 
-        pgn--;
+    if (rank == 0 || rank == 7)
+    {
+      *string = promotion;
+      string++;
+    }
+  }
 
-        if (evenMove)
-          state = 2;
+  *string = 0;
 
-        evenMove = !evenMove;
+  return result;
+}
 
-        break;
-      }
+uint8_t SCL_boardWhitesTurn(SCL_Board board)
+{
+  return (board[SCL_BOARD_PLY_BYTE] % 2) == 0;
+}
 
-      default: break;
-    }
+uint8_t SCL_coordsToSquare(uint8_t row, uint8_t column)
+{
+  return row * 8 + column;
+}
 
-    pgn++;
-  }
+uint8_t SCL_pieceIsWhite(char piece)
+{
+  return piece < 'a';
 }
 
-uint16_t SCL_recordLength(const SCL_Record r)
+char *SCL_squareToString(uint8_t square, char *string)
 {
-  if ((r[0] & 0x3f) == (r[1] & 0x3f)) // empty record that's only terminator
-    return 0;
+  string[0] = 'a' + square % 8;
+  string[1] = '1' + square / 8;
 
-  uint16_t result = 0;
+  return string;
+}
 
-  while ((r[result] & 0xc0) == 0)
-    result += 2;
+uint8_t SCL_squareIsWhite(uint8_t square)
+{
+  return (square % 2) != ((square / 8) % 2);
+}
 
-  return (result / 2) + 1;
+char SCL_pieceToColor(uint8_t piece, uint8_t toWhite)
+{
+  return (SCL_pieceIsWhite(piece) == toWhite) ?
+    piece : (piece + (toWhite ? -32 : 32));
 }
 
-uint8_t SCL_recordGetMove(const SCL_Record r,  uint16_t index,
-  uint8_t *squareFrom, uint8_t *squareTo, char *promotedPiece)
+//-----------------------------------------------------------------------------
+// bitboards:
+
+uint8_t SCL_bitboardCount(SCL_Bitboard bitboard)
 {
-  index *= 2;
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(bitboard);
+#else
+  uint8_t result = 0;
 
-  uint8_t b = r[index];
+  while (bitboard)
+  {
+    bitboard &= bitboard - 1;
+    result++;
+  }
 
-  *squareFrom = b & 0x3f;
-  uint8_t result = b & 0xc0;
+  return result;
+#endif
+}
 
-  index++;
+uint8_t SCL_bitboardFirst(SCL_Bitboard bitboard)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(bitboard);
+#else
+  // De Bruijn multiplication, see chessprogramming wiki
+  static const uint8_t index[64] =
+  {
+     0,  1, 48,  2, 57, 49, 28,  3, 61, 58, 50, 42, 38, 29, 17,  4,
+    62, 55, 59, 36, 53, 51, 43, 22, 45, 39, 33, 30, 24, 18, 12,  5,
+    63, 47, 56, 27, 60, 41, 37, 16, 54, 35, 52, 21, 44, 32, 23, 11,
+    46, 26, 40, 15, 34, 20, 31, 10, 25, 14, 19,  9, 13,  8,  7,  6
+  };
 
-  b = r[index];
+  return index[((bitboard & (0 - bitboard)) * 0x03f79d71b4cb0a89ULL) >> 58];
+#endif
+}
 
-  *squareTo = b & 0x3f;
+/**
+  Returns the highest square in a non-empty bitboard.
+*/
+static inline uint8_t _SCL_bitboardLast(SCL_Bitboard bitboard)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return 63 - __builtin_clzll(bitboard);
+#else
+  uint8_t result = 0;
 
-  b &= 0xc0;
+  while (bitboard >>= 1)
+    result++;
 
-  switch (b)
+  return result;
+#endif
+}
+
+uint8_t SCL_bitboardPop(SCL_Bitboard *bitboard)
+{
+  uint8_t result = SCL_bitboardFirst(*bitboard);
+  *bitboard &= *bitboard - 1;
+  return result;
+}
+
+void SCL_bitboardToSquareSet(SCL_Bitboard bitboard, SCL_SquareSet squareSet)
+{
+  for (uint8_t i = 0; i < 8; ++i)
   {
-    case SCL_RECORD_PROM_Q: *promotedPiece = 'q'; break;
-    case SCL_RECORD_PROM_R: *promotedPiece = 'r'; break;
-    case SCL_RECORD_PROM_B: *promotedPiece = 'b'; break;
-    case SCL_RECORD_PROM_N:
-    default:            *promotedPiece = 'n'; break;
+    squareSet[i] = bitboard & 0xff;
+    bitboard >>= 8;
   }
+}
+
+SCL_Bitboard SCL_squareSetToBitboard(const SCL_SquareSet squareSet)
+{
+  SCL_Bitboard result = 0;
+
+  for (int8_t i = 7; i >= 0; --i)
+    result = (result << 8) | squareSet[i];
 
   return result;
 }
 
-uint8_t SCL_recordAdd(SCL_Record r, uint8_t squareFrom,
-  uint8_t squareTo, char promotePiece, uint8_t endState)
+SCL_Bitboard _SCL_knightAttacks[SCL_BOARD_SQUARES];
+SCL_Bitboard _SCL_kingAttacks[SCL_BOARD_SQUARES];
+SCL_Bitboard _SCL_pawnAttacks[2][SCL_BOARD_SQUARES]; ///< white, black
+
+/**
+  Rays going from each square in each direction, not including the square
+  itself. Directions 0 - 3 go towards higher squares (N, E, NE, NW), 4 - 7
+  towards lower ones (S, W, SW, SE).
+*/
+SCL_Bitboard _SCL_rays[8][SCL_BOARD_SQUARES];
+
+#ifndef SCL_SLIDER_TABLES
+  /**
+    If set, attacks of sliding pieces and squares between two squares will be
+    looked up in tables (magic bitboards) computed by SCL_init, which take
+    about 900 kB of RAM. Otherwise they are computed ray by ray, which is
+    several times slower but only needs a few kB, e.g. for programs that don't
+    use the AI.
+  */
+  #define SCL_SLIDER_TABLES 1
+#endif
+
+#if SCL_SLIDER_TABLES
+/**
+  Squares strictly between two squares on the same line (otherwise empty) and
+  whole lines going through two squares (otherwise empty).
+*/
+SCL_Bitboard _SCL_between[SCL_BOARD_SQUARES][SCL_BOARD_SQUARES];
+SCL_Bitboard _SCL_lines[SCL_BOARD_SQUARES][SCL_BOARD_SQUARES];
+
+/**
+  Magic numbers for slider attack lookup, found by trial and error, see e.g.
+  chessprogramming wiki ("Magic Bitboards").
+*/
+static const SCL_Bitboard _SCL_rookMagicNumbers[SCL_BOARD_SQUARES] =
 {
-  uint16_t l = SCL_recordLength(r);
+  0x1080004008801020ULL, 0x0840092002c03000ULL, 0x1900200010400900ULL,
+  0x0880100008000480ULL, 0x4200100420080200ULL, 0x8100020100080400ULL,
+  0x0200040110886200ULL, 0x0200008040220411ULL, 0x0404800084400220ULL,
+  0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+  0x000a001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL,
+  0x0442000102105084ULL, 0x9080010020804100ULL, 0x0040404000201009ULL,
+  0x0000808010002009ULL, 0x2200090021d00100ULL, 0x0008008008040080ULL,
+  0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000a0001768104ULL,
+  0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL,
+  0x1000100080080080ULL, 0x0442000a00049020ULL, 0x2100040080020080ULL,
+  0x0800120400900148ULL, 0x0010040a00128541ULL, 0x2800804000800030ULL,
+  0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+  0x0400802402800800ULL, 0xc100020080800400ULL, 0x0002000802000401ULL,
+  0x0182085882000401ULL, 0x0220204000808000ULL, 0x2860100040024022ULL,
+  0x0001002004110040ULL, 0x99101042000a0020ULL, 0x0004080004008080ULL,
+  0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+  0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040a00300ULL,
+  0x0801100280080480ULL, 0x0242009008200600ULL, 0x1002000489500200ULL,
+  0x0040800200010080ULL, 0x0091800041000080ULL, 0x0000209300488001ULL,
+  0x04c1002414824001ULL, 0x020020000b001041ULL, 0x7000100004200901ULL,
+  0x8002002004100802ULL, 0x30010002084c0007ULL, 0x0888221800813004ULL,
+  0x4000002840840112ULL
+};
 
-  if (l >= SCL_RECORD_MAX_LENGTH)
-    return 0;
+static const SCL_Bitboard _SCL_bishopMagicNumbers[SCL_BOARD_SQUARES] =
+{
+  0xa010041108003100ULL, 0x006082020a002900ULL, 0x6810010619200000ULL,
+  0x08281a0520000408ULL, 0x0001104001000400ULL, 0x0018901008048400ULL,
+  0x00040a0210245280ULL, 0x000200210808a402ULL, 0x9140048410821200ULL,
+  0x0800091010820041ULL, 0x20504804832202c0ULL, 0x0100091401081000ULL,
+  0x8021011140000012ULL, 0x0810020804450400ULL, 0x208b0542109008a2ULL,
+  0x0080084a08040204ULL, 0x0040e2a80811244cULL, 0x2505022008008108ULL,
+  0x0430220100420040ULL, 0x010a040420220040ULL, 0x1105000290400000ULL,
+  0x0093001200822120ULL, 0x4000a62048043004ULL, 0x280120048a015004ULL,
+  0x006090002a020814ULL, 0x44042000240800d0ULL, 0x01102800040a4400ULL,
+  0x1004080080220040ULL, 0x0001001011004024ULL, 0x0010044000805040ULL,
+  0x0914041200820100ULL, 0x0004821012821480ULL, 0x0024040500c05021ULL,
+  0x0088611002080200ULL, 0x0116080a00040020ULL, 0x4000020080080080ULL,
+  0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL,
+  0x8081110600002e00ULL, 0x2842101105000801ULL, 0x1100809008001025ULL,
+  0x00020202221c0400ULL, 0x0422014022009020ULL, 0x0210046102100c00ULL,
+  0xc004008082029102ULL, 0x00aa461801101200ULL, 0x0404080080201108ULL,
+  0x020542108c205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL,
+  0x0400200042021100ULL, 0x00004204850400c0ULL, 0x0200100410a42102ULL,
+  0x1040020801210102ULL, 0x0805040410420000ULL, 0x2884804130100200ULL,
+  0x800c262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+  0x0104000012a02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL,
+  0x0402020801010201ULL
+};
 
-  l *= 2;
+typedef struct
+{
+  SCL_Bitboard mask;          ///< relevant occupancy (without board edges)
+  SCL_Bitboard magic;
+  SCL_Bitboard *attacks;      ///< this square's part of the attack table
+  uint8_t shift;
+} _SCL_Magic;
 
-  if (l != 0)
-    r[l - 2] &= 0x3f; // remove the end flag from previous item
+_SCL_Magic _SCL_rookMagics[SCL_BOARD_SQUARES];
+_SCL_Magic _SCL_bishopMagics[SCL_BOARD_SQUARES];
 
-  if (endState == SCL_RECORD_CONT)
-    endState = SCL_RECORD_END;
+SCL_Bitboard _SCL_rookTable[102400];
+SCL_Bitboard _SCL_bishopTable[5248];
 
-  r[l] = squareFrom | endState;
+#ifndef SCL_PEXT
+  /**
+    If set, slider attack tables will be indexed with the PEXT instruction
+    instead of magic multiplication if the CPU supports it (x86 BMI2). This is
+    usually faster, but not on older AMD CPUs (before Zen 3) which execute PEXT
+    very slowly, so there it's better to turn this off.
+  */
+  #define SCL_PEXT 1
+#endif
 
-  uint8_t p;
+#if SCL_PEXT && defined(__BMI2__) && defined(__x86_64__)
+  // compiling for BMI2, no need to check the CPU at runtime
+  #define _SCL_PEXT_ALWAYS 1
+  #define _SCL_PEXT_AVAILABLE 1
+#elif SCL_PEXT && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+  #define _SCL_PEXT_ALWAYS 0
+  #define _SCL_PEXT_AVAILABLE 1
+#else
+  #define _SCL_PEXT_ALWAYS 0
+  #define _SCL_PEXT_AVAILABLE 0
+#endif
 
-  switch (promotePiece)
-  {
-    case 'n': case 'N': p = SCL_RECORD_PROM_N; break;
-    case 'b': case 'B': p = SCL_RECORD_PROM_B; break;
-    case 'r': case 'R': p = SCL_RECORD_PROM_R; break;
-    case 'q': case 'Q':
-    default:            p = SCL_RECORD_PROM_Q; break;
-  }
+uint8_t _SCL_usePext = _SCL_PEXT_ALWAYS; ///< decided by SCL_init at runtime
 
-  l++;
+#if _SCL_PEXT_AVAILABLE
+#if !_SCL_PEXT_ALWAYS
+__attribute__((target("bmi2")))
+#endif
+static inline SCL_Bitboard _SCL_pext(SCL_Bitboard value, SCL_Bitboard mask)
+{
+  return __builtin_ia32_pext_di(value,mask);
+}
+#endif
 
-  r[l] = squareTo | p;
+static inline SCL_Bitboard _SCL_magicLookup(const _SCL_Magic *magic,
+  SCL_Bitboard occupied)
+{
+#if _SCL_PEXT_ALWAYS
+  return magic->attacks[_SCL_pext(occupied,magic->mask)];
+#else
+#if _SCL_PEXT_AVAILABLE
+  if (_SCL_usePext)
+    return magic->attacks[_SCL_pext(occupied,magic->mask)];
+#endif
 
-  return 1;
+  return magic->attacks[
+    ((occupied & magic->mask) * magic->magic) >> magic->shift];
+#endif
 }
+#endif // SCL_SLIDER_TABLES
 
-uint8_t SCL_recordRemoveLast(SCL_Record r)
+uint8_t _SCL_initialized = 0;
+
+/** Zobrist keys of white P N B R Q K, black p n b r q k and last all zero ones
+  for empty square, indexed by _SCL_zobristPieceIndex. */
+uint64_t _SCL_zobristPieces[13][SCL_BOARD_SQUARES];
+uint8_t _SCL_zobristPieceIndex[128];
+uint64_t _SCL_zobristCastling[16];
+uint64_t _SCL_zobristEnPassant[8];
+uint64_t _SCL_zobristBlack;
+
+/**
+  Piece-square tables in 1/512 of a pawn for white, from a8 to h1 (i.e. as the
+  board is seen by white): pawn opening, pawn endgame, knight, bishop, rook,
+  queen (the same for both phases), king opening and king endgame. Larger
+  values (e.g. the usual hundredths of a pawn) were found to play worse with
+  the search as they outweigh material too often.
+*/
+static const int8_t _SCL_pieceSquareTables[8][SCL_BOARD_SQUARES] =
 {
-  uint16_t l = SCL_recordLength(r);
+  {   0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0 },
+  {   0,   0,   0,   0,   0,   0,   0,   0,
+     80,  80,  80,  80,  80,  80,  80,  80,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     15,  15,  15,  15,  15,  15,  15,  15,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0 },
+  { -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50 },
+  { -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20 },
+  {   0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0 },
+  { -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20 },
+  { -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20 },
+  { -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50 }
+};
 
-  if (l == 0)
-    return 0;
+/** Game phase weights of P N B R Q K, the start position has 24. */
+static const uint8_t _SCL_phaseWeights[6] = {0, 1, 1, 2, 4, 0};
 
-  if (l == 1)
-    SCL_recordInit(r);
-  else
-  {
-    l = (l - 2) * 2;
+#define _SCL_PHASE_MAX 24
 
-    r[l] = (r[l] & 0x3f) | SCL_RECORD_END;
-  }
+/**
+  Material plus piece-square score of each piece (as indexed by
+  _SCL_zobristPieceIndex) on each square, for the opening and endgame,
+  negative for black pieces.
+*/
+int16_t _SCL_pieceSquareScores[12][SCL_BOARD_SQUARES][2];
 
-  return 1;
+#if SCL_NNUE
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+  (defined(__GNUC__) || defined(__clang__))
+  #include <immintrin.h>
+  #define _SCL_NNUE_X86 1
+#else
+  #define _SCL_NNUE_X86 0
+#endif
+
+#if defined(__ARM_NEON) && defined(__aarch64__)
+  #include <arm_neon.h>
+  #define _SCL_NNUE_ARM 1
+#else
+  #define _SCL_NNUE_ARM 0
+#endif
+
+#define _SCL_NNUE_MAX_SCORE (SCL_EVALUATION_MAX_SCORE / 2)
+
+/* Each instruction set has a function adding (sign 1) or subtracting (sign -1)
+   a row of feature weights to/from an accumulator, and one computing the
+   output of a perspective, i.e. the sum of its clipped neurons times weights.
+   Products of two neurons with weights fit in 16 bits, so the SIMD versions
+   give the same results as the scalar ones. */
+
+static void _SCL_nnueAddScalar(int16_t *values, const int16_t *row,
+  int8_t sign)
+{
+  if (sign > 0) // separate loops for the compiler to vectorize
+    for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; ++i)
+      values[i] += row[i];
+  else
+    for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; ++i)
+      values[i] -= row[i];
 }
 
-void SCL_recordApply(const SCL_Record r, SCL_Board b, uint16_t moves)
+static int32_t _SCL_nnueOutputScalar(const int16_t *values,
+  const int8_t *weights)
 {
-  SCL_boardInit(b);
+  int32_t sum = 0;
 
-  uint16_t l = SCL_recordLength(r);
+  for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; ++i)
+    sum += (values[i] < 0 ? 0 : (values[i] > 127 ? 127 : values[i])) *
+      weights[i];
 
-  if (moves > l)
-    moves = l;
+  return sum;
+}
 
-  for (uint16_t i = 0; i < moves; ++i)
+#if _SCL_NNUE_X86
+__attribute__((target("sse4.1")))
+static void _SCL_nnueAddSSE41(int16_t *values, const int16_t *row,
+  int8_t sign)
+{
+  for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; i += 8)
   {
-    uint8_t s0, s1;
-    char p;
+    __m128i v = _mm_loadu_si128((const __m128i *) (values + i));
+    __m128i r = _mm_loadu_si128((const __m128i *) (row + i));
 
-     SCL_recordGetMove(r,i,&s0,&s1,&p);
-     SCL_boardMakeMove(b,s0,s1,p);
+    v = sign > 0 ? _mm_add_epi16(v,r) : _mm_sub_epi16(v,r);
+    _mm_storeu_si128((__m128i *) (values + i),v);
   }
 }
 
-void SCL_boardUndoMove(SCL_Board board, SCL_MoveUndo moveUndo)
+__attribute__((target("sse4.1")))
+static int32_t _SCL_nnueOutputSSE41(const int16_t *values,
+  const int8_t *weights)
 {
-#if SCL_960_CASTLING
-  char squareToNow = board[moveUndo.squareTo];
-#endif
-
-  board[moveUndo.squareFrom] = board[moveUndo.squareTo];
-  board[moveUndo.squareTo] = moveUndo.other & 0x7f;
-  board[SCL_BOARD_PLY_BYTE]--;
-  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] = moveUndo.enPassantCastle;
-  board[SCL_BOARD_MOVE_COUNT_BYTE] = moveUndo.moveCount;
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+  __m128i sum = zero;
 
-  if (moveUndo.other & 0x80)
+  for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; i += 16)
   {
-    moveUndo.squareTo /= 8;
+    // pack to 8 bits with saturation, which clips at 127, then clip at 0
+    __m128i v = _mm_max_epi8(_mm_packs_epi16(
+      _mm_loadu_si128((const __m128i *) (values + i)),
+      _mm_loadu_si128((const __m128i *) (values + i + 8))),zero);
 
-    if (moveUndo.squareTo == 0 || moveUndo.squareTo == 7)
-      board[moveUndo.squareFrom] = SCL_pieceIsWhite(board[moveUndo.squareFrom])
-        ? 'P' : 'p';
-      // ^ was promotion
-    else
-      board[(moveUndo.squareFrom / 8) * 8 + (moveUndo.enPassantCastle & 0x0f)] =
-        (board[moveUndo.squareFrom] == 'P') ? 'p' : 'P'; // was en passant
-  }
-#if !SCL_960_CASTLING
-  else if (board[moveUndo.squareFrom] == 'k' && // black castling
-    moveUndo.squareFrom == 60)
-  {
-    if (moveUndo.squareTo == 58)
-    {
-      board[59] = '.';
-      board[56] = 'r';
-    }
-    else if (moveUndo.squareTo == 62)
-    {
-      board[61] = '.';
-      board[63] = 'r';
-    }
-  }
-  else if (board[moveUndo.squareFrom] == 'K' && // white castling
-    moveUndo.squareFrom == 4)
-  {
-    if (moveUndo.squareTo == 2)
-    {
-      board[3] = '.';
-      board[0] = 'R';
-    }
-    else if (moveUndo.squareTo == 6)
-    {
-      board[5] = '.';
-      board[7] = 'R';
-    }
+    v = _mm_maddubs_epi16(v,_mm_loadu_si128((const __m128i *) (weights + i)));
+    sum = _mm_add_epi32(sum,_mm_madd_epi16(v,ones));
   }
-#else // 960 castling
-  else if (((moveUndo.other & 0x7f) == 'r') && // black castling
-    (squareToNow == '.' || !SCL_pieceIsWhite(squareToNow)))
-  {
-    board[moveUndo.squareTo < moveUndo.squareFrom ? 59 : 61] = '.';
-    board[moveUndo.squareTo < moveUndo.squareFrom ? 58 : 62] = '.';
 
-    board[moveUndo.squareFrom] = 'k';
-    board[moveUndo.squareTo] = 'r';
-  }
-  else if (((moveUndo.other & 0x7f) == 'R') && // white castling
-    (squareToNow == '.' || SCL_pieceIsWhite(squareToNow)))
-  {
-    board[moveUndo.squareTo < moveUndo.squareFrom ? 3 : 5] = '.';
-    board[moveUndo.squareTo < moveUndo.squareFrom ? 2 : 6] = '.';
+  sum = _mm_add_epi32(sum,_mm_shuffle_epi32(sum,0x4e));
+  sum = _mm_add_epi32(sum,_mm_shuffle_epi32(sum,0xb1));
 
-    board[moveUndo.squareFrom] = 'K';
-    board[moveUndo.squareTo] = 'R';
-  }
-#endif
+  return _mm_cvtsi128_si32(sum);
 }
 
-/**
-  Potentially disables castling rights according to whether something moved from
-  or to a square with a rook.
-*/
-void _SCL_handleRookActivity(SCL_Board board, uint8_t rookSquare)
+__attribute__((target("avx2")))
+static void _SCL_nnueAddAVX2(int16_t *values, const int16_t *row,
+  int8_t sign)
 {
-#if !SCL_960_CASTLING
-  switch (rookSquare)
+  for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; i += 16)
   {
-    case 0:  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x20; break;
-    case 7:  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x10; break;
-    case 56: board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x80; break;
-    case 63: board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x40; break;
-    default: break;
+    __m256i v = _mm256_loadu_si256((const __m256i *) (values + i));
+    __m256i r = _mm256_loadu_si256((const __m256i *) (row + i));
+
+    v = sign > 0 ? _mm256_add_epi16(v,r) : _mm256_sub_epi16(v,r);
+    _mm256_storeu_si256((__m256i *) (values + i),v);
   }
-#else // 960 castling
-  if (rookSquare == (board[SCL_BOARD_EXTRA_BYTE] & 0x07))
-    board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x20;
-  else if (rookSquare == (board[SCL_BOARD_EXTRA_BYTE] >> 3))
-    board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x10;
-  else if (rookSquare == 56 + (board[SCL_BOARD_EXTRA_BYTE] & 0x07))
-    board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x80;
-  else if (rookSquare == 56 + (board[SCL_BOARD_EXTRA_BYTE] >> 3))
-    board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x40;
-#endif
 }
 
-SCL_MoveUndo SCL_boardMakeMove(SCL_Board board, uint8_t squareFrom, uint8_t squareTo,
-  char promotePiece)
+__attribute__((target("avx2")))
+static int32_t _SCL_nnueOutputAVX2(const int16_t *values,
+  const int8_t *weights)
 {
-  char s = board[squareFrom];
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i sum = zero;
 
-  SCL_MoveUndo moveUndo;
-
-  moveUndo.squareFrom = squareFrom;
-  moveUndo.squareTo = squareTo;
-  moveUndo.moveCount = board[SCL_BOARD_MOVE_COUNT_BYTE];
-  moveUndo.enPassantCastle = board[SCL_BOARD_ENPASSANT_CASTLE_BYTE];
-  moveUndo.other = board[squareTo];
+  for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; i += 32)
+  {
+    /* packing works within 128 bit lanes, the permutation puts the values
+       back in order */
+    __m256i v = _mm256_max_epi8(_mm256_permute4x64_epi64(_mm256_packs_epi16(
+      _mm256_loadu_si256((const __m256i *) (values + i)),
+      _mm256_loadu_si256((const __m256i *) (values + i + 16))),0xd8),zero);
+
+    v = _mm256_maddubs_epi16(v,
+      _mm256_loadu_si256((const __m256i *) (weights + i)));
+    sum = _mm256_add_epi32(sum,_mm256_madd_epi16(v,ones));
+  }
 
-  // reset the en-passant state
-  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] |= 0x0f;
+  __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+    _mm256_extracti128_si256(sum,1));
 
-  if (SCL_boardMoveResetsCount(board,squareFrom,squareTo))
-    board[SCL_BOARD_MOVE_COUNT_BYTE] = 0;
-  else
-    board[SCL_BOARD_MOVE_COUNT_BYTE]++;
+  half = _mm_add_epi32(half,_mm_shuffle_epi32(half,0x4e));
+  half = _mm_add_epi32(half,_mm_shuffle_epi32(half,0xb1));
 
-#if SCL_960_CASTLING
-  uint8_t castled = 0;
+  return _mm_cvtsi128_si32(half);
+}
 #endif
 
-  if ((s == 'k') || (s == 'K'))
+#if _SCL_NNUE_ARM
+static void _SCL_nnueAddNEON(int16_t *values, const int16_t *row,
+  int8_t sign)
+{
+  for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; i += 8)
   {
-#if !SCL_960_CASTLING
-    if ((squareFrom == 4) || (squareFrom == 60)) // check castling
-    {
-      int8_t difference = squareTo - squareFrom;
+    int16x8_t v = vld1q_s16(values + i);
+    int16x8_t r = vld1q_s16(row + i);
 
-      char rook = SCL_pieceToColor('r',SCL_pieceIsWhite(s));
+    vst1q_s16(values + i,sign > 0 ? vaddq_s16(v,r) : vsubq_s16(v,r));
+  }
+}
 
-      if (difference == 2) // short
-      {
-        board[squareTo - 1] = rook;
-        board[squareTo + 1] = '.';
-      }
-      else if (difference == -2) // long
-      {
-        board[squareTo - 2] = '.';
-        board[squareTo + 1] = rook;
-      }
-    }
-#else // 960 castling
-    uint8_t isWhite = SCL_pieceIsWhite(s);
-    char rook = SCL_pieceToColor('r',isWhite);
+static int32_t _SCL_nnueOutputNEON(const int16_t *values,
+  const int8_t *weights)
+{
+  int32x4_t sum = vdupq_n_s32(0);
 
-    if (board[squareTo] == rook)
-    {
-      castled = 1;
+  for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; i += 16)
+  {
+    int8x16_t v = vmaxq_s8(vcombine_s8(vqmovn_s16(vld1q_s16(values + i)),
+      vqmovn_s16(vld1q_s16(values + i + 8))),vdupq_n_s8(0));
+    int8x16_t w = vld1q_s8(weights + i);
 
-      board[squareFrom] = '.';
-      board[squareTo] = '.';
+    int16x8_t products = vmull_s8(vget_low_s8(v),vget_low_s8(w));
+    products = vmlal_s8(products,vget_high_s8(v),vget_high_s8(w));
+    sum = vpadalq_s16(sum,products);
+  }
 
-      if (squareTo > squareFrom) // short
-      {
-        board[isWhite ? 6 : (56 + 6)] = s;
-        board[isWhite ? 5 : (56 + 5)] = rook;
-      }
-      else // long
-      {
-        board[isWhite ? 2 : (56 + 2)] = s;
-        board[isWhite ? 3 : (56 + 3)] = rook;
-      }
-    }
+  return vaddvq_s32(sum);
+}
 #endif
 
-    // after king move disable castling
-    board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= ~(0x03 << ((s == 'K') ? 4 : 6));
-  }
-  else if ((s == 'p') || (s == 'P'))
+static inline void _SCL_nnueAdd(int16_t *values, const int16_t *row,
+  int8_t sign)
+{
+  switch (SCL_nnueImplementation)
   {
-    uint8_t row = squareTo / 8;
-
-    int8_t rowDiff = squareFrom / 8 - row;
-
-    if (rowDiff == 2 || rowDiff == -2) // record en passant column
-    {
-      board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] =
-        (board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & 0xf0) | (squareFrom % 8);
-    }
-
-    if (row == 0 || row == 7)
-    {
-      // promotion
-      s = SCL_pieceToColor(promotePiece,SCL_pieceIsWhite(s));
-
-      moveUndo.other |= 0x80;
-    }
-    else
-    {
-      // check en passant move
-
-      int8_t columnDiff = (squareTo % 8) - (squareFrom % 8);
+#if _SCL_NNUE_X86
+    case SCL_NNUE_SSE41: _SCL_nnueAddSSE41(values,row,sign); break;
+    case SCL_NNUE_AVX2: _SCL_nnueAddAVX2(values,row,sign); break;
+#endif
+#if _SCL_NNUE_ARM
+    case SCL_NNUE_NEON: _SCL_nnueAddNEON(values,row,sign); break;
+#endif
+    default: _SCL_nnueAddScalar(values,row,sign); break;
+  }
+}
 
-      if ((columnDiff != 0) && (board[squareTo] == '.'))
-      {
-        board[squareFrom + columnDiff] = '.';
-        moveUndo.other |= 0x80;
-      }
-    }
+static inline int32_t _SCL_nnueOutput(const int16_t *values,
+  const int8_t *weights)
+{
+  switch (SCL_nnueImplementation)
+  {
+#if _SCL_NNUE_X86
+    case SCL_NNUE_SSE41: return _SCL_nnueOutputSSE41(values,weights); break;
+    case SCL_NNUE_AVX2: return _SCL_nnueOutputAVX2(values,weights); break;
+#endif
+#if _SCL_NNUE_ARM
+    case SCL_NNUE_NEON: return _SCL_nnueOutputNEON(values,weights); break;
+#endif
+    default: return _SCL_nnueOutputScalar(values,weights); break;
   }
-  else if ((s == 'r') || (s == 'R'))
-    _SCL_handleRookActivity(board,squareFrom);
+}
 
-  char taken = board[squareTo];
+uint8_t SCL_nnueSetImplementation(uint8_t implementation)
+{
+  uint8_t supported = implementation == SCL_NNUE_SCALAR;
 
-  // taking a rook may also disable castling:
+#if _SCL_NNUE_X86
+  __builtin_cpu_init();
 
-  if (taken == 'R' || taken == 'r')
-    _SCL_handleRookActivity(board,squareTo);
+  if (implementation == SCL_NNUE_SSE41)
+    supported = __builtin_cpu_supports("sse4.1") != 0;
+  else if (implementation == SCL_NNUE_AVX2)
+    supported = __builtin_cpu_supports("avx2") != 0;
+#endif
 
-#if SCL_960_CASTLING
-  if (!castled)
+#if _SCL_NNUE_ARM
+  if (implementation == SCL_NNUE_NEON)
+    supported = 1;
 #endif
-  {
-    board[squareTo] = s;
-    board[squareFrom] = '.';
-  }
 
-  board[SCL_BOARD_PLY_BYTE]++; // increase ply count
+  if (supported)
+    SCL_nnueImplementation = implementation;
 
-  return moveUndo;
+  return supported;
 }
 
-void SCL_boardSetPosition(SCL_Board board, const char *pieces,
-  uint8_t castlingEnPassant, uint8_t moveCount, uint8_t ply)
+const char *SCL_nnueImplementationName(uint8_t implementation)
 {
-  for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i, pieces++)
-    if (*pieces != 0)
-      board[i] = *pieces;
-    else
-      break;
-
-  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] = castlingEnPassant;
-  board[SCL_BOARD_PLY_BYTE] = ply;
-  board[SCL_BOARD_MOVE_COUNT_BYTE] = moveCount;
-  board[SCL_BOARD_STATE_SIZE - 1] = 0;
+  switch (implementation)
+  {
+    case SCL_NNUE_SSE41: return "SSE4.1"; break;
+    case SCL_NNUE_AVX2: return "AVX2"; break;
+    case SCL_NNUE_NEON: return "NEON"; break;
+    default: return "scalar"; break;
+  }
 }
 
-void SCL_squareSetAdd(SCL_SquareSet squareSet, uint8_t square)
+/**
+  Returns the king bucket of a perspective: king on the queen or king side and
+  on the first two ranks or further.
+*/
+static inline uint8_t _SCL_nnueKingBucket(uint8_t perspective,
+  uint8_t kingSquare)
 {
-  squareSet[square / 8] |= 0x01 << (square % 8);
+  if (perspective)
+    kingSquare ^= 56;
+
+  return (kingSquare % 8 >= 4) + 2 * (kingSquare >= 16);
 }
 
-uint8_t SCL_squareSetContains(const SCL_SquareSet squareSet, uint8_t square)
+/**
+  Returns the index of the input feature of a piece (indexed as by
+  _SCL_zobristPieceIndex) on given square seen from given perspective.
+*/
+static inline uint16_t _SCL_nnueFeature(uint8_t perspective, uint8_t bucket,
+  uint8_t piece, uint8_t square)
 {
-  return squareSet[square / 8] & (0x01 << (square % 8));
+  if (perspective)
+  {
+    piece = piece < 6 ? piece + 6 : piece - 6;
+    square ^= 56;
+  }
+
+  return (bucket * 12 + piece) * SCL_BOARD_SQUARES + square;
 }
 
-uint8_t SCL_squareSetSize(const SCL_SquareSet squareSet)
+/**
+  Adds (sign 1) or removes (sign -1) a piece, indexed as by
+  _SCL_zobristPieceIndex, to/from an accumulator. A king moving to another
+  bucket makes its perspective stale instead.
+*/
+static inline void _SCL_nnueUpdatePiece(SCL_NNUEAccumulator *accumulator,
+  uint8_t piece, uint8_t square, int8_t sign)
 {
-  uint8_t result = 0;
-
-  for (uint8_t i = 0; i < 8; ++i)
+  for (uint8_t p = 0; p < 2; ++p)
   {
-    uint8_t byte = squareSet[i];
+    if (accumulator->stale[p])
+      continue;
 
-    for (uint8_t j = 0; j < 8; ++j)
+    if (sign > 0 && piece == SCL_PIECE_KING + 6 * p &&
+      _SCL_nnueKingBucket(p,square) != accumulator->buckets[p])
     {
-      result += byte & 0x01;
-      byte >>= 1;
+      accumulator->stale[p] = 1;
+      continue;
     }
-  }
 
-  return result;
+    _SCL_nnueAdd(accumulator->values[p],SCL_nnueNetwork.featureWeights[
+      _SCL_nnueFeature(p,accumulator->buckets[p],piece,square)],sign);
+  }
 }
 
-uint8_t SCL_squareSetEmpty(const SCL_SquareSet squareSet)
+/**
+  Computes one perspective of a position's accumulator from scratch.
+*/
+void _SCL_nnueRefreshPerspective(SCL_Position *position, uint8_t perspective)
 {
-  for (uint8_t i = 0; i < 8; ++i)
-    if (squareSet[i] != 0)
-      return 0;
+  SCL_NNUEAccumulator *accumulator = &position->nnue;
+  SCL_Bitboard king =
+    position->pieces[SCL_PIECE_KING] & position->colors[perspective];
+  uint8_t bucket =
+    _SCL_nnueKingBucket(perspective,king != 0 ? SCL_bitboardFirst(king) : 0);
 
-  return 1;
+  for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; ++i)
+    accumulator->values[perspective][i] = SCL_nnueNetwork.featureBiases[i];
+
+  for (uint8_t piece = 0; piece < 12; ++piece)
+  {
+    SCL_Bitboard b =
+      position->pieces[piece % 6] & position->colors[piece / 6];
+
+    while (b != 0)
+    {
+      uint8_t square = SCL_bitboardFirst(b);
+
+      b &= b - 1;
+
+      _SCL_nnueAdd(accumulator->values[perspective],
+        SCL_nnueNetwork.featureWeights[
+        _SCL_nnueFeature(perspective,bucket,piece,square)],1);
+    }
+  }
+
+  accumulator->buckets[perspective] = bucket;
+  accumulator->stale[perspective] = 0;
 }
 
-uint8_t SCL_squareSetGetRandom(
-  const SCL_SquareSet squareSet, SCL_RandomFunction randFunc)
+void SCL_positionNNUERefresh(SCL_Position *position)
 {
-  uint8_t size = SCL_squareSetSize(squareSet);
+  position->nnue.active = 1;
+  _SCL_nnueRefreshPerspective(position,0);
+  _SCL_nnueRefreshPerspective(position,1);
+}
 
-  if (size == 0)
-    return 0;
+/**
+  Makes the default network, needs the piece-square scores.
+*/
+void _SCL_nnueDefaultNetwork(SCL_NNUENetwork *network)
+{
+  /* For each piece type the perspective's neuron 2 * type counts its pieces
+     and neuron 2 * type + 1 sums their piece-square scores around 64, the
+     opponent's pieces are left to the other perspective. */
 
-  uint8_t n = (randFunc() % size) + 1;
-  uint8_t i = 0;
+  const int16_t values[6] = {SCL_VALUE_PAWN, SCL_VALUE_KNIGHT,
+    SCL_VALUE_BISHOP, SCL_VALUE_ROOK, SCL_VALUE_QUEEN, SCL_VALUE_KING};
 
-  while (i < SCL_BOARD_SQUARES)
+  const uint8_t squareSteps[6] = {2, 1, 1, 1, 1, 1}; // for 8 pawns to fit
+
+  for (uint16_t f = 0; f < SCL_NNUE_FEATURES; ++f)
+    for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; ++i)
+      network->featureWeights[f][i] = 0;
+
+  for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; ++i)
   {
-    if (SCL_squareSetContains(squareSet,i))
-    {
-      n--;
+    network->featureBiases[i] = 0;
+    network->outputWeights[i] = 0;
+    network->outputWeights[SCL_NNUE_HIDDEN + i] = 0;
+  }
 
-      if (n == 0)
-        break;
-    }
+  for (uint8_t t = 0; t < 6; ++t)
+  {
+    int16_t count = 1; // weight of one piece for the count to fit 8 bits
 
-    ++i;
+    while (values[t] / count > 127)
+      count *= 2;
+
+    network->featureBiases[2 * t + 1] = 64;
+
+    network->outputWeights[2 * t] = values[t] / count;
+    network->outputWeights[2 * t + 1] = squareSteps[t];
+    network->outputWeights[SCL_NNUE_HIDDEN + 2 * t] = -1 * values[t] / count;
+    network->outputWeights[SCL_NNUE_HIDDEN + 2 * t + 1] = -1 * squareSteps[t];
+
+    for (uint8_t b = 0; b < SCL_NNUE_KING_BUCKETS; ++b)
+      for (uint8_t s = 0; s < SCL_BOARD_SQUARES; ++s)
+      {
+        int16_t *weights =
+          network->featureWeights[_SCL_nnueFeature(0,b,t,s)];
+
+        weights[2 * t] = count;
+        weights[2 * t + 1] = ((_SCL_pieceSquareScores[t][s][0] +
+          _SCL_pieceSquareScores[t][s][1]) / 2 - values[t]) / squareSteps[t];
+      }
   }
 
-  return i;
+  network->outputBias = 0;
+  network->outputDivisor = 1;
 }
 
-void SCL_boardCopy(const SCL_Board boardFrom, SCL_Board boardTo)
+void SCL_nnueDefaultNetwork(SCL_NNUENetwork *network)
 {
-  for (uint8_t i = 0; i < SCL_BOARD_STATE_SIZE; ++i)
-    boardTo[i] = boardFrom[i];
+  SCL_init();
+  _SCL_nnueDefaultNetwork(network);
 }
 
-uint8_t SCL_boardSquareAttacked(
-  SCL_Board board,
-  uint8_t square,
-  uint8_t byWhite)
+static inline uint32_t _SCL_nnueRead(const uint8_t *data, uint8_t bytes)
 {
-  const char *currentSquare = board;
+  uint32_t result = 0;
 
-  /* We need to place a temporary piece on the tested square in order to test if
-     the square is attacked (consider testing if attacked by a pawn). */
+  for (uint8_t i = 0; i < bytes; ++i)
+    result |= ((uint32_t) data[i]) << (8 * i);
 
-  char previous = board[square];
+  return result;
+}
 
-  board[square] = SCL_pieceToColor('r',!byWhite);
+static inline uint8_t *_SCL_nnueWrite(uint8_t *data, uint32_t value,
+  uint8_t bytes)
+{
+  for (uint8_t i = 0; i < bytes; ++i)
+    data[i] = (value >> (8 * i)) & 0xff;
 
-  for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i, ++currentSquare)
-  {
-    char s = *currentSquare;
+  return data + bytes;
+}
 
-    if ((s == '.') || (SCL_pieceIsWhite(s) != byWhite))
-      continue;
+uint8_t SCL_nnueLoad(SCL_NNUENetwork *network, const uint8_t *data,
+  uint32_t size)
+{
+  SCL_init();
+
+  if (size != SCL_NNUE_FILE_SIZE)
+    return 0;
 
-    SCL_SquareSet moves;
-    SCL_boardGetPseudoMoves(board,i,0,moves);
+  for (uint8_t i = 0; i < 8; ++i)
+    if (data[i] != "SCLNNUE1"[i])
+      return 0;
 
-    if (SCL_squareSetContains(moves,square))
-    {
-      board[square] = previous;
-      return 1;
-    }
+  if (_SCL_nnueRead(data + 8,4) != SCL_NNUE_FEATURES ||
+    _SCL_nnueRead(data + 12,4) != SCL_NNUE_HIDDEN ||
+    (int32_t) _SCL_nnueRead(data + 16,4) <= 0)
+    return 0;
+
+  network->outputDivisor = _SCL_nnueRead(data + 16,4);
+  data += 20;
+
+  for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; ++i, data += 2)
+    network->featureBiases[i] = _SCL_nnueRead(data,2);
+
+  for (uint16_t f = 0; f < SCL_NNUE_FEATURES; ++f)
+    for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; ++i, data += 2)
+      network->featureWeights[f][i] = _SCL_nnueRead(data,2);
+
+  for (uint16_t i = 0; i < 2 * SCL_NNUE_HIDDEN; ++i, data++)
+    network->outputWeights[i] = *data;
+
+  network->outputBias = _SCL_nnueRead(data,4);
+
+  if (network == &SCL_nnueNetwork)
+  {
+    // the stored scores are no longer right
+    SCL_transpositionTable.evaluationFunction = 0;
+    SCL_evaluationCache.evaluationFunction = 0;
   }
 
-  board[square] = previous;
-  return 0;
+  return 1;
 }
 
-uint8_t SCL_boardCheck(SCL_Board board,uint8_t white)
+void SCL_nnueSave(const SCL_NNUENetwork *network, uint8_t *data)
 {
-  const char *square = board;
-  char kingChar = white ? 'K' : 'k';
+  for (uint8_t i = 0; i < 8; ++i)
+    data[i] = "SCLNNUE1"[i];
 
-  for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i, ++square)
-    if ((*square == kingChar &&
-      SCL_boardSquareAttacked(board,i,!white)))
-        return 1;
+  data = _SCL_nnueWrite(data + 8,SCL_NNUE_FEATURES,4);
+  data = _SCL_nnueWrite(data,SCL_NNUE_HIDDEN,4);
+  data = _SCL_nnueWrite(data,network->outputDivisor,4);
 
-  return 0;
+  for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; ++i)
+    data = _SCL_nnueWrite(data,(uint16_t) network->featureBiases[i],2);
+
+  for (uint16_t f = 0; f < SCL_NNUE_FEATURES; ++f)
+    for (uint16_t i = 0; i < SCL_NNUE_HIDDEN; ++i)
+      data = _SCL_nnueWrite(data,(uint16_t) network->featureWeights[f][i],2);
+
+  for (uint16_t i = 0; i < 2 * SCL_NNUE_HIDDEN; ++i)
+    data = _SCL_nnueWrite(data,(uint8_t) network->outputWeights[i],1);
+
+  _SCL_nnueWrite(data,network->outputBias,4);
 }
+#endif
 
-uint8_t SCL_boardGameOver(SCL_Board board)
+/**
+  Returns a bitboard of squares offset from given square by given number of
+  columns and rows, or empty bitboard if the target is off board.
+*/
+SCL_Bitboard _SCL_bitboardOffset(uint8_t square, int8_t columns, int8_t rows)
 {
-  uint8_t position = SCL_boardGetPosition(board);
+  int8_t column = square % 8 + columns;
+  int8_t row = square / 8 + rows;
 
-  return (position == SCL_POSITION_MATE) ||
-         (position == SCL_POSITION_STALEMATE) ||
-         (position == SCL_POSITION_DEAD);
+  if (column < 0 || column > 7 || row < 0 || row > 7)
+    return 0;
+
+  return SCL_BITBOARD_SQUARE(row * 8 + column);
 }
 
-uint8_t SCL_boardMovePossible(SCL_Board board)
+/**
+  Gets attacks along one ray, stopping at the first blocker (which is included
+  in the attacks). This is slow and only used to fill the attack tables, or
+  instead of them with SCL_SLIDER_TABLES 0.
+*/
+SCL_Bitboard _SCL_rayAttacks(uint8_t square, SCL_Bitboard occupied,
+  uint8_t direction)
 {
-  uint8_t white = SCL_boardWhitesTurn(board);
+  SCL_Bitboard result = _SCL_rays[direction][square];
+  SCL_Bitboard blockers = result & occupied;
 
-  for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i)
-  {
-    char s = board[i];
+  if (blockers)
+    result ^= _SCL_rays[direction][direction < 4 ?
+      SCL_bitboardFirst(blockers) : _SCL_bitboardLast(blockers)];
+
+  return result;
+}
+
+#if SCL_SLIDER_TABLES
+/**
+  Fills the attack table of one slider on one square, directions are given as
+  bits of the directions parameter.
+*/
+SCL_Bitboard *_SCL_initMagic(_SCL_Magic *magic, uint8_t square,
+  SCL_Bitboard magicNumber, uint8_t directions, SCL_Bitboard *table)
+{
+  magic->mask = 0;
 
-    if ((s != '.') && (SCL_pieceIsWhite(s) == white))
+  for (uint8_t d = 0; d < 8; ++d)
+    if (directions & (0x01 << d))
     {
-      SCL_SquareSet moves;
+      SCL_Bitboard ray = _SCL_rays[d][square];
 
-      SCL_boardGetMoves(board,i,moves);
+      if (ray) // the last square of the ray doesn't affect the attacks
+        ray &= ~SCL_BITBOARD_SQUARE(d < 4 ?
+          _SCL_bitboardLast(ray) : SCL_bitboardFirst(ray));
 
-      if (SCL_squareSetSize(moves) != 0)
-        return 1;
+      magic->mask |= ray;
     }
-  }
 
-  return 0;
-}
+  magic->magic = magicNumber;
+  magic->shift = 64 - SCL_bitboardCount(magic->mask);
+  magic->attacks = table;
 
-uint8_t SCL_boardMate(SCL_Board board)
-{
-  return SCL_boardGetPosition(board) == SCL_POSITION_MATE;
+  SCL_Bitboard occupied = 0;
+  uint32_t count = 0;
+
+  do // go through all subsets of the mask
+  {
+    SCL_Bitboard attacks = 0;
+
+    for (uint8_t d = 0; d < 8; ++d)
+      if (directions & (0x01 << d))
+        attacks |= _SCL_rayAttacks(square,occupied,d);
+
+#if _SCL_PEXT_AVAILABLE
+    if (_SCL_usePext)
+      table[_SCL_pext(occupied,magic->mask)] = attacks;
+    else
+#endif
+      table[((occupied & magic->mask) * magicNumber) >> magic->shift] =
+        attacks;
+
+    occupied = (occupied - magic->mask) & magic->mask;
+    count++;
+  } while (occupied);
+
+  return table + count;
 }
+#endif
 
-void SCL_boardGetPseudoMoves(
-  SCL_Board board,
-  uint8_t pieceSquare,
-  uint8_t checkCastling,
-  SCL_SquareSet result)
+void SCL_init(void)
 {
-  char piece = board[pieceSquare];
+  if (_SCL_initialized)
+    return;
 
-  SCL_squareSetClear(result);
+  const int8_t knightOffsets[16] =
+    {1, 2, 2, 1, 2, -1, 1, -2, -1, -2, -2, -1, -2, 1, -1, 2};
 
-  uint8_t isWhite = SCL_pieceIsWhite(piece);
-  int8_t horizontalPosition = pieceSquare % 8;
-  int8_t pawnOffset = -8;
+  const int8_t rayColumns[8] = {0, 1, 1, -1,  0, -1, -1,  1};
+  const int8_t rayRows[8] =    {1, 0, 1,  1, -1,  0, -1, -1};
 
-  switch (piece)
+  for (uint8_t s = 0; s < SCL_BOARD_SQUARES; ++s)
   {
-    case 'P':
-      pawnOffset = 8;
-      // fall through
-    case 'p':
-    {
-      uint8_t square = pieceSquare + pawnOffset;
-      uint8_t verticalPosition = pieceSquare / 8;
-
-      if (board[square] == '.') // forward move
-      {
-        SCL_squareSetAdd(result,square);
+    _SCL_knightAttacks[s] = 0;
+    _SCL_kingAttacks[s] = 0;
 
-        if (verticalPosition == (1 + (piece == 'p') * 5)) // start position?
-        {
-          uint8_t square2 = square + pawnOffset;
+    for (uint8_t i = 0; i < 16; i += 2)
+      _SCL_knightAttacks[s] |=
+        _SCL_bitboardOffset(s,knightOffsets[i],knightOffsets[i + 1]);
 
-          if (board[square2] == '.')
-            SCL_squareSetAdd(result,square2);
-        }
-      }
+    for (int8_t c = -1; c <= 1; ++c)
+      for (int8_t r = -1; r <= 1; ++r)
+        if (c != 0 || r != 0)
+          _SCL_kingAttacks[s] |= _SCL_bitboardOffset(s,c,r);
 
-      #define checkDiagonal(hor,add) \
-        if (horizontalPosition != hor) \
-        { \
-          uint8_t square2 = square + add; \
-          char c = board[square2]; \
-          if (c != '.' && SCL_pieceIsWhite(c) != isWhite) \
-            SCL_squareSetAdd(result,square2); \
-        }
+    _SCL_pawnAttacks[0][s] =
+      _SCL_bitboardOffset(s,-1,1) | _SCL_bitboardOffset(s,1,1);
 
-      // diagonal moves
-      checkDiagonal(0,-1)
-      checkDiagonal(7,1)
+    _SCL_pawnAttacks[1][s] =
+      _SCL_bitboardOffset(s,-1,-1) | _SCL_bitboardOffset(s,1,-1);
 
-      uint8_t enPassantRow = 4;
-      uint8_t enemyPawn = 'p';
+    for (uint8_t d = 0; d < 8; ++d)
+    {
+      SCL_Bitboard ray = 0;
+      uint8_t square = s;
 
-      if (piece == 'p')
+      while (1)
       {
-        enPassantRow = 3;
-        enemyPawn = 'P';
-      }
+        SCL_Bitboard next =
+          _SCL_bitboardOffset(square,rayColumns[d],rayRows[d]);
 
-      // en-passant moves
-      if (verticalPosition == enPassantRow)
-      {
-        uint8_t enPassantColumn = board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & 0x0f;
-        uint8_t column = pieceSquare % 8;
+        if (next == 0)
+          break;
 
-        for (int8_t offset = -1; offset < 2; offset += 2)
-          if ((enPassantColumn == column + offset) &&
-              (board[pieceSquare + offset] == enemyPawn))
-          {
-            SCL_squareSetAdd(result,pieceSquare + pawnOffset + offset);
-            break;
-          }
+        ray |= next;
+        square = SCL_bitboardFirst(next);
       }
 
-      #undef checkDiagonal
+      _SCL_rays[d][s] = ray;
     }
-      break;
+  }
 
-    case 'r': // rook
-    case 'R':
-    case 'b': // bishop
-    case 'B':
-    case 'q': // queen
-    case 'Q':
+#if SCL_SLIDER_TABLES
+  for (uint8_t s = 0; s < SCL_BOARD_SQUARES; ++s)
+    for (uint8_t s2 = 0; s2 < SCL_BOARD_SQUARES; ++s2)
     {
-      const int8_t offsets[8] =    {-8, 1, 8, -1, -7, 9, -9, 7};
-      const int8_t columnDirs[8] = { 0, 1, 0, -1,  1, 1, -1,-1};
+      _SCL_between[s][s2] = 0;
+      _SCL_lines[s][s2] = 0;
 
-      uint8_t from = (piece == 'b' || piece == 'B') * 4;
-      uint8_t to = 4 + (piece != 'r' && piece != 'R') * 4;
+      for (uint8_t d = 0; d < 8; ++d)
+        if (_SCL_rays[d][s] & SCL_BITBOARD_SQUARE(s2))
+        {
+          _SCL_between[s][s2] = _SCL_rays[d][s] & ~_SCL_rays[d][s2] &
+            ~SCL_BITBOARD_SQUARE(s2);
 
-      for (uint8_t i = from; i < to; ++i)
-      {
-        int8_t offset = offsets[i];
-        int8_t columnDir = columnDirs[i];
-        int8_t square = pieceSquare;
-        int8_t col = horizontalPosition;
+          _SCL_lines[s][s2] = _SCL_rays[d][s] | _SCL_rays[d ^ 4][s] |
+            SCL_BITBOARD_SQUARE(s);
+        }
+    }
 
-        while (1)
-        {
-          square += offset;
-          col += columnDir;
+#if _SCL_PEXT_AVAILABLE && !_SCL_PEXT_ALWAYS
+  __builtin_cpu_init();
+  _SCL_usePext = __builtin_cpu_supports("bmi2") != 0;
+#endif
 
-          if (square < 0 || square > 63 || col < 0 || col > 7)
-            break;
+  SCL_Bitboard *rookTable = _SCL_rookTable;
+  SCL_Bitboard *bishopTable = _SCL_bishopTable;
 
-          char squareC = board[square];
+  for (uint8_t s = 0; s < SCL_BOARD_SQUARES; ++s)
+  {
+    rookTable = _SCL_initMagic(_SCL_rookMagics + s,s,
+      _SCL_rookMagicNumbers[s],0x33,rookTable);
 
-          if (squareC == '.')
-            SCL_squareSetAdd(result,square);
-          else
-          {
-            if (SCL_pieceIsWhite(squareC) != isWhite)
-              SCL_squareSetAdd(result,square);
+    bishopTable = _SCL_initMagic(_SCL_bishopMagics + s,s,
+      _SCL_bishopMagicNumbers[s],0xcc,bishopTable);
+  }
+#endif
 
-            break;
-          }
-        }
-      }
-    }
-      break;
+  /* Zobrist keys are made with splitmix64, fixed seed so that the keys are the
+     same in every run (SCL_BOARD_START_STATE contains the start key). */
 
-    case 'n': // knight
-    case 'N':
+  uint64_t random = 0;
+
+  #define nextRandom(r) \
+    random += 0x9e3779b97f4a7c15;\
+    r = random;\
+    r = (r ^ (r >> 30)) * 0xbf58476d1ce4e5b9;\
+    r = (r ^ (r >> 27)) * 0x94d049bb133111eb;\
+    r ^= r >> 31;
+
+  for (uint8_t p = 0; p < 12; ++p)
+    for (uint8_t s = 0; s < SCL_BOARD_SQUARES; ++s)
     {
-      const int8_t offsets[4] = {6, 10, 15, 17};
-      const int8_t columnsMinus[4] = {2,-2,1,-1};
-      const int8_t columnsPlus[4] = {-2,2,-1,1};
-      const int8_t *off, *col;
+      nextRandom(_SCL_zobristPieces[p][s])
+    }
 
-      #define checkOffsets(op,comp,limit,dir)\
-        off = offsets;\
-        col = columns ## dir;\
-        for (uint8_t i = 0; i < 4; ++i, ++off, ++col)\
-        {\
-          int8_t square = pieceSquare op (*off);\
-          if (square comp limit) /* out of board? */\
-            break;\
-          int8_t horizontalCheck = horizontalPosition + (*col);\
-          if (horizontalCheck < 0 || horizontalCheck >= 8)\
-            continue;\
-          char squareC = board[square];\
-          if ((squareC == '.') || (SCL_pieceIsWhite(squareC) != isWhite))\
-            SCL_squareSetAdd(result,square);\
-        }
+  for (uint8_t s = 0; s < SCL_BOARD_SQUARES; ++s)
+    _SCL_zobristPieces[12][s] = 0;
 
-      checkOffsets(-,<,0,Minus)
-      checkOffsets(+,>=,SCL_BOARD_SQUARES,Plus)
+  for (uint8_t i = 0; i < 128; ++i)
+    _SCL_zobristPieceIndex[i] = 12;
 
-      #undef checkOffsets
-    }
-      break;
+  for (uint8_t i = 0; i < 12; ++i)
+    _SCL_zobristPieceIndex[(uint8_t) "PNBRQKpnbrqk"[i]] = i;
 
-    case 'k': // king
-    case 'K':
-    {
-      uint8_t verticalPosition = pieceSquare / 8;
+  for (uint8_t p = 0; p < 6; ++p)
+  {
+    const int16_t values[6] = {SCL_VALUE_PAWN, SCL_VALUE_KNIGHT,
+      SCL_VALUE_BISHOP, SCL_VALUE_ROOK, SCL_VALUE_QUEEN, SCL_VALUE_KING};
 
-      uint8_t
-        u = verticalPosition != 0,
-        d = verticalPosition != 7,
-        l = horizontalPosition != 0,
-        r = horizontalPosition != 7;
+    const uint8_t tables[6][2] =
+      {{0, 1}, {2, 2}, {3, 3}, {4, 4}, {5, 5}, {6, 7}};
 
-      uint8_t square2 = pieceSquare - 9;
+    for (uint8_t s = 0; s < SCL_BOARD_SQUARES; ++s)
+      for (uint8_t phase = 0; phase < 2; ++phase)
+      {
+        // tables go from a8, squares from a1, black sees the board flipped
 
-      #define checkSquare(cond,add) \
-        if (cond && ((board[square2] == '.') || \
-            (SCL_pieceIsWhite(board[square2])) != isWhite))\
-          SCL_squareSetAdd(result,square2);\
-        square2 += add;
+        int16_t score = values[p] +
+          ((int16_t) _SCL_pieceSquareTables[tables[p][phase]][s ^ 56]) *
+          SCL_VALUE_PAWN / 512;
 
-      checkSquare(l && u,1)
-      checkSquare(u,1)
-      checkSquare(r && u,6)
-      checkSquare(l,2)
-      checkSquare(r,6)
-      checkSquare(l && d,1)
-      checkSquare(d,1)
-      checkSquare(r && d,0)
+        _SCL_pieceSquareScores[p][s][phase] = score;
 
-      #undef checkSquare
+        score = values[p] +
+          ((int16_t) _SCL_pieceSquareTables[tables[p][phase]][s]) *
+          SCL_VALUE_PAWN / 512;
 
-      // castling:
+        _SCL_pieceSquareScores[p + 6][s][phase] = -1 * score;
+      }
+  }
 
-      if (checkCastling)
-      {
-        uint8_t bitShift = 4 + 2 * (!isWhite);
+#if SCL_NNUE
+  _SCL_nnueDefaultNetwork(&SCL_nnueNetwork);
 
-        if ((board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & (0x03 << bitShift)) &&
-          !SCL_boardSquareAttacked(board,pieceSquare,!isWhite)) // no check?
-        {
-#if !SCL_960_CASTLING
-          // short castle:
-          pieceSquare++;
+  for (uint8_t i = SCL_NNUE_SCALAR; i <= SCL_NNUE_NEON; ++i)
+    SCL_nnueSetImplementation(i); // the last supported one stays
+#endif
 
-          if ((board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & (0x01 << bitShift)) &&
-              (board[pieceSquare] == '.') &&
-              (board[pieceSquare + 1] == '.') &&
-              (board[pieceSquare + 2] == SCL_pieceToColor('r',isWhite)) &&
-              !SCL_boardSquareAttacked(board,pieceSquare,!isWhite))
-            SCL_squareSetAdd(result,pieceSquare + 1);
+  _SCL_zobristCastling[0] = 0;
 
-          /* note: don't check the final square for check, it will potentially
-             be removed later (can't end up in check) */
+  for (uint8_t i = 0; i < 4; ++i)
+  {
+    nextRandom(_SCL_zobristCastling[1 << i])
+  }
 
-          // long castle:
-          pieceSquare -= 2;
+  for (uint8_t i = 1; i < 16; ++i) // combinations of the single rights
+    _SCL_zobristCastling[i] = _SCL_zobristCastling[i & (i - 1)] ^
+      _SCL_zobristCastling[i & ~(i - 1)];
 
-          if ((board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & (0x02 << bitShift)) &&
-              (board[pieceSquare] == '.') &&
-              (board[pieceSquare - 1] == '.') &&
-              (board[pieceSquare - 2] == '.') &&
-              (board[pieceSquare - 3] == SCL_pieceToColor('r',isWhite)) &&
-              !SCL_boardSquareAttacked(board,pieceSquare,!isWhite))
-            SCL_squareSetAdd(result,pieceSquare - 1);
-#else // 960 castling
-          for (int i = 0; i < 2; ++i) // short and long
-            if (board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & ((i + 1) << bitShift))
-            {
-              uint8_t
-                rookPos = board[SCL_BOARD_EXTRA_BYTE] >> 3,
-                targetPos = 5;
+  for (uint8_t i = 0; i < 8; ++i)
+  {
+    nextRandom(_SCL_zobristEnPassant[i])
+  }
 
-              if (i == 1)
-              {
-                rookPos = board[SCL_BOARD_EXTRA_BYTE] & 0x07,
-                targetPos = 3;
-              }
+  nextRandom(_SCL_zobristBlack)
 
-              if (!isWhite)
-              {
-                rookPos += 56;
-                targetPos += 56;
-              }
+  #undef nextRandom
 
-              uint8_t ok = board[rookPos] == SCL_pieceToColor('r',isWhite);
+  _SCL_initialized = 1;
 
-              if (!ok)
-                continue;
+  SCL_transpositionTableInit(&SCL_transpositionTable,
+    SCL_TRANSPOSITION_TABLE_SIZE);
+}
 
-              int8_t inc = 1 - 2 * (targetPos > rookPos);
+static inline SCL_Bitboard _SCL_rookAttacks(uint8_t square,
+  SCL_Bitboard occupied)
+{
+#if SCL_SLIDER_TABLES
+  return _SCL_magicLookup(_SCL_rookMagics + square,occupied);
+#else
+  return _SCL_rayAttacks(square,occupied,0) |
+    _SCL_rayAttacks(square,occupied,1) | _SCL_rayAttacks(square,occupied,4) |
+    _SCL_rayAttacks(square,occupied,5);
+#endif
+}
 
-              while (targetPos != rookPos) // check vacant squares for the rook
-              {
-                if (board[targetPos] != '.' &&
-                    targetPos != pieceSquare)
-                {
-                  ok = 0;
-                  break;
-                }
+static inline SCL_Bitboard _SCL_bishopAttacks(uint8_t square,
+  SCL_Bitboard occupied)
+{
+#if SCL_SLIDER_TABLES
+  return _SCL_magicLookup(_SCL_bishopMagics + square,occupied);
+#else
+  return _SCL_rayAttacks(square,occupied,2) |
+    _SCL_rayAttacks(square,occupied,3) | _SCL_rayAttacks(square,occupied,6) |
+    _SCL_rayAttacks(square,occupied,7);
+#endif
+}
 
-                targetPos += inc;
-              }
+/**
+  Squares strictly between two squares on the same line, otherwise empty.
+*/
+static inline SCL_Bitboard _SCL_squaresBetween(uint8_t square1,
+  uint8_t square2)
+{
+#if SCL_SLIDER_TABLES
+  return _SCL_between[square1][square2];
+#else
+  for (uint8_t d = 0; d < 8; ++d)
+    if (_SCL_rays[d][square1] & SCL_BITBOARD_SQUARE(square2))
+      return _SCL_rays[d][square1] & ~_SCL_rays[d][square2] &
+        ~SCL_BITBOARD_SQUARE(square2);
 
-              if (!ok)
-                continue;
+  return 0;
+#endif
+}
 
-              targetPos = i == 0 ? 6 : 2;
+/**
+  Whole line going through two squares, empty if they aren't on one line.
+*/
+static inline SCL_Bitboard _SCL_squaresLine(uint8_t square1, uint8_t square2)
+{
+#if SCL_SLIDER_TABLES
+  return _SCL_lines[square1][square2];
+#else
+  for (uint8_t d = 0; d < 8; ++d)
+    if (_SCL_rays[d][square1] & SCL_BITBOARD_SQUARE(square2))
+      return _SCL_rays[d][square1] | _SCL_rays[d ^ 4][square1] |
+        SCL_BITBOARD_SQUARE(square1);
 
-              if (!isWhite)
-                targetPos += 56;
+  return 0;
+#endif
+}
 
-              inc = 1 - 2 * (targetPos > pieceSquare);
+uint8_t _SCL_pieceType(char piece)
+{
+  switch (piece)
+  {
+    case 'p': case 'P': return SCL_PIECE_PAWN; break;
+    case 'n': case 'N': return SCL_PIECE_KNIGHT; break;
+    case 'b': case 'B': return SCL_PIECE_BISHOP; break;
+    case 'r': case 'R': return SCL_PIECE_ROOK; break;
+    case 'q': case 'Q': return SCL_PIECE_QUEEN; break;
+    case 'k': case 'K': return SCL_PIECE_KING; break;
+    default: break;
+  }
 
-              while (targetPos != pieceSquare) // check squares for the king
-              {
-                if ((board[targetPos] != '.' &&
-                     targetPos != rookPos) ||
-                     SCL_boardSquareAttacked(board,targetPos,!isWhite))
-                {
-                  ok = 0;
-                  break;
-                }
+  return SCL_PIECE_NONE;
+}
 
-                targetPos += inc;
-              }
+static inline uint64_t _SCL_zobristPiece(char piece, uint8_t square)
+{
+  return _SCL_zobristPieces[_SCL_zobristPieceIndex[piece & 0x7f]][square];
+}
 
-              if (ok)
-                SCL_squareSetAdd(result,rookPos);
-            }
-#endif
-        }
-      }
-    }
-      break;
+/**
+  Gets the part of the Zobrist key given by the non-piece state, i.e. castling
+  rights, en passant and the player to move.
+*/
+uint64_t _SCL_boardStateKey(const SCL_Board board)
+{
+  uint8_t state = board[SCL_BOARD_ENPASSANT_CASTLE_BYTE];
+  uint8_t white = (board[SCL_BOARD_PLY_BYTE] % 2) == 0;
+  uint64_t result = _SCL_zobristCastling[state >> 4];
 
-    default:
-      break;
+  state &= 0x0f;
+
+  if (state < 8)
+  {
+    /* Only count en passant if a pawn can take, otherwise the same position
+       would have different keys depending on whether the last move was a
+       double step. */
+
+    const char *s = board + (white ? 32 : 24) + state;
+    char pawn = white ? 'P' : 'p';
+
+    if ((state != 0 && *(s - 1) == pawn) || (state != 7 && *(s + 1) == pawn))
+      result ^= _SCL_zobristEnPassant[state];
   }
+
+  if (!white)
+    result ^= _SCL_zobristBlack;
+
+  return result;
 }
 
-void SCL_printSquareSet(SCL_SquareSet set, SCL_PutCharFunction putCharFunc)
+/* The key bytes are written out one by one (rather than as a loop) so that
+   compilers can merge them to a single 64 bit load/store. */
+
+void _SCL_boardSetKey(SCL_Board board, uint64_t key)
 {
-  uint8_t first = 1;
+  uint8_t *k = (uint8_t *) board + SCL_BOARD_KEY_BYTE;
 
-  putCharFunc('(');
+  k[0] = key;       k[1] = key >> 8;
+  k[2] = key >> 16; k[3] = key >> 24;
+  k[4] = key >> 32; k[5] = key >> 40;
+  k[6] = key >> 48; k[7] = key >> 56;
+}
+
+uint64_t SCL_boardKey(const SCL_Board board)
+{
+  const uint8_t *k = (const uint8_t *) board + SCL_BOARD_KEY_BYTE;
+
+  return ((uint64_t) k[0]) | (((uint64_t) k[1]) << 8) |
+    (((uint64_t) k[2]) << 16) | (((uint64_t) k[3]) << 24) |
+    (((uint64_t) k[4]) << 32) | (((uint64_t) k[5]) << 40) |
+    (((uint64_t) k[6]) << 48) | (((uint64_t) k[7]) << 56);
+}
+
+void SCL_boardUpdateKey(SCL_Board board)
+{
+  uint64_t key = _SCL_boardStateKey(board);
 
   for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i)
-  {
-    if (!SCL_squareSetContains(set, i))
-      continue;
+    key ^= _SCL_zobristPiece(board[i],i);
 
-    if (!first)
-      putCharFunc(',');
-    else
-      first = 0;
+  _SCL_boardSetKey(board,key);
+}
 
-    putCharFunc('A' + i % 8);
-    putCharFunc('1' + i / 8);
-  }
+uint8_t SCL_positionWhitesTurn(const SCL_Position *position)
+{
+  return (position->board[SCL_BOARD_PLY_BYTE] % 2) == 0;
+}
 
-  putCharFunc(')');
+uint8_t SCL_positionPieceType(const SCL_Position *position, uint8_t square)
+{
+  return _SCL_pieceType(position->board[square]);
 }
 
-void SCL_printSquareUTF8(uint8_t square, SCL_PutCharFunction putCharFunc)
+/**
+  Quickly gets bitboards of all pieces and of black pieces on a board, working
+  on 8 squares at once. This relies on piece characters being letters, i.e.
+  having bit 6 set (and bit 5 set for lowercase, i.e. black pieces), while
+  empty squares ('.') don't have bit 6 set.
+*/
+void _SCL_boardGetOccupancy(const SCL_Board board, SCL_Bitboard *occupied,
+  SCL_Bitboard *black)
 {
-  uint32_t val = 0;
+  *occupied = 0;
+  *black = 0;
 
-  switch (square)
+  for (int8_t row = 56; row >= 0; row -= 8)
   {
-    case 'r': val = 0x9c99e200; break;
-    case 'n': val = 0x9e99e200; break;
-    case 'b': val = 0x9d99e200; break;
-    case 'q': val = 0x9b99e200; break;
-    case 'k': val = 0x9a99e200; break;
-    case 'p': val = 0x9f99e200; break;
-    case 'R': val = 0x9699e200; break;
-    case 'N': val = 0x9899e200; break;
-    case 'B': val = 0x9799e200; break;
-    case 'Q': val = 0x9599e200; break;
-    case 'K': val = 0x9499e200; break;
-    case 'P': val = 0x9999e200; break;
-    case '.': val = 0x9296e200; break;
-    case ',': val = 0x9196e200; break;
-    default:  putCharFunc(square); return; break;
-  }
+    uint64_t squares = 0;
 
-  uint8_t count = 4;
+    for (int8_t i = 7; i >= 0; --i)
+      squares = (squares << 8) | (uint8_t) board[row + i];
 
-  while ((val % 256 == 0) && (count > 0))
-  {
-    val /= 256;
-    count--;
-  }
+    squares >>= 5;
 
-  while (count > 0)
-  {
-    putCharFunc(val % 256);
-    val /= 256;
-    count--;
+    // gather the lowest bit of each byte into the highest byte:
+    *black = (*black << 8) | (((squares & (squares >> 1) &
+      0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56);
+
+    *occupied = (*occupied << 8) | ((((squares >> 1) &
+      0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56);
   }
 }
 
-void SCL_boardGetMoves(
-  SCL_Board board,
-  uint8_t pieceSquare,
-  SCL_SquareSet result)
+/**
+  Adds (sign 1) or removes (sign -1) a piece, indexed as by
+  _SCL_zobristPieceIndex, on given square to/from the position's score (and
+  NNUE accumulator).
+*/
+static inline void _SCL_positionScorePiece(SCL_Position *position,
+  uint8_t piece, uint8_t square, int8_t sign)
 {
-  SCL_SquareSet allMoves;
+  position->score[0] += sign * _SCL_pieceSquareScores[piece][square][0];
+  position->score[1] += sign * _SCL_pieceSquareScores[piece][square][1];
+  position->phase += sign * _SCL_phaseWeights[piece % 6];
 
-  SCL_squareSetClear(allMoves);
+  if (piece % 6 == SCL_PIECE_PAWN)
+    position->pawnKey ^= _SCL_zobristPieces[piece][square];
 
-  for (uint8_t i = 0; i < 8; ++i)
-    result[i] = 0;
+#if SCL_NNUE
+  if (position->nnue.active)
+    _SCL_nnueUpdatePiece(&position->nnue,piece,square,sign);
+#endif
+}
 
-  SCL_boardGetPseudoMoves(board,pieceSquare,1,allMoves);
+/**
+  Updates the bitboards and the score of a position to match given square of
+  its board.
+*/
+void _SCL_positionSyncSquare(SCL_Position *position, uint8_t square)
+{
+  SCL_Bitboard bit = SCL_BITBOARD_SQUARE(square);
+  char piece = position->board[square];
 
-  // Now only keep moves that don't lead to one's check:
+  if (position->occupied & bit) // remove the piece that was here
+  {
+    uint8_t type = 0;
 
-  SCL_SQUARE_SET_ITERATE_BEGIN(allMoves)
+    while (!(position->pieces[type] & bit))
+      type++;
 
-    SCL_MoveUndo undo = SCL_boardMakeMove(board,pieceSquare,iteratedSquare,'q');
+    _SCL_positionScorePiece(position,
+      type + ((position->colors[1] & bit) ? 6 : 0),square,-1);
 
-    if (!SCL_boardCheck(board,!SCL_boardWhitesTurn(board)))
-      SCL_squareSetAdd(result,iteratedSquare);
+    position->pieces[type] &= ~bit;
+    position->colors[0] &= ~bit;
+    position->colors[1] &= ~bit;
+    position->occupied &= ~bit;
+  }
 
-    SCL_boardUndoMove(board,undo);
+  if (piece != '.')
+  {
+    position->pieces[_SCL_pieceType(piece)] |= bit;
+    position->colors[!SCL_pieceIsWhite(piece)] |= bit;
+    position->occupied |= bit;
 
-  SCL_SQUARE_SET_ITERATE_END
+    _SCL_positionScorePiece(position,
+      _SCL_zobristPieceIndex[(uint8_t) piece],square,1);
+  }
 }
 
-uint8_t SCL_boardDead(SCL_Board board)
+void SCL_positionFromBoard(SCL_Position *position, const SCL_Board board)
 {
-  /*
-    This byte represents material by bits:
-
-    MSB _ _ _ _ _ _ _ _ LSB
-          | | |   | | \_ white knight
-          | | |   |  \__ white bishop on white
-          | | |    \____ white bishop on black
-          | |  \________ black knight
-          |  \__________ black bishop on white
-           \____________ black bishop on black
-  */
-  uint8_t material = 0;
-
-  const char *p = board;
+  SCL_init();
+  SCL_boardCopy(board,position->board);
+
+  for (uint8_t i = 0; i < 6; ++i)
+    position->pieces[i] = 0;
+
+  position->colors[0] = 0;
+  position->colors[1] = 0;
+  position->score[0] = 0;
+  position->score[1] = 0;
+  position->phase = 0;
+  position->pawnKey = 0;
+#if SCL_NNUE
+  position->nnue.active = 0;
+#endif
 
   for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i)
   {
-    char c = *p;
+    char piece = board[i];
 
-    switch (c)
+    if (piece != '.')
     {
-      case 'n': material |= 0x01; break;
-      case 'N': material |= 0x10; break;
-      case 'b': material |= (0x02 << (!SCL_squareIsWhite(i))); break;
-      case 'B': material |= (0x20 << (!SCL_squareIsWhite(i))); break;
-      case 'p':
-      case 'P':
-      case 'r':
-      case 'R':
-      case 'q':
-      case 'Q':
-        return 0; // REMOVE later if more complex check are performed
-        break;
-
-      default: break;
+      position->pieces[_SCL_pieceType(piece)] |= SCL_BITBOARD_SQUARE(i);
+      position->colors[!SCL_pieceIsWhite(piece)] |= SCL_BITBOARD_SQUARE(i);
+      _SCL_positionScorePiece(position,
+        _SCL_zobristPieceIndex[(uint8_t) piece],i,1);
     }
-
-    p++;
   }
 
-  // TODO: add other checks than only insufficient material
+  position->occupied = position->colors[0] | position->colors[1];
+}
 
-  // possible combinations of insufficient material:
-
-  return
-    (material == 0x00) || // king vs king
-    (material == 0x01) || // king and knight vs king
-    (material == 0x10) || // king and knight vs king
-    (material == 0x02) || // king and bishop vs king
-    (material == 0x20) || // king and bishop vs king
-    (material == 0x04) || // king and bishop vs king
-    (material == 0x40) || // king and bishop vs king
-    (material == 0x22) || // king and bishop vs king and bishop (same color)
-    (material == 0x44);   // king and bishop vs king and bishop (same color)
+void SCL_positionToBoard(const SCL_Position *position, SCL_Board board)
+{
+  SCL_boardCopy(position->board,board);
 }
 
-uint8_t SCL_boardGetPosition(SCL_Board board)
+uint8_t SCL_positionFromFEN(SCL_Position *position, const char *string)
 {
-  uint8_t check = SCL_boardCheck(board,SCL_boardWhitesTurn(board));
-  uint8_t moves = SCL_boardMovePossible(board);
+  SCL_Board board;
 
-  if (check)
-    return moves ? SCL_POSITION_CHECK : SCL_POSITION_MATE;
-  else if (!moves)
-    return SCL_POSITION_STALEMATE;
+  SCL_boardInit(board);
 
-  if (SCL_boardDead(board))
-    return SCL_POSITION_DEAD;
+  if (!SCL_boardFromFEN(board,string))
+    return 0;
 
-  return SCL_POSITION_NORMAL;
+  SCL_positionFromBoard(position,board);
+
+  return 1;
 }
 
-uint8_t SCL_stringToMove(const char *moveString, uint8_t *resultFrom,
-  uint8_t *resultTo, char *resultPromotion)
+uint8_t SCL_positionToFEN(SCL_Position *position, char *string)
 {
-  char c;
+  return SCL_boardToFEN(position->board,string);
+}
 
-  uint8_t *dst = resultFrom;
+/**
+  Gets the list of squares whose content changes when given move is made on
+  given board (i.e. also the squares of castling rook and of pawn taken en
+  passant). Returns the number of the squares (at most 4).
+*/
+uint8_t _SCL_boardMoveSquares(const SCL_Board board, uint8_t squareFrom,
+  uint8_t squareTo, uint8_t squares[4])
+{
+  char s = board[squareFrom];
+  uint8_t count = 2;
 
-  for (uint8_t i = 0; i < 2; ++i)
+  squares[0] = squareFrom;
+  squares[1] = squareTo;
+
+  #define addSquare(sq) {\
+    uint8_t square_ = (sq);\
+    uint8_t new_ = 1;\
+    for (uint8_t i_ = 0; i_ < count; ++i_)\
+      if (squares[i_] == square_)\
+        new_ = 0;\
+    if (new_) { squares[count] = square_; count++; } }
+
+  if (s == 'k' || s == 'K')
   {
-    c = *moveString;
+#if !SCL_960_CASTLING
+    if (squareFrom == 4 || squareFrom == 60)
+    {
+      int8_t difference = squareTo - squareFrom;
 
-    *dst = (c >= 'a') ? (c - 'a') : (c - 'A');
+      if (difference == 2)
+      {
+        addSquare(squareTo - 1)
+        addSquare(squareTo + 1)
+      }
+      else if (difference == -2)
+      {
+        addSquare(squareTo - 2)
+        addSquare(squareTo + 1)
+      }
+    }
+#else
+    uint8_t isWhite = SCL_pieceIsWhite(s);
 
-    if (*dst > 7)
-      return 0;
+    if (board[squareTo] == SCL_pieceToColor('r',isWhite))
+    {
+      uint8_t base = isWhite ? 0 : 56;
 
-    moveString++;
-    c = *moveString;
+      addSquare(base + (squareTo > squareFrom ? 6 : 2))
+      addSquare(base + (squareTo > squareFrom ? 5 : 3))
+    }
+#endif
+  }
+  else if ((s == 'p' || s == 'P') && (squareFrom % 8 != squareTo % 8) &&
+    board[squareTo] == '.' && squareTo / 8 != 0 && squareTo / 8 != 7)
+    addSquare((squareFrom / 8) * 8 + squareTo % 8) // en passant
 
-    *dst += 8 * (c - '1');
+  #undef addSquare
 
-    if (*dst > 63)
-      return 0;
+  return count;
+}
 
-    moveString++;
+SCL_MoveUndo _SCL_boardMakeMove(SCL_Board board, uint8_t squareFrom,
+  uint8_t squareTo, char promotePiece, const uint8_t *squares,
+  uint8_t squareCount);
 
-    dst = resultTo;
-  }
+SCL_PositionUndo SCL_positionMakeMove(SCL_Position *position,
+  uint8_t squareFrom, uint8_t squareTo, char promotePiece)
+{
+  SCL_PositionUndo undo;
 
-  c = *moveString;
+  undo.squareCount =
+    _SCL_boardMoveSquares(position->board,squareFrom,squareTo,undo.squares);
 
-  if (c < 'A')
-    c = c - 'A' + 'a';
+  undo.boardUndo = _SCL_boardMakeMove(position->board,squareFrom,squareTo,
+    promotePiece,undo.squares,undo.squareCount);
 
-  switch (c)
-  {
-    case 'N': case 'n': *resultPromotion = 'n'; break;
-    case 'B': case 'b': *resultPromotion = 'b'; break;
-    case 'R': case 'r': *resultPromotion = 'r'; break;
-    case 'Q': case 'q':
-    default: *resultPromotion = 'q'; break;
-  }
+  for (uint8_t i = 0; i < undo.squareCount; ++i)
+    _SCL_positionSyncSquare(position,undo.squares[i]);
 
-  return 1;
+  return undo;
 }
 
-void SCL_printBoard(
-  SCL_Board board,
-  SCL_PutCharFunction putCharFunc,
-  SCL_SquareSet highlightSquares,
-  uint8_t selectSquare,
-  uint8_t format,
-  uint8_t offset,
-  uint8_t labels,
-  uint8_t blackDown)
+void SCL_positionUndoMove(SCL_Position *position, SCL_PositionUndo undo)
 {
-  if (labels)
-  {
-    for (uint8_t i = 0; i < offset + 2; ++i)
-      putCharFunc(' ');
+  SCL_boardUndoMove(position->board,undo.boardUndo);
 
-    for (uint8_t i = 0; i < 8; ++i)
-    {
-      if ((format != SCL_PRINT_FORMAT_COMPACT) &&
-          (format != SCL_PRINT_FORMAT_COMPACT_UTF8))
-        putCharFunc(' ');
+  for (uint8_t i = 0; i < undo.squareCount; ++i)
+    _SCL_positionSyncSquare(position,undo.squares[i]);
+}
 
-      putCharFunc(blackDown ? ('H' - i) : ('A' + i));
-    }
+SCL_Bitboard SCL_positionAttackers(const SCL_Position *position,
+  uint8_t square, uint8_t byWhite)
+{
+  const SCL_Bitboard *p = position->pieces;
+
+  return position->colors[!byWhite] & (
+    (_SCL_pawnAttacks[byWhite != 0][square] & p[SCL_PIECE_PAWN]) |
+    (_SCL_knightAttacks[square] & p[SCL_PIECE_KNIGHT]) |
+    (_SCL_kingAttacks[square] & p[SCL_PIECE_KING]) |
+    (_SCL_bishopAttacks(square,position->occupied) &
+      (p[SCL_PIECE_BISHOP] | p[SCL_PIECE_QUEEN])) |
+    (_SCL_rookAttacks(square,position->occupied) &
+      (p[SCL_PIECE_ROOK] | p[SCL_PIECE_QUEEN])));
+}
 
-    putCharFunc('\n');
-  }
+uint8_t SCL_positionSquareAttacked(const SCL_Position *position,
+  uint8_t square, uint8_t byWhite)
+{
+  return SCL_positionAttackers(position,square,byWhite) != 0;
+}
 
-  int8_t i = 7;
-  int8_t add = 1;
+uint8_t SCL_positionCheck(const SCL_Position *position, uint8_t white)
+{
+  SCL_Bitboard king =
+    position->pieces[SCL_PIECE_KING] & position->colors[!white];
 
-  if (!blackDown)
-  {
-    i = 56;
-    add = -1;
-  }
+  return king != 0 &&
+    SCL_positionSquareAttacked(position,SCL_bitboardFirst(king),!white);
+}
 
-  for (int8_t row = 0; row < 8; ++row)
-  {
-    for (uint8_t j = 0; j < offset; ++j)
-      putCharFunc(' ');
+SCL_Bitboard SCL_positionGetPseudoMoves(const SCL_Position *position,
+  uint8_t pieceSquare, uint8_t checkCastling)
+{
+  const char *board = position->board;
+  char piece = board[pieceSquare];
 
-    if (labels)
+  if (piece == '.')
+    return 0;
+
+  uint8_t isWhite = SCL_pieceIsWhite(piece);
+  SCL_Bitboard occupied = position->occupied;
+  SCL_Bitboard notOwn = ~position->colors[!isWhite];
+
+  switch (_SCL_pieceType(piece))
+  {
+    case SCL_PIECE_PAWN:
     {
-      putCharFunc(!blackDown ? ('8' - row) : ('1' + row));
-      putCharFunc(' ');
+      SCL_Bitboard result;
+      uint8_t row = pieceSquare / 8;
+
+      if (isWhite)
+      {
+        result = (SCL_BITBOARD_SQUARE(pieceSquare) << 8) & ~occupied;
+
+        if (row == 1)
+          result |= (result << 8) & ~occupied;
+      }
+      else
+      {
+        result = (SCL_BITBOARD_SQUARE(pieceSquare) >> 8) & ~occupied;
+
+        if (row == 6)
+          result |= (result >> 8) & ~occupied;
+      }
+
+      result |= _SCL_pawnAttacks[!isWhite][pieceSquare] &
+        position->colors[isWhite != 0];
+
+      uint8_t enPassantColumn = board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & 0x0f;
+
+      if (enPassantColumn < 8 && row == (isWhite ? 4 : 3))
+      {
+        int8_t columnDiff = enPassantColumn - pieceSquare % 8;
+        uint8_t enemySquare = row * 8 + enPassantColumn;
+
+        if ((columnDiff == 1 || columnDiff == -1) &&
+          board[enemySquare] == (isWhite ? 'p' : 'P'))
+          result |= SCL_BITBOARD_SQUARE(enemySquare + (isWhite ? 8 : -8));
+      }
+
+      return result;
+      break;
     }
 
-    const char *square = board + i;
+    case SCL_PIECE_KNIGHT:
+      return _SCL_knightAttacks[pieceSquare] & notOwn;
+      break;
 
-    for (int8_t col = 0; col < 8; ++col)
+    case SCL_PIECE_BISHOP:
+      return _SCL_bishopAttacks(pieceSquare,occupied) & notOwn;
+      break;
+
+    case SCL_PIECE_ROOK:
+      return _SCL_rookAttacks(pieceSquare,occupied) & notOwn;
+      break;
+
+    case SCL_PIECE_QUEEN:
+      return (_SCL_rookAttacks(pieceSquare,occupied) |
+        _SCL_bishopAttacks(pieceSquare,occupied)) & notOwn;
+      break;
+
+    case SCL_PIECE_KING:
     {
-      switch (format)
-      {
-        case SCL_PRINT_FORMAT_COMPACT:
-          putCharFunc(
-            (*square == '.') ? (
-            ((i != selectSquare) ?
-              (!SCL_squareSetContains(highlightSquares,i) ? *square : '*')
-              : '#')) : *square);
-          break;
+      SCL_Bitboard result = _SCL_kingAttacks[pieceSquare] & notOwn;
+      uint8_t bitShift = 4 + 2 * (!isWhite);
+      uint8_t castling = board[SCL_BOARD_ENPASSANT_CASTLE_BYTE];
 
-        case SCL_PRINT_FORMAT_UTF8:
+      if (!checkCastling || !(castling & (0x03 << bitShift)) ||
+        SCL_positionSquareAttacked(position,pieceSquare,!isWhite))
+        return result;
+
+      char rook = SCL_pieceToColor('r',isWhite);
+
+#if !SCL_960_CASTLING
+      if (pieceSquare % 8 != 4)
+        return result;
+
+      if ((castling & (0x01 << bitShift)) &&
+        !(occupied & (SCL_BITBOARD_SQUARE(pieceSquare + 1) |
+          SCL_BITBOARD_SQUARE(pieceSquare + 2))) &&
+        board[pieceSquare + 3] == rook &&
+        !SCL_positionSquareAttacked(position,pieceSquare + 1,!isWhite))
+        result |= SCL_BITBOARD_SQUARE(pieceSquare + 2);
+
+      if ((castling & (0x02 << bitShift)) &&
+        !(occupied & (SCL_BITBOARD_SQUARE(pieceSquare - 1) |
+          SCL_BITBOARD_SQUARE(pieceSquare - 2) |
+          SCL_BITBOARD_SQUARE(pieceSquare - 3))) &&
+        board[pieceSquare - 4] == rook &&
+        !SCL_positionSquareAttacked(position,pieceSquare - 1,!isWhite))
+        result |= SCL_BITBOARD_SQUARE(pieceSquare - 2);
+#else // 960 castling
+      for (uint8_t i = 0; i < 2; ++i) // short and long
+        if (castling & ((i + 1) << bitShift))
         {
-          char squareChar = SCL_squareIsWhite(i) ? '.' : ',';
-          char pieceChar = (*square == '.') ? squareChar : *square;
+          uint8_t base = isWhite ? 0 : 56;
+          uint8_t rookPos = base + (i == 0 ?
+            ((uint8_t) board[SCL_BOARD_EXTRA_BYTE] >> 3) :
+            (board[SCL_BOARD_EXTRA_BYTE] & 0x07));
 
-          if (i == selectSquare)
-          {
-            putCharFunc('(');
+          if (board[rookPos] != rook)
+            continue;
 
-            if (*square == '.')
-              putCharFunc(')');
-            else
-              SCL_printSquareUTF8(pieceChar,putCharFunc);
-          }
-          else if (!SCL_squareSetContains(highlightSquares,i))
-          {
-            SCL_printSquareUTF8(squareChar,putCharFunc);
-            SCL_printSquareUTF8(pieceChar,putCharFunc);
-          }
-          else
-          {
-            putCharFunc('[');
+          uint8_t rookTarget = base + (i == 0 ? 5 : 3);
+          uint8_t kingTarget = base + (i == 0 ? 6 : 2);
 
-            if (*square == '.')
-              putCharFunc(']');
-            else
-              SCL_printSquareUTF8(*square,putCharFunc);
-          }
+          // squares the king and rook pass must be empty (except for them):
 
-          break;
-        }
+          SCL_Bitboard path =
+            _SCL_rays[rookTarget > rookPos ? 1 : 5][rookPos] &
+            ~_SCL_rays[rookTarget > rookPos ? 1 : 5][rookTarget];
 
-        case SCL_PRINT_FORMAT_COMPACT_UTF8:
-          SCL_printSquareUTF8(
-            (*square == '.') ? (
-              SCL_squareSetContains(highlightSquares,i) ? '*' :
-              (i == selectSquare ? '#' : ((SCL_squareIsWhite(i) ? '.' : ',')))
-            ) : *square,putCharFunc);
-          break;
+          path |= _SCL_rays[kingTarget > pieceSquare ? 1 : 5][pieceSquare] &
+            ~_SCL_rays[kingTarget > pieceSquare ? 1 : 5][kingTarget];
 
-        case SCL_PRINT_FORMAT_NORMAL:
-        default:
-        {
-          uint8_t c = *square;
+          path |= SCL_BITBOARD_SQUARE(rookTarget) |
+            SCL_BITBOARD_SQUARE(kingTarget);
 
-          char squareColor = SCL_squareIsWhite(i) ? ' ' : ':';
+          path &= ~(SCL_BITBOARD_SQUARE(rookPos) |
+            SCL_BITBOARD_SQUARE(pieceSquare));
 
-          putCharFunc((i != selectSquare) ?
-            (!SCL_squareSetContains(highlightSquares,i) ?
-            squareColor : '#') : '@');
+          if (occupied & path)
+            continue;
 
-          putCharFunc(c == '.' ? squareColor : *square);
-          break;
+          // squares the king passes mustn't be attacked:
+
+          uint8_t ok = 1;
+          int8_t inc = kingTarget > pieceSquare ? 1 : -1;
+
+          for (uint8_t s = kingTarget; s != pieceSquare; s -= inc)
+            if (SCL_positionSquareAttacked(position,s,!isWhite))
+            {
+              ok = 0;
+              break;
+            }
+
+          if (ok)
+            result |= SCL_BITBOARD_SQUARE(rookPos);
         }
-      }
+#endif
 
-      i -= add;
-      square -= add;
+      return result;
+      break;
     }
 
-    putCharFunc('\n');
+    default: break;
+  }
 
-    i += add * 16;
-  } // for rows
+  return 0;
 }
 
-int16_t SCL_pieceValuePositive(char piece)
+uint8_t SCL_moveFrom(SCL_Move move)
 {
-  switch (piece)
-  {
-    case 'p':
-    case 'P': return SCL_VALUE_PAWN; break;
-    case 'n':
-    case 'N': return SCL_VALUE_KNIGHT; break;
-    case 'b':
-    case 'B': return SCL_VALUE_BISHOP; break;
-    case 'r':
-    case 'R': return SCL_VALUE_ROOK; break;
-    case 'q':
-    case 'Q': return SCL_VALUE_QUEEN; break;
-    case 'k':
-    case 'K': return SCL_VALUE_KING; break;
-    default: break;
-  }
+  return move & 0x3f;
+}
 
-  return 0;
+uint8_t SCL_moveTo(SCL_Move move)
+{
+  return (move >> 6) & 0x3f;
 }
 
-int16_t SCL_pieceValue(char piece)
+uint16_t SCL_moveType(SCL_Move move)
 {
-  switch (piece)
-  {
-    case 'P': return SCL_VALUE_PAWN; break;
-    case 'N': return SCL_VALUE_KNIGHT; break;
-    case 'B': return SCL_VALUE_BISHOP; break;
-    case 'R': return SCL_VALUE_ROOK; break;
-    case 'Q': return SCL_VALUE_QUEEN; break;
-    case 'K': return SCL_VALUE_KING; break;
-    case 'p': return -1 * SCL_VALUE_PAWN; break;
-    case 'n': return -1 * SCL_VALUE_KNIGHT; break;
-    case 'b': return -1 * SCL_VALUE_BISHOP; break;
-    case 'r': return -1 * SCL_VALUE_ROOK; break;
-    case 'q': return -1 * SCL_VALUE_QUEEN; break;
-    case 'k': return -1 * SCL_VALUE_KING; break;
-    default: break;
+  return move & 0xc000;
+}
+
+char SCL_movePromotion(SCL_Move move)
+{
+  return SCL_moveType(move) != SCL_MOVE_PROMOTION ? 'q' :
+    ("nbrq"[(move >> 12) & 0x03]);
+}
+
+/**
+  Checks if a square would be attacked by given player with given occupancy
+  and with given pieces removed (e.g. captured), used to test moves without
+  making them.
+*/
+uint8_t _SCL_positionAttackedWith(const SCL_Position *position,
+  uint8_t square, uint8_t byWhite, SCL_Bitboard occupied,
+  SCL_Bitboard removed)
+{
+  const SCL_Bitboard *p = position->pieces;
+  SCL_Bitboard them = position->colors[!byWhite] & ~removed;
+
+  return (them & (
+    (_SCL_pawnAttacks[byWhite != 0][square] & p[SCL_PIECE_PAWN]) |
+    (_SCL_knightAttacks[square] & p[SCL_PIECE_KNIGHT]) |
+    (_SCL_kingAttacks[square] & p[SCL_PIECE_KING]) |
+    (_SCL_bishopAttacks(square,occupied) &
+      (p[SCL_PIECE_BISHOP] | p[SCL_PIECE_QUEEN])) |
+    (_SCL_rookAttacks(square,occupied) &
+      (p[SCL_PIECE_ROOK] | p[SCL_PIECE_QUEEN])))) != 0;
+}
+
+/**
+  Implements SCL_positionGetMoves and SCL_positionGetCaptures.
+*/
+void _SCL_positionGetMoves(const SCL_Position *position, SCL_MoveList *moves,
+  uint8_t capturesOnly)
+{
+  const char *board = position->board;
+  uint8_t white = SCL_positionWhitesTurn(position);
+  SCL_Bitboard us = position->colors[!white];
+  SCL_Bitboard occupied = position->occupied;
+  SCL_Bitboard kingBit = position->pieces[SCL_PIECE_KING] & us;
+  SCL_Bitboard checkers = 0, pinned = 0;
+  SCL_Bitboard targets = ~us; // where pieces other than king may go
+  uint8_t king = 0;
+
+  // for captures only the moves must also go to enemy pieces (or promote)
+  SCL_Bitboard wanted =
+    capturesOnly ? position->colors[white != 0] : ~((SCL_Bitboard) 0);
+
+  moves->count = 0;
+
+  #define addMove(from,to,flags)\
+    { moves->moves[moves->count] = SCL_MOVE(from,to,flags); moves->count++; }
+
+  if (kingBit) // there may be no king in variants
+  {
+    king = SCL_bitboardFirst(kingBit);
+    checkers = SCL_positionAttackers(position,king,!white);
+
+    if (checkers)
+      targets &= (checkers & (checkers - 1)) ? 0 : // double check: only king
+        (checkers | _SCL_squaresBetween(king,SCL_bitboardFirst(checkers)));
+
+    // enemy sliders that would attack the king if there were no pieces:
+
+    SCL_Bitboard pinners = position->colors[white != 0] & (
+      (_SCL_rookAttacks(king,0) & (position->pieces[SCL_PIECE_ROOK] |
+        position->pieces[SCL_PIECE_QUEEN])) |
+      (_SCL_bishopAttacks(king,0) & (position->pieces[SCL_PIECE_BISHOP] |
+        position->pieces[SCL_PIECE_QUEEN])));
+
+    while (pinners)
+    {
+      SCL_Bitboard between =
+        _SCL_squaresBetween(king,SCL_bitboardPop(&pinners)) & occupied;
+
+      if (between && !(between & (between - 1)))
+        pinned |= between & us;
+    }
   }
 
-  return 0;
+  SCL_Bitboard pieces = us;
+
+  while (pieces)
+  {
+    uint8_t from = SCL_bitboardPop(&pieces);
+    uint8_t type = _SCL_pieceType(board[from]);
+
+    if (type == SCL_PIECE_KING)
+    {
+      SCL_Bitboard m = SCL_positionGetPseudoMoves(position,from,!capturesOnly);
+      SCL_Bitboard castling = m & ~(_SCL_kingAttacks[from] & ~us);
+      SCL_Bitboard occupiedNoKing = occupied & ~kingBit;
+
+      m &= ~castling & wanted;
+
+      while (m | castling)
+      {
+        uint8_t to = SCL_bitboardFirst(m | castling);
+        SCL_Bitboard toBit = SCL_BITBOARD_SQUARE(to);
+
+        if (castling & toBit)
+        {
+          // the king's path was checked, only test its final square here
+#if !SCL_960_CASTLING
+          if (!_SCL_positionAttackedWith(position,to,!white,occupiedNoKing,0))
+            addMove(from,to,SCL_MOVE_CASTLING)
+#else
+          uint8_t base = white ? 0 : 56;
+          uint8_t kingTo = base + (to > from ? 6 : 2);
+          uint8_t rookTo = base + (to > from ? 5 : 3);
+
+          if (!_SCL_positionAttackedWith(position,kingTo,!white,
+            (occupiedNoKing & ~toBit) | SCL_BITBOARD_SQUARE(kingTo) |
+            SCL_BITBOARD_SQUARE(rookTo),0))
+            addMove(from,to,SCL_MOVE_CASTLING)
+#endif
+        }
+        else if (!_SCL_positionAttackedWith(position,to,!white,
+          occupiedNoKing,toBit))
+          addMove(from,to,SCL_MOVE_NORMAL)
+
+        m &= ~toBit;
+        castling &= ~toBit;
+      }
+
+      continue;
+    }
+
+    SCL_Bitboard m = SCL_positionGetPseudoMoves(position,from,0);
+
+    if (pinned & SCL_BITBOARD_SQUARE(from))
+      m &= _SCL_squaresLine(king,from);
+
+    if (type == SCL_PIECE_PAWN)
+    {
+      uint8_t enPassantColumn = board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & 0x0f;
+
+      while (m)
+      {
+        uint8_t to = SCL_bitboardPop(&m);
+        SCL_Bitboard toBit = SCL_BITBOARD_SQUARE(to);
+
+        if (to % 8 == enPassantColumn && board[to] == '.' &&
+          to % 8 != from % 8)
+        {
+          // en passant: simply test if the king would be attacked after it
+
+          SCL_Bitboard taken = SCL_BITBOARD_SQUARE((from / 8) * 8 + to % 8);
+
+          if (!kingBit || !_SCL_positionAttackedWith(position,king,!white,
+            (occupied & ~taken & ~SCL_BITBOARD_SQUARE(from)) | toBit,taken))
+            addMove(from,to,SCL_MOVE_EN_PASSANT)
+        }
+        else if (targets & (wanted | 0xff000000000000ff) & toBit)
+        {
+          if (to / 8 == 0 || to / 8 == 7)
+          {
+            addMove(from,to,SCL_MOVE_PROMOTION | SCL_MOVE_PROMOTE_Q)
+            addMove(from,to,SCL_MOVE_PROMOTION | SCL_MOVE_PROMOTE_R)
+            addMove(from,to,SCL_MOVE_PROMOTION | SCL_MOVE_PROMOTE_B)
+            addMove(from,to,SCL_MOVE_PROMOTION | SCL_MOVE_PROMOTE_N)
+          }
+          else
+            addMove(from,to,SCL_MOVE_NORMAL)
+        }
+      }
+
+      continue;
+    }
+
+    m &= targets & wanted;
+
+    while (m)
+      addMove(from,SCL_bitboardPop(&m),SCL_MOVE_NORMAL)
+  }
+
+  #undef addMove
 }
 
-#define ATTACK_BONUS 3
-#define MOBILITY_BONUS 10
-#define CENTER_BONUS 7
-#define CHECK_BONUS 5
-#define KING_CASTLED_BONUS 30
-#define KING_BACK_BONUS 15
-#define KING_NOT_CENTER_BONUS 15
-#define PAWN_NON_DOUBLE_BONUS 3
-#define PAWN_PAIR_BONUS 3
-#define KING_CENTERNESS 10
+void SCL_positionGetMoves(const SCL_Position *position, SCL_MoveList *moves)
+{
+  _SCL_positionGetMoves(position,moves,0);
+}
 
-int16_t _SCL_rateKingEndgamePosition(uint8_t position)
+void SCL_positionGetCaptures(const SCL_Position *position,
+  SCL_MoveList *moves)
 {
-  int16_t result = 0;
-  uint8_t rank = position / 8;
-  position %= 8;
+  _SCL_positionGetMoves(position,moves,1);
+}
 
-  if (position > 1 && position < 6)
-    result += KING_CENTERNESS;
+void SCL_boardGetMoveList(const SCL_Board board, SCL_MoveList *moves)
+{
+  SCL_Position position;
 
-  if (rank > 1 && rank < 6)
-    result += KING_CENTERNESS;
+  SCL_positionFromBoard(&position,board);
+  SCL_positionGetMoves(&position,moves);
+}
+
+uint64_t SCL_positionPerft(SCL_Position *position, uint8_t depth,
+  uint8_t bulk)
+{
+  SCL_MoveList moves;
+  uint64_t result = 0;
+
+  if (depth == 0)
+    return 1;
+
+  SCL_positionGetMoves(position,&moves);
+
+  if (depth == 1 && bulk)
+    return moves.count;
+
+  for (uint16_t i = 0; i < moves.count; ++i)
+  {
+    SCL_Move m = moves.moves[i];
+
+    SCL_PositionUndo undo = SCL_positionMakeMove(position,
+      SCL_moveFrom(m),SCL_moveTo(m),SCL_movePromotion(m));
+
+    result += SCL_positionPerft(position,depth - 1,bulk);
+
+    SCL_positionUndoMove(position,undo);
+  }
 
   return result;
 }
 
-int16_t SCL_boardEvaluateStatic(SCL_Board board)
+void _SCL_printNumber(uint64_t number, SCL_PutCharFunction putCharFunc)
 {
-  uint8_t position = SCL_boardGetPosition(board);
+  char digits[20];
+  uint8_t count = 0;
 
-  int16_t total = 0;
+  do
+  {
+    digits[count] = '0' + number % 10;
+    number /= 10;
+    count++;
+  } while (number != 0);
 
-  switch (position)
+  while (count != 0)
   {
-    case SCL_POSITION_MATE:
-      return SCL_boardWhitesTurn(board) ?
-        -1 * SCL_EVALUATION_MAX_SCORE : SCL_EVALUATION_MAX_SCORE;
-      break;
+    count--;
+    putCharFunc(digits[count]);
+  }
+}
 
-    case SCL_POSITION_STALEMATE:
-    case SCL_POSITION_DEAD:
-      return 0;
+uint64_t SCL_positionPerftDivide(SCL_Position *position, uint8_t depth,
+  uint8_t bulk, SCL_PutCharFunction putCharFunc)
+{
+  SCL_MoveList moves;
+  uint64_t result = 0;
+  char moveStr[8];
+
+  if (depth == 0)
+    return 1;
+
+  SCL_positionGetMoves(position,&moves);
+
+  for (uint16_t i = 0; i < moves.count; ++i)
+  {
+    SCL_Move m = moves.moves[i];
+    uint8_t from = SCL_moveFrom(m), to = SCL_moveTo(m);
+    char promotion = SCL_movePromotion(m);
+
+    SCL_moveToString(position->board,from,to,promotion,moveStr);
+
+    SCL_PositionUndo undo =
+      SCL_positionMakeMove(position,from,to,promotion);
+
+    uint64_t count = SCL_positionPerft(position,depth - 1,bulk);
+
+    SCL_positionUndoMove(position,undo);
+
+    for (const char *c = moveStr; *c != 0; ++c)
+      putCharFunc(*c);
+
+    putCharFunc(':');
+    putCharFunc(' ');
+    _SCL_printNumber(count,putCharFunc);
+    putCharFunc('\n');
+
+    result += count;
+  }
+
+  return result;
+}
+
+uint8_t SCL_transpositionTableInit(SCL_TranspositionTable *table,
+  uint16_t sizeMB)
+{
+#if SCL_TRANSPOSITION_TABLE_SIZE != 0
+  free(table->memory);
+#endif
+
+  table->slots = 0;
+  table->memory = 0;
+  table->bucketMask = 0;
+  table->generation = 0;
+  table->evaluationFunction = 0;
+
+  if (sizeMB == 0)
+    return 1;
+
+#if SCL_TRANSPOSITION_TABLE_SIZE != 0
+  uint32_t buckets = 1;
+  size_t bucketSize =
+    SCL_TRANSPOSITION_BUCKET_SIZE * sizeof(SCL_TranspositionSlot);
+
+  /* The size is computed in size_t and the bucket count capped so that it
+     can't overflow (e.g. 4096 MB is 2^32 bytes, more than 32 bits hold). */
+  while (((uint64_t) buckets) * 2 <=
+    ((uint64_t) sizeMB) * (1024 * 1024 / bucketSize) &&
+    buckets < 0x80000000 && buckets * 2 <= (SIZE_MAX - 63) / bucketSize)
+    buckets *= 2;
+
+  table->memory = malloc(((size_t) buckets) * bucketSize + 63);
+
+  if (table->memory == 0)
+    return 0;
+
+  // align to cache line:
+  table->slots = (SCL_TranspositionSlot *)
+    (((uintptr_t) table->memory + 63) & ~((uintptr_t) 63));
+
+  table->bucketMask = buckets - 1;
+
+  SCL_transpositionTableClear(table);
+
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+void SCL_transpositionTableClear(SCL_TranspositionTable *table)
+{
+  if (table->slots == 0)
+    return;
+
+  SCL_TranspositionSlot *slot = table->slots;
+  uint64_t count =
+    (((uint64_t) table->bucketMask) + 1) * SCL_TRANSPOSITION_BUCKET_SIZE;
+
+  for (uint64_t i = 0; i < count; ++i, ++slot)
+  {
+    slot->keyData = 0;
+    slot->data = 0; // SCL_BOUND_NONE
+  }
+}
+
+void SCL_transpositionTableNewSearch(SCL_TranspositionTable *table)
+{
+  table->generation = (table->generation + 1) & 0x3f;
+}
+
+uint64_t _SCL_transpositionPack(int16_t score, SCL_Move move, int8_t depth,
+  uint8_t info)
+{
+  return ((uint64_t) (uint16_t) score) | (((uint64_t) move) << 16) |
+    (((uint64_t) (uint8_t) depth) << 32) | (((uint64_t) info) << 40);
+}
+
+uint8_t SCL_transpositionTableProbe(const SCL_TranspositionTable *table,
+  uint64_t key, SCL_TranspositionEntry *entry)
+{
+  if (table->slots == 0)
+    return 0;
+
+  // volatile so that the slot isn't read again after the check
+  const volatile SCL_TranspositionSlot *slot = table->slots +
+    (key & table->bucketMask) * SCL_TRANSPOSITION_BUCKET_SIZE;
+
+  for (uint8_t i = 0; i < SCL_TRANSPOSITION_BUCKET_SIZE; ++i, ++slot)
+  {
+    uint64_t data = slot->data;
+
+    if ((slot->keyData ^ data) == key && ((data >> 40) & 0x03) !=
+      SCL_BOUND_NONE)
+    {
+      entry->key = key;
+      entry->score = (int16_t) (data & 0xffff);
+      entry->move = (data >> 16) & 0xffff;
+      entry->depth = (int8_t) ((data >> 32) & 0xff);
+      entry->info = (data >> 40) & 0xff;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+void SCL_transpositionTableStore(SCL_TranspositionTable *table, uint64_t key,
+  int8_t depth, uint8_t bound, int16_t score, SCL_Move move)
+{
+  if (table->slots == 0)
+    return;
+
+  volatile SCL_TranspositionSlot *slot = table->slots +
+    (key & table->bucketMask) * SCL_TRANSPOSITION_BUCKET_SIZE;
+
+  volatile SCL_TranspositionSlot *replace = slot;
+  uint64_t replaceData = slot->data;
+  uint8_t sameKey = 0;
+  int16_t replaceValue = 32767;
+
+  for (uint8_t i = 0; i < SCL_TRANSPOSITION_BUCKET_SIZE; ++i, ++slot)
+  {
+    uint64_t data = slot->data;
+    uint8_t info = (data >> 40) & 0xff;
+
+    sameKey = (slot->keyData ^ data) == key;
+
+    if (sameKey || (info & 0x03) == SCL_BOUND_NONE)
+    {
+      replace = slot;
+      replaceData = data;
       break;
+    }
 
-    /*
-      main points are assigned as follows:
-      - points for material as a sum of all material on board
-      - for playing side: if a piece attacks piece of greater value, a fraction
-        of the value difference is gained (we suppose exchange), this is only
-        gained once per every attacking piece (maximum gain is taken), we only
-        take fraction so that actually taking the piece is favored
-      - ATTACK_BONUS points for any attacked piece
+    // older entries count as shallower:
+    int16_t value = ((int8_t) ((data >> 32) & 0xff)) -
+      4 * ((table->generation - (info >> 2)) & 0x3f);
 
-      other points are assigned as follows (in total these shouldn't be more
-      than the value of one pawn)
-      - mobility: MOBILITY_BONUS points for each piece with at least 4 possible
-        moves
-      - center control: CENTER_BONUS points for a piece on a center square
-      - CHECK_BONUS points for check
-      - king:
-        - safety (non endgame): KING_BACK_BONUS points for king on staring rank,
-          additional KING_CASTLED_BONUS if the kind if on castled square or
-          closer to the edge, additional KING_NOT_CENTER_BONUS for king not on
-          its start neighbouring center square
-        - center closeness (endgame): up to 2 * KING_CENTERNESS points for
-          being closer to center
-      - non-doubled pawns: PAWN_NON_DOUBLE_BONUS points for each pawn without
-        same color pawn directly in front of it
-      - pawn structure: PAWN_PAIR_BONUS points for each pawn guarding own pawn
-      - advancing pawns: 1 point for each pawn's rank in its move
-        direction
-    */
+    if (value < replaceValue)
+    {
+      replace = slot;
+      replaceData = data;
+      replaceValue = value;
+    }
+  }
+
+  if (sameKey && move == SCL_MOVE_NONE)
+    move = (replaceData >> 16) & 0xffff; // keep the old move rather than none
+
+  uint64_t data = _SCL_transpositionPack(score,move,depth,
+    bound | (table->generation << 2));
+
+  replace->keyData = key ^ data;
+  replace->data = data;
+}
+
+void SCL_evaluationCacheClear(SCL_EvaluationCache *cache)
+{
+#if SCL_EVALUATION_CACHE_SIZE != 0
+  for (uint32_t i = 0; i < SCL_EVALUATION_CACHE_SIZE; ++i)
+    cache->entries[i] = 0;
+#else
+  cache->entries[0] = 0; // the unused placeholder entry
+#endif
+}
+
+/**
+  Returns the static evaluation of a board (white's view) using the evaluation
+  cache.
+*/
+int16_t _SCL_evaluationCacheEvaluate(SCL_StaticEvaluationFunction evalFunction,
+  SCL_Board board)
+{
+#if SCL_EVALUATION_CACHE_SIZE != 0
+  uint64_t key = SCL_boardKey(board);
+  uint64_t *entry = SCL_evaluationCache.entries +
+    (key & (SCL_EVALUATION_CACHE_SIZE - 1));
+  uint64_t value = *entry;
+
+  if (((value ^ key) & 0xffffffffffff0000ULL) == 0 && value != 0)
+    return (int16_t) (value & 0xffff);
+
+  int16_t score = evalFunction(board);
+
+  *entry = (key & 0xffffffffffff0000ULL) | ((uint16_t) score);
+
+  return score;
+#else
+  return evalFunction(board);
+#endif
+}
+
+/**
+  Records the rook starting positions in the board state. This is required in
+  chess 960 in order to be able to correctly perform castling (castling rights
+  knowledge isn't enough as one rook might have moved to the other side and we
+  wouldn't know which one can castle and which not).
+*/
+void _SCL_board960RememberRookPositions(SCL_Board board)
+{
+  uint8_t pos = 0;
+  uint8_t rooks = 2;
+
+  while (pos < 8 && rooks != 0)
+  {
+    if (board[pos] == 'R')
+    {
+      board[SCL_BOARD_EXTRA_BYTE] = rooks == 2 ? pos :
+        (board[SCL_BOARD_EXTRA_BYTE] | (pos << 3));
+
+      rooks--;
+    }
+
+    pos++;
+  }
+}
+
+void SCL_boardInit(SCL_Board board)
+{
+  SCL_init();
+
+  /*
+    We might use SCL_BOARD_START_STATE and copy it to the board, but that might
+    waste RAM on Arduino, so we init the board by code.
+  */
+
+  char *b = board;
+
+  *b = 'R'; b++; *b = 'N'; b++;
+  *b = 'B'; b++; *b = 'Q'; b++;
+  *b = 'K'; b++; *b = 'B'; b++;
+  *b = 'N'; b++; *b = 'R'; b++;
+
+  char *b2 = board + 48;
+
+  for (uint8_t i = 0; i < 8; ++i, b++, b2++)
+  {
+    *b = 'P';
+    *b2 = 'p';
+  }
+
+  for (uint8_t i = 0; i < 32; ++i, b++)
+    *b = '.';
+
+  b += 8;
+
+  *b = 'r'; b++; *b = 'n'; b++;
+  *b = 'b'; b++; *b = 'q'; b++;
+  *b = 'k'; b++; *b = 'b'; b++;
+  *b = 'n'; b++; *b = 'r'; b++;
+
+  for (uint8_t i = 0; i < SCL_BOARD_STATE_SIZE - SCL_BOARD_SQUARES; ++i, ++b)
+    *b = 0;
+
+  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] = (char) 0xff;
+
+#if SCL_960_CASTLING
+  _SCL_board960RememberRookPositions(board);
+#endif
+
+  SCL_boardUpdateKey(board);
+}
+
+void _SCL_boardPlaceOnNthAvailable(SCL_Board board, uint8_t pos, char piece)
+{
+  char *c = board;
+
+  while (1)
+  {
+    if (*c == '.')
+    {
+      if (pos == 0)
+        break;
+
+      pos--;
+    }
+
+    c++;
+  }
+
+  *c = piece;
+}
+
+void SCL_boardInit960(SCL_Board board, uint16_t positionNumber)
+{
+  SCL_Board b;
+
+  SCL_boardInit(b);
+
+  for (uint8_t i = 0; i < SCL_BOARD_STATE_SIZE; ++i)
+    board[i] = ((i >= 8 && i < 56) || i >= 64) ? b[i] : '.';
+
+  uint8_t helper = positionNumber % 16;
+
+  board[(helper / 4) * 2] = 'B';
+  board[1 + (helper % 4) * 2] = 'B';
+
+  helper = positionNumber / 16;
+
+  // maybe there's a simpler way :)
+
+  _SCL_boardPlaceOnNthAvailable(board,helper % 6,'Q');
+  _SCL_boardPlaceOnNthAvailable(board,0,helper <= 23 ? 'N' : 'R');
+
+  _SCL_boardPlaceOnNthAvailable(board,0,
+    (helper >= 6 && helper <= 23) ? 'R' :
+      (helper > 41 ? 'K' : 'N' ));
+
+  _SCL_boardPlaceOnNthAvailable(board,0,
+    (helper <= 5 || helper >= 54) ? 'R' :
+      (((helper >= 12 && helper <= 23) ||
+      (helper >= 30 && helper <= 41)) ? 'K' : 'N'));
+
+  _SCL_boardPlaceOnNthAvailable(board,0,
+    (helper <= 11 || (helper <= 29 && helper >= 24)) ? 'K' :
+      (
+        (
+          (helper >= 18 && helper <= 23) ||
+          (helper >= 36 && helper <= 41) ||
+          (helper >= 48 && helper <= 53)
+        ) ? 'R' : 'N'
+      )
+    );
+
+  uint8_t rooks = 0;
+
+  for (uint8_t i = 0; i < 8; ++i)
+    if (board[i] == 'R')
+      rooks++;
+
+  _SCL_boardPlaceOnNthAvailable(board,0,rooks == 2 ? 'N' : 'R');
+
+  for (uint8_t i = 0; i < 8; ++i)
+    board[56 + i] = SCL_pieceToColor(board[i],0);
+
+#if SCL_960_CASTLING
+  _SCL_board960RememberRookPositions(board);
+#else
+  SCL_boardDisableCastling(board);
+#endif
+
+  SCL_boardUpdateKey(board);
+}
+
+uint8_t SCL_boardsDiffer(SCL_Board b1, SCL_Board b2)
+{
+  const char *p1 = b1, *p2 = b2;
+
+  while (p1 < b1 + SCL_BOARD_STATE_SIZE)
+  {
+    if (*p1 != *p2)
+      return 1;
+
+    p1++;
+    p2++;
+  }
+
+  return 0;
+}
+
+void SCL_recordInit(SCL_Record r)
+{
+  r[0] = 0 | SCL_RECORD_END;
+  r[1] = 0;
+}
+
+void SCL_recordFromPGN(SCL_Record r, const char *pgn)
+{
+  SCL_Board board;
+
+  SCL_boardInit(board);
+
+  SCL_recordInit(r);
+
+  uint8_t state = 0;
+  uint8_t evenMove = 0;
+
+  while (*pgn != 0)
+  {
+    switch (state)
+    {
+      case 0: // skipping tags and spaces, outside []
+        if (*pgn == '1')
+          state = 2;
+        else if (*pgn == '[')
+          state = 1;
+
+        break;
+
+      case 1: // skipping tags and spaces, inside []
+        if (*pgn == ']')
+          state = 0;
+
+        break;
+
+      case 2: // reading move number
+        if (*pgn == '{')
+          state = 3;
+        else if ((*pgn >= 'a' && *pgn <= 'h') || (*pgn >= 'A' && *pgn <= 'Z'))
+        {
+          state = 4;
+          pgn--;
+        }
+
+        break;
+
+      case 3: // initial comment
+        if (*pgn == '}')
+          state = 2;
+
+        break;
+
+      case 4: // reading move
+      {
+        char piece = 'p';
+        char promoteTo = 'q';
+        uint8_t castle = 0;
+        uint8_t promotion = 0;
+
+        int8_t coords[4];
+
+        uint8_t ranks = 0, files = 0;
+
+        for (uint8_t i = 0; i < 4; ++i)
+          coords[i] = -1;
+
+        while (*pgn != ' ' && *pgn != '\n' &&
+          *pgn != '\t' && *pgn != '{' && *pgn != 0)
+        {
+          if (*pgn == '=')
+            promotion = 1;
+          if (*pgn == 'O' || *pgn == '0')
+            castle++;
+          if (*pgn >= 'A' && *pgn <= 'Z')
+          {
+            if (promotion)
+              promoteTo = *pgn;
+            else
+              piece = *pgn;
+          }
+          else if (*pgn >= 'a' && *pgn <= 'h')
+          {
+            coords[files * 2] = *pgn - 'a';
+            files++;
+          }
+          else if (*pgn >= '1' && *pgn <= '8')
+          {
+            coords[1 + ranks * 2] = *pgn - '1';
+            ranks++;
+          }
+
+          pgn++;
+        }
+
+        if (castle)
+        {
+          piece = 'K';
+
+          coords[0] = 4;
+          coords[1] = 0;
+          coords[2] = castle < 3 ? 6 : 2;
+          coords[3] = 0;
+
+          if (evenMove)
+          {
+            coords[1] = 7;
+            coords[3] = 7;
+          }
+        }
+
+        piece = SCL_pieceToColor(piece,evenMove == 0);
+
+        if (coords[2] < 0)
+        {
+          coords[2] = coords[0];
+          coords[0] = -1;
+        }
+
+        if (coords[3] < 0)
+        {
+          coords[3] = coords[1];
+          coords[1] = -1;
+        }
+
+        uint8_t squareTo = coords[3] * 8 + coords[2];
+
+        if (coords[0] < 0 || coords[1] < 0)
+        {
+          // without complete starting coords we have to find the piece
+
+          SCL_MoveList moves;
+
+          SCL_boardGetMoveList(board,&moves);
+
+          for (uint16_t i = 0; i < moves.count; ++i)
+          {
+            uint8_t from = SCL_moveFrom(moves.moves[i]);
+
+            if (board[from] == piece &&
+              SCL_moveTo(moves.moves[i]) == squareTo &&
+              (coords[0] < 0 || coords[0] == from % 8) &&
+              (coords[1] < 0 || coords[1] == from / 8))
+            {
+              coords[0] = from % 8;
+              coords[1] = from / 8;
+              break;
+            }
+          }
+        }
+
+        uint8_t squareFrom = coords[1] * 8 + coords[0];
+
+        SCL_boardMakeMove(board,squareFrom,squareTo,promoteTo);
+
+// for some reason tcc bugs here, the above line sets squareFrom to 0 lol
+// can be fixed with doing "squareFrom = coords[1] * 8 + coords[0];" again
+
+        SCL_recordAdd(r,squareFrom,squareTo,promoteTo,SCL_RECORD_CONT);
+
+        while (*pgn == ' ' || *pgn == '\n' || *pgn == '\t' || *pgn == '{')
+        {
+          if (*pgn == '{')
+            while (*pgn != '}')
+              pgn++;
+
+          pgn++;
+        }
+
+        if (*pgn == 0)
+          return;
+
+        pgn--;
+
+        if (evenMove)
+          state = 2;
+
+        evenMove = !evenMove;
+
+        break;
+      }
+
+      default: break;
+    }
+
+    pgn++;
+  }
+}
+
+uint16_t SCL_recordLength(const SCL_Record r)
+{
+  if ((r[0] & 0x3f) == (r[1] & 0x3f)) // empty record that's only terminator
+    return 0;
+
+  uint16_t result = 0;
+
+  while ((r[result] & 0xc0) == 0)
+    result += 2;
+
+  return (result / 2) + 1;
+}
+
+uint8_t SCL_recordGetMove(const SCL_Record r,  uint16_t index,
+  uint8_t *squareFrom, uint8_t *squareTo, char *promotedPiece)
+{
+  index *= 2;
+
+  uint8_t b = r[index];
+
+  *squareFrom = b & 0x3f;
+  uint8_t result = b & 0xc0;
+
+  index++;
+
+  b = r[index];
+
+  *squareTo = b & 0x3f;
+
+  b &= 0xc0;
+
+  switch (b)
+  {
+    case SCL_RECORD_PROM_Q: *promotedPiece = 'q'; break;
+    case SCL_RECORD_PROM_R: *promotedPiece = 'r'; break;
+    case SCL_RECORD_PROM_B: *promotedPiece = 'b'; break;
+    case SCL_RECORD_PROM_N:
+    default:            *promotedPiece = 'n'; break;
+  }
+
+  return result;
+}
+
+uint8_t SCL_recordAdd(SCL_Record r, uint8_t squareFrom,
+  uint8_t squareTo, char promotePiece, uint8_t endState)
+{
+  uint16_t l = SCL_recordLength(r);
+
+  if (l >= SCL_RECORD_MAX_LENGTH)
+    return 0;
+
+  l *= 2;
+
+  if (l != 0)
+    r[l - 2] &= 0x3f; // remove the end flag from previous item
+
+  if (endState == SCL_RECORD_CONT)
+    endState = SCL_RECORD_END;
+
+  r[l] = squareFrom | endState;
+
+  uint8_t p;
+
+  switch (promotePiece)
+  {
+    case 'n': case 'N': p = SCL_RECORD_PROM_N; break;
+    case 'b': case 'B': p = SCL_RECORD_PROM_B; break;
+    case 'r': case 'R': p = SCL_RECORD_PROM_R; break;
+    case 'q': case 'Q':
+    default:            p = SCL_RECORD_PROM_Q; break;
+  }
+
+  l++;
+
+  r[l] = squareTo | p;
+
+  return 1;
+}
+
+uint8_t SCL_recordRemoveLast(SCL_Record r)
+{
+  uint16_t l = SCL_recordLength(r);
+
+  if (l == 0)
+    return 0;
+
+  if (l == 1)
+    SCL_recordInit(r);
+  else
+  {
+    l = (l - 2) * 2;
+
+    r[l] = (r[l] & 0x3f) | SCL_RECORD_END;
+  }
+
+  return 1;
+}
+
+void SCL_recordApply(const SCL_Record r, SCL_Board b, uint16_t moves)
+{
+  SCL_boardInit(b);
+
+  uint16_t l = SCL_recordLength(r);
+
+  if (moves > l)
+    moves = l;
+
+  for (uint16_t i = 0; i < moves; ++i)
+  {
+    uint8_t s0, s1;
+    char p;
+
+     SCL_recordGetMove(r,i,&s0,&s1,&p);
+     SCL_boardMakeMove(b,s0,s1,p);
+  }
+}
+
+void SCL_boardUndoMove(SCL_Board board, SCL_MoveUndo moveUndo)
+{
+#if SCL_960_CASTLING
+  char squareToNow = board[moveUndo.squareTo];
+#endif
+
+  board[moveUndo.squareFrom] = board[moveUndo.squareTo];
+  board[moveUndo.squareTo] = moveUndo.other & 0x7f;
+  board[SCL_BOARD_PLY_BYTE]--;
+  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] = moveUndo.enPassantCastle;
+  board[SCL_BOARD_MOVE_COUNT_BYTE] = moveUndo.moveCount;
+  _SCL_boardSetKey(board,moveUndo.key);
+
+  if (moveUndo.other & 0x80)
+  {
+    moveUndo.squareTo /= 8;
+
+    if (moveUndo.squareTo == 0 || moveUndo.squareTo == 7)
+      board[moveUndo.squareFrom] = SCL_pieceIsWhite(board[moveUndo.squareFrom])
+        ? 'P' : 'p';
+      // ^ was promotion
+    else
+      board[(moveUndo.squareFrom / 8) * 8 + (moveUndo.enPassantCastle & 0x0f)] =
+        (board[moveUndo.squareFrom] == 'P') ? 'p' : 'P'; // was en passant
+  }
+#if !SCL_960_CASTLING
+  else if (board[moveUndo.squareFrom] == 'k' && // black castling
+    moveUndo.squareFrom == 60)
+  {
+    if (moveUndo.squareTo == 58)
+    {
+      board[59] = '.';
+      board[56] = 'r';
+    }
+    else if (moveUndo.squareTo == 62)
+    {
+      board[61] = '.';
+      board[63] = 'r';
+    }
+  }
+  else if (board[moveUndo.squareFrom] == 'K' && // white castling
+    moveUndo.squareFrom == 4)
+  {
+    if (moveUndo.squareTo == 2)
+    {
+      board[3] = '.';
+      board[0] = 'R';
+    }
+    else if (moveUndo.squareTo == 6)
+    {
+      board[5] = '.';
+      board[7] = 'R';
+    }
+  }
+#else // 960 castling
+  else if (((moveUndo.other & 0x7f) == 'r') && // black castling
+    (squareToNow == '.' || !SCL_pieceIsWhite(squareToNow)))
+  {
+    board[moveUndo.squareTo < moveUndo.squareFrom ? 59 : 61] = '.';
+    board[moveUndo.squareTo < moveUndo.squareFrom ? 58 : 62] = '.';
+
+    board[moveUndo.squareFrom] = 'k';
+    board[moveUndo.squareTo] = 'r';
+  }
+  else if (((moveUndo.other & 0x7f) == 'R') && // white castling
+    (squareToNow == '.' || SCL_pieceIsWhite(squareToNow)))
+  {
+    board[moveUndo.squareTo < moveUndo.squareFrom ? 3 : 5] = '.';
+    board[moveUndo.squareTo < moveUndo.squareFrom ? 2 : 6] = '.';
+
+    board[moveUndo.squareFrom] = 'K';
+    board[moveUndo.squareTo] = 'R';
+  }
+#endif
+}
+
+/**
+  Potentially disables castling rights according to whether something moved from
+  or to a square with a rook.
+*/
+void _SCL_handleRookActivity(SCL_Board board, uint8_t rookSquare)
+{
+#if !SCL_960_CASTLING
+  switch (rookSquare)
+  {
+    case 0:  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x20; break;
+    case 7:  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x10; break;
+    case 56: board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x80; break;
+    case 63: board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x40; break;
+    default: break;
+  }
+#else // 960 castling
+  if (rookSquare == (board[SCL_BOARD_EXTRA_BYTE] & 0x07))
+    board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x20;
+  else if (rookSquare == (board[SCL_BOARD_EXTRA_BYTE] >> 3))
+    board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x10;
+  else if (rookSquare == 56 + (board[SCL_BOARD_EXTRA_BYTE] & 0x07))
+    board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x80;
+  else if (rookSquare == 56 + (board[SCL_BOARD_EXTRA_BYTE] >> 3))
+    board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= (uint8_t) ~0x40;
+#endif
+}
+
+/**
+  Implements SCL_boardMakeMove, takes the squares the move changes (from
+  _SCL_boardMoveSquares) to update the Zobrist key.
+*/
+SCL_MoveUndo _SCL_boardMakeMove(SCL_Board board, uint8_t squareFrom,
+  uint8_t squareTo, char promotePiece, const uint8_t *squares,
+  uint8_t squareCount)
+{
+  char s = board[squareFrom];
+
+  SCL_MoveUndo moveUndo;
+
+  moveUndo.key = SCL_boardKey(board);
+
+  uint64_t key = moveUndo.key ^ _SCL_boardStateKey(board);
+
+  for (uint8_t i = 0; i < squareCount; ++i) // remove the old pieces from key
+    key ^= _SCL_zobristPiece(board[squares[i]],squares[i]);
+
+  moveUndo.squareFrom = squareFrom;
+  moveUndo.squareTo = squareTo;
+  moveUndo.moveCount = board[SCL_BOARD_MOVE_COUNT_BYTE];
+  moveUndo.enPassantCastle = board[SCL_BOARD_ENPASSANT_CASTLE_BYTE];
+  moveUndo.other = board[squareTo];
+
+  // reset the en-passant state
+  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] |= 0x0f;
+
+  if (SCL_boardMoveResetsCount(board,squareFrom,squareTo))
+    board[SCL_BOARD_MOVE_COUNT_BYTE] = 0;
+  else
+    board[SCL_BOARD_MOVE_COUNT_BYTE]++;
+
+#if SCL_960_CASTLING
+  uint8_t castled = 0;
+#endif
+
+  if ((s == 'k') || (s == 'K'))
+  {
+#if !SCL_960_CASTLING
+    if ((squareFrom == 4) || (squareFrom == 60)) // check castling
+    {
+      int8_t difference = squareTo - squareFrom;
+
+      char rook = SCL_pieceToColor('r',SCL_pieceIsWhite(s));
+
+      if (difference == 2) // short
+      {
+        board[squareTo - 1] = rook;
+        board[squareTo + 1] = '.';
+      }
+      else if (difference == -2) // long
+      {
+        board[squareTo - 2] = '.';
+        board[squareTo + 1] = rook;
+      }
+    }
+#else // 960 castling
+    uint8_t isWhite = SCL_pieceIsWhite(s);
+    char rook = SCL_pieceToColor('r',isWhite);
+
+    if (board[squareTo] == rook)
+    {
+      castled = 1;
+
+      board[squareFrom] = '.';
+      board[squareTo] = '.';
+
+      if (squareTo > squareFrom) // short
+      {
+        board[isWhite ? 6 : (56 + 6)] = s;
+        board[isWhite ? 5 : (56 + 5)] = rook;
+      }
+      else // long
+      {
+        board[isWhite ? 2 : (56 + 2)] = s;
+        board[isWhite ? 3 : (56 + 3)] = rook;
+      }
+    }
+#endif
+
+    // after king move disable castling
+    board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= ~(0x03 << ((s == 'K') ? 4 : 6));
+  }
+  else if ((s == 'p') || (s == 'P'))
+  {
+    uint8_t row = squareTo / 8;
+
+    int8_t rowDiff = squareFrom / 8 - row;
+
+    if (rowDiff == 2 || rowDiff == -2) // record en passant column
+    {
+      board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] =
+        (board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & 0xf0) | (squareFrom % 8);
+    }
+
+    if (row == 0 || row == 7)
+    {
+      // promotion
+      s = SCL_pieceToColor(promotePiece,SCL_pieceIsWhite(s));
+
+      moveUndo.other |= 0x80;
+    }
+    else
+    {
+      // check en passant move
+
+      int8_t columnDiff = (squareTo % 8) - (squareFrom % 8);
+
+      if ((columnDiff != 0) && (board[squareTo] == '.'))
+      {
+        board[squareFrom + columnDiff] = '.';
+        moveUndo.other |= 0x80;
+      }
+    }
+  }
+  else if ((s == 'r') || (s == 'R'))
+    _SCL_handleRookActivity(board,squareFrom);
+
+  char taken = board[squareTo];
+
+  // taking a rook may also disable castling:
+
+  if (taken == 'R' || taken == 'r')
+    _SCL_handleRookActivity(board,squareTo);
+
+#if SCL_960_CASTLING
+  if (!castled)
+#endif
+  {
+    board[squareTo] = s;
+    board[squareFrom] = '.';
+  }
+
+  board[SCL_BOARD_PLY_BYTE]++; // increase ply count
+
+  for (uint8_t i = 0; i < squareCount; ++i) // add the new pieces to key
+    key ^= _SCL_zobristPiece(board[squares[i]],squares[i]);
+
+  _SCL_boardSetKey(board,key ^ _SCL_boardStateKey(board));
+
+  return moveUndo;
+}
+
+SCL_MoveUndo SCL_boardMakeMove(SCL_Board board, uint8_t squareFrom, uint8_t squareTo,
+  char promotePiece)
+{
+  uint8_t squares[4];
+  uint8_t squareCount =
+    _SCL_boardMoveSquares(board,squareFrom,squareTo,squares);
+
+  return _SCL_boardMakeMove(board,squareFrom,squareTo,promotePiece,squares,
+    squareCount);
+}
+
+void SCL_boardSetPosition(SCL_Board board, const char *pieces,
+  uint8_t castlingEnPassant, uint8_t moveCount, uint8_t ply)
+{
+  SCL_init();
+
+  for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i, pieces++)
+    if (*pieces != 0)
+      board[i] = *pieces;
+    else
+      break;
+
+  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] = castlingEnPassant;
+  board[SCL_BOARD_PLY_BYTE] = ply;
+  board[SCL_BOARD_MOVE_COUNT_BYTE] = moveCount;
+  board[SCL_BOARD_KEY_BYTE - 1] = 0;
+
+  SCL_boardUpdateKey(board);
+}
+
+void SCL_squareSetAdd(SCL_SquareSet squareSet, uint8_t square)
+{
+  squareSet[square / 8] |= 0x01 << (square % 8);
+}
+
+uint8_t SCL_squareSetContains(const SCL_SquareSet squareSet, uint8_t square)
+{
+  return squareSet[square / 8] & (0x01 << (square % 8));
+}
+
+uint8_t SCL_squareSetSize(const SCL_SquareSet squareSet)
+{
+  uint8_t result = 0;
+
+  for (uint8_t i = 0; i < 8; ++i)
+  {
+    uint8_t byte = squareSet[i];
+
+    for (uint8_t j = 0; j < 8; ++j)
+    {
+      result += byte & 0x01;
+      byte >>= 1;
+    }
+  }
+
+  return result;
+}
+
+uint8_t SCL_squareSetEmpty(const SCL_SquareSet squareSet)
+{
+  for (uint8_t i = 0; i < 8; ++i)
+    if (squareSet[i] != 0)
+      return 0;
+
+  return 1;
+}
+
+uint8_t SCL_squareSetGetRandom(
+  const SCL_SquareSet squareSet, SCL_RandomFunction randFunc)
+{
+  uint8_t size = SCL_squareSetSize(squareSet);
+
+  if (size == 0)
+    return 0;
+
+  uint8_t n = (randFunc() % size) + 1;
+  uint8_t i = 0;
+
+  while (i < SCL_BOARD_SQUARES)
+  {
+    if (SCL_squareSetContains(squareSet,i))
+    {
+      n--;
+
+      if (n == 0)
+        break;
+    }
+
+    ++i;
+  }
+
+  return i;
+}
+
+void SCL_boardCopy(const SCL_Board boardFrom, SCL_Board boardTo)
+{
+  for (uint8_t i = 0; i < SCL_BOARD_STATE_SIZE; ++i)
+    boardTo[i] = boardFrom[i];
+}
+
+uint8_t SCL_boardSquareAttacked(
+  const SCL_Board board,
+  uint8_t square,
+  uint8_t byWhite)
+{
+  /* We look from the square outwards for pieces that could attack it, starting
+     with the cheapest tests. */
+
+  SCL_Bitboard candidates = _SCL_pawnAttacks[byWhite != 0][square];
+  char piece = SCL_pieceToColor('p',byWhite);
+
+  #define findPiece(p)\
+    while (candidates)\
+      if (board[SCL_bitboardPop(&candidates)] == (p))\
+        return 1;
+
+  findPiece(piece)
+
+  candidates = _SCL_knightAttacks[square];
+  piece = SCL_pieceToColor('n',byWhite);
+
+  findPiece(piece)
+
+  candidates = _SCL_kingAttacks[square];
+  piece = SCL_pieceToColor('k',byWhite);
+
+  findPiece(piece)
+
+  #undef findPiece
+
+  SCL_Bitboard occupied, black;
+
+  _SCL_boardGetOccupancy(board,&occupied,&black);
+
+  char queen = SCL_pieceToColor('q',byWhite);
+
+  // only the first piece in each direction can attack:
+
+  candidates = _SCL_rookAttacks(square,occupied) & occupied;
+  piece = SCL_pieceToColor('r',byWhite);
+
+  while (candidates)
+  {
+    char c = board[SCL_bitboardPop(&candidates)];
+
+    if (c == piece || c == queen)
+      return 1;
+  }
+
+  candidates = _SCL_bishopAttacks(square,occupied) & occupied;
+  piece = SCL_pieceToColor('b',byWhite);
+
+  while (candidates)
+  {
+    char c = board[SCL_bitboardPop(&candidates)];
+
+    if (c == piece || c == queen)
+      return 1;
+  }
+
+  return 0;
+}
+
+uint8_t SCL_boardCheck(const SCL_Board board, uint8_t white)
+{
+  const char *square = board;
+  char kingChar = white ? 'K' : 'k';
+
+  for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i, ++square)
+    if ((*square == kingChar &&
+      SCL_boardSquareAttacked(board,i,!white)))
+        return 1;
+
+  return 0;
+}
+
+uint8_t SCL_boardGameOver(SCL_Board board)
+{
+  uint8_t position = SCL_boardGetPosition(board);
+
+  return (position == SCL_POSITION_MATE) ||
+         (position == SCL_POSITION_STALEMATE) ||
+         (position == SCL_POSITION_DEAD);
+}
+
+uint8_t SCL_boardMovePossible(SCL_Board board)
+{
+  SCL_MoveList moves;
+
+  SCL_boardGetMoveList(board,&moves);
+
+  return moves.count != 0;
+}
+
+uint8_t SCL_boardMate(SCL_Board board)
+{
+  return SCL_boardGetPosition(board) == SCL_POSITION_MATE;
+}
+
+void SCL_boardGetPseudoMoves(
+  SCL_Board board,
+  uint8_t pieceSquare,
+  uint8_t checkCastling,
+  SCL_SquareSet result)
+{
+  char piece = board[pieceSquare];
+
+  SCL_squareSetClear(result);
+
+  uint8_t isWhite = SCL_pieceIsWhite(piece);
+  int8_t horizontalPosition = pieceSquare % 8;
+  int8_t pawnOffset = -8;
+
+  switch (piece)
+  {
+    case 'P':
+      pawnOffset = 8;
+      // fall through
+    case 'p':
+    {
+      uint8_t square = pieceSquare + pawnOffset;
+      uint8_t verticalPosition = pieceSquare / 8;
+
+      if (board[square] == '.') // forward move
+      {
+        SCL_squareSetAdd(result,square);
+
+        if (verticalPosition == (1 + (piece == 'p') * 5)) // start position?
+        {
+          uint8_t square2 = square + pawnOffset;
+
+          if (board[square2] == '.')
+            SCL_squareSetAdd(result,square2);
+        }
+      }
+
+      #define checkDiagonal(hor,add) \
+        if (horizontalPosition != hor) \
+        { \
+          uint8_t square2 = square + add; \
+          char c = board[square2]; \
+          if (c != '.' && SCL_pieceIsWhite(c) != isWhite) \
+            SCL_squareSetAdd(result,square2); \
+        }
+
+      // diagonal moves
+      checkDiagonal(0,-1)
+      checkDiagonal(7,1)
+
+      uint8_t enPassantRow = 4;
+      uint8_t enemyPawn = 'p';
+
+      if (piece == 'p')
+      {
+        enPassantRow = 3;
+        enemyPawn = 'P';
+      }
+
+      // en-passant moves
+      if (verticalPosition == enPassantRow)
+      {
+        uint8_t enPassantColumn = board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & 0x0f;
+        uint8_t column = pieceSquare % 8;
+
+        for (int8_t offset = -1; offset < 2; offset += 2)
+          if ((enPassantColumn == column + offset) &&
+              (board[pieceSquare + offset] == enemyPawn))
+          {
+            SCL_squareSetAdd(result,pieceSquare + pawnOffset + offset);
+            break;
+          }
+      }
+
+      #undef checkDiagonal
+    }
+      break;
+
+    case 'r': // rook
+    case 'R':
+    case 'b': // bishop
+    case 'B':
+    case 'q': // queen
+    case 'Q':
+    {
+      SCL_Bitboard occupied, black, attacks = 0;
+
+      _SCL_boardGetOccupancy(board,&occupied,&black);
+
+      if (piece != 'b' && piece != 'B')
+        attacks |= _SCL_rookAttacks(pieceSquare,occupied);
+
+      if (piece != 'r' && piece != 'R')
+        attacks |= _SCL_bishopAttacks(pieceSquare,occupied);
+
+      SCL_bitboardToSquareSet(
+        attacks & ~(isWhite ? (occupied & ~black) : black),result);
+    }
+      break;
+
+    case 'n': // knight
+    case 'N':
+    {
+      const int8_t offsets[4] = {6, 10, 15, 17};
+      const int8_t columnsMinus[4] = {2,-2,1,-1};
+      const int8_t columnsPlus[4] = {-2,2,-1,1};
+      const int8_t *off, *col;
+
+      #define checkOffsets(op,comp,limit,dir)\
+        off = offsets;\
+        col = columns ## dir;\
+        for (uint8_t i = 0; i < 4; ++i, ++off, ++col)\
+        {\
+          int8_t square = pieceSquare op (*off);\
+          if (square comp limit) /* out of board? */\
+            break;\
+          int8_t horizontalCheck = horizontalPosition + (*col);\
+          if (horizontalCheck < 0 || horizontalCheck >= 8)\
+            continue;\
+          char squareC = board[square];\
+          if ((squareC == '.') || (SCL_pieceIsWhite(squareC) != isWhite))\
+            SCL_squareSetAdd(result,square);\
+        }
+
+      checkOffsets(-,<,0,Minus)
+      checkOffsets(+,>=,SCL_BOARD_SQUARES,Plus)
+
+      #undef checkOffsets
+    }
+      break;
+
+    case 'k': // king
+    case 'K':
+    {
+      uint8_t verticalPosition = pieceSquare / 8;
+
+      uint8_t
+        u = verticalPosition != 0,
+        d = verticalPosition != 7,
+        l = horizontalPosition != 0,
+        r = horizontalPosition != 7;
+
+      uint8_t square2 = pieceSquare - 9;
+
+      #define checkSquare(cond,add) \
+        if (cond && ((board[square2] == '.') || \
+            (SCL_pieceIsWhite(board[square2])) != isWhite))\
+          SCL_squareSetAdd(result,square2);\
+        square2 += add;
+
+      checkSquare(l && u,1)
+      checkSquare(u,1)
+      checkSquare(r && u,6)
+      checkSquare(l,2)
+      checkSquare(r,6)
+      checkSquare(l && d,1)
+      checkSquare(d,1)
+      checkSquare(r && d,0)
+
+      #undef checkSquare
+
+      // castling:
+
+      if (checkCastling)
+      {
+        uint8_t bitShift = 4 + 2 * (!isWhite);
+
+        if ((board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & (0x03 << bitShift)) &&
+          !SCL_boardSquareAttacked(board,pieceSquare,!isWhite)) // no check?
+        {
+#if !SCL_960_CASTLING
+          // short castle:
+          pieceSquare++;
+
+          if ((board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & (0x01 << bitShift)) &&
+              (board[pieceSquare] == '.') &&
+              (board[pieceSquare + 1] == '.') &&
+              (board[pieceSquare + 2] == SCL_pieceToColor('r',isWhite)) &&
+              !SCL_boardSquareAttacked(board,pieceSquare,!isWhite))
+            SCL_squareSetAdd(result,pieceSquare + 1);
+
+          /* note: don't check the final square for check, it will potentially
+             be removed later (can't end up in check) */
+
+          // long castle:
+          pieceSquare -= 2;
+
+          if ((board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & (0x02 << bitShift)) &&
+              (board[pieceSquare] == '.') &&
+              (board[pieceSquare - 1] == '.') &&
+              (board[pieceSquare - 2] == '.') &&
+              (board[pieceSquare - 3] == SCL_pieceToColor('r',isWhite)) &&
+              !SCL_boardSquareAttacked(board,pieceSquare,!isWhite))
+            SCL_squareSetAdd(result,pieceSquare - 1);
+#else // 960 castling
+          for (int i = 0; i < 2; ++i) // short and long
+            if (board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] & ((i + 1) << bitShift))
+            {
+              uint8_t
+                rookPos = board[SCL_BOARD_EXTRA_BYTE] >> 3,
+                targetPos = 5;
+
+              if (i == 1)
+              {
+                rookPos = board[SCL_BOARD_EXTRA_BYTE] & 0x07,
+                targetPos = 3;
+              }
+
+              if (!isWhite)
+              {
+                rookPos += 56;
+                targetPos += 56;
+              }
+
+              uint8_t ok = board[rookPos] == SCL_pieceToColor('r',isWhite);
+
+              if (!ok)
+                continue;
+
+              int8_t inc = 1 - 2 * (targetPos > rookPos);
+
+              while (targetPos != rookPos) // check vacant squares for the rook
+              {
+                if (board[targetPos] != '.' &&
+                    targetPos != pieceSquare)
+                {
+                  ok = 0;
+                  break;
+                }
+
+                targetPos += inc;
+              }
+
+              if (!ok)
+                continue;
+
+              targetPos = i == 0 ? 6 : 2;
+
+              if (!isWhite)
+                targetPos += 56;
+
+              inc = 1 - 2 * (targetPos > pieceSquare);
+
+              while (targetPos != pieceSquare) // check squares for the king
+              {
+                if ((board[targetPos] != '.' &&
+                     targetPos != rookPos) ||
+                     SCL_boardSquareAttacked(board,targetPos,!isWhite))
+                {
+                  ok = 0;
+                  break;
+                }
+
+                targetPos += inc;
+              }
+
+              if (ok)
+                SCL_squareSetAdd(result,rookPos);
+            }
+#endif
+        }
+      }
+    }
+      break;
+
+    default:
+      break;
+  }
+}
+
+void SCL_printSquareSet(SCL_SquareSet set, SCL_PutCharFunction putCharFunc)
+{
+  uint8_t first = 1;
+
+  putCharFunc('(');
+
+  for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i)
+  {
+    if (!SCL_squareSetContains(set, i))
+      continue;
+
+    if (!first)
+      putCharFunc(',');
+    else
+      first = 0;
+
+    putCharFunc('A' + i % 8);
+    putCharFunc('1' + i / 8);
+  }
+
+  putCharFunc(')');
+}
+
+void SCL_printSquareUTF8(uint8_t square, SCL_PutCharFunction putCharFunc)
+{
+  uint32_t val = 0;
+
+  switch (square)
+  {
+    case 'r': val = 0x9c99e200; break;
+    case 'n': val = 0x9e99e200; break;
+    case 'b': val = 0x9d99e200; break;
+    case 'q': val = 0x9b99e200; break;
+    case 'k': val = 0x9a99e200; break;
+    case 'p': val = 0x9f99e200; break;
+    case 'R': val = 0x9699e200; break;
+    case 'N': val = 0x9899e200; break;
+    case 'B': val = 0x9799e200; break;
+    case 'Q': val = 0x9599e200; break;
+    case 'K': val = 0x9499e200; break;
+    case 'P': val = 0x9999e200; break;
+    case '.': val = 0x9296e200; break;
+    case ',': val = 0x9196e200; break;
+    default:  putCharFunc(square); return; break;
+  }
+
+  uint8_t count = 4;
+
+  while ((val % 256 == 0) && (count > 0))
+  {
+    val /= 256;
+    count--;
+  }
+
+  while (count > 0)
+  {
+    putCharFunc(val % 256);
+    val /= 256;
+    count--;
+  }
+}
+
+void SCL_boardGetMoves(
+  SCL_Board board,
+  uint8_t pieceSquare,
+  SCL_SquareSet result)
+{
+  SCL_Position position;
+  SCL_MoveList moves;
+
+  SCL_squareSetClear(result);
+
+  if (board[pieceSquare] == '.')
+    return;
+
+  SCL_positionFromBoard(&position,board);
+
+  if (SCL_pieceIsWhite(board[pieceSquare]) != SCL_boardWhitesTurn(board))
+    position.board[SCL_BOARD_PLY_BYTE]++; // get moves of the other player
+
+  SCL_positionGetMoves(&position,&moves);
+
+  for (uint16_t i = 0; i < moves.count; ++i)
+    if (SCL_moveFrom(moves.moves[i]) == pieceSquare)
+      SCL_squareSetAdd(result,SCL_moveTo(moves.moves[i]));
+}
+
+uint8_t SCL_boardDead(SCL_Board board)
+{
+  /*
+    This byte represents material by bits:
+
+    MSB _ _ _ _ _ _ _ _ LSB
+          | | |   | | \_ white knight
+          | | |   |  \__ white bishop on white
+          | | |    \____ white bishop on black
+          | |  \________ black knight
+          |  \__________ black bishop on white
+           \____________ black bishop on black
+  */
+  uint8_t material = 0;
+
+  const char *p = board;
+
+  for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i)
+  {
+    char c = *p;
+
+    switch (c)
+    {
+      case 'n': material |= 0x01; break;
+      case 'N': material |= 0x10; break;
+      case 'b': material |= (0x02 << (!SCL_squareIsWhite(i))); break;
+      case 'B': material |= (0x20 << (!SCL_squareIsWhite(i))); break;
+      case 'p':
+      case 'P':
+      case 'r':
+      case 'R':
+      case 'q':
+      case 'Q':
+        return 0; // REMOVE later if more complex check are performed
+        break;
+
+      default: break;
+    }
+
+    p++;
+  }
+
+  // TODO: add other checks than only insufficient material
+
+  // possible combinations of insufficient material:
+
+  return
+    (material == 0x00) || // king vs king
+    (material == 0x01) || // king and knight vs king
+    (material == 0x10) || // king and knight vs king
+    (material == 0x02) || // king and bishop vs king
+    (material == 0x20) || // king and bishop vs king
+    (material == 0x04) || // king and bishop vs king
+    (material == 0x40) || // king and bishop vs king
+    (material == 0x22) || // king and bishop vs king and bishop (same color)
+    (material == 0x44);   // king and bishop vs king and bishop (same color)
+}
+
+uint8_t SCL_boardGetPosition(SCL_Board board)
+{
+  uint8_t check = SCL_boardCheck(board,SCL_boardWhitesTurn(board));
+  uint8_t moves = SCL_boardMovePossible(board);
+
+  if (check)
+    return moves ? SCL_POSITION_CHECK : SCL_POSITION_MATE;
+  else if (!moves)
+    return SCL_POSITION_STALEMATE;
+
+  if (SCL_boardDead(board))
+    return SCL_POSITION_DEAD;
+
+  return SCL_POSITION_NORMAL;
+}
+
+uint8_t SCL_stringToMove(const char *moveString, uint8_t *resultFrom,
+  uint8_t *resultTo, char *resultPromotion)
+{
+  char c;
+
+  uint8_t *dst = resultFrom;
+
+  for (uint8_t i = 0; i < 2; ++i)
+  {
+    c = *moveString;
+
+    *dst = (c >= 'a') ? (c - 'a') : (c - 'A');
+
+    if (*dst > 7)
+      return 0;
+
+    moveString++;
+    c = *moveString;
+
+    *dst += 8 * (c - '1');
+
+    if (*dst > 63)
+      return 0;
+
+    moveString++;
+
+    dst = resultTo;
+  }
+
+  c = *moveString;
+
+  if (c < 'A')
+    c = c - 'A' + 'a';
+
+  switch (c)
+  {
+    case 'N': case 'n': *resultPromotion = 'n'; break;
+    case 'B': case 'b': *resultPromotion = 'b'; break;
+    case 'R': case 'r': *resultPromotion = 'r'; break;
+    case 'Q': case 'q':
+    default: *resultPromotion = 'q'; break;
+  }
+
+  return 1;
+}
+
+void SCL_printBoard(
+  SCL_Board board,
+  SCL_PutCharFunction putCharFunc,
+  SCL_SquareSet highlightSquares,
+  uint8_t selectSquare,
+  uint8_t format,
+  uint8_t offset,
+  uint8_t labels,
+  uint8_t blackDown)
+{
+  if (labels)
+  {
+    for (uint8_t i = 0; i < offset + 2; ++i)
+      putCharFunc(' ');
+
+    for (uint8_t i = 0; i < 8; ++i)
+    {
+      if ((format != SCL_PRINT_FORMAT_COMPACT) &&
+          (format != SCL_PRINT_FORMAT_COMPACT_UTF8))
+        putCharFunc(' ');
+
+      putCharFunc(blackDown ? ('H' - i) : ('A' + i));
+    }
+
+    putCharFunc('\n');
+  }
+
+  int8_t i = 7;
+  int8_t add = 1;
+
+  if (!blackDown)
+  {
+    i = 56;
+    add = -1;
+  }
+
+  for (int8_t row = 0; row < 8; ++row)
+  {
+    for (uint8_t j = 0; j < offset; ++j)
+      putCharFunc(' ');
+
+    if (labels)
+    {
+      putCharFunc(!blackDown ? ('8' - row) : ('1' + row));
+      putCharFunc(' ');
+    }
+
+    const char *square = board + i;
+
+    for (int8_t col = 0; col < 8; ++col)
+    {
+      switch (format)
+      {
+        case SCL_PRINT_FORMAT_COMPACT:
+          putCharFunc(
+            (*square == '.') ? (
+            ((i != selectSquare) ?
+              (!SCL_squareSetContains(highlightSquares,i) ? *square : '*')
+              : '#')) : *square);
+          break;
+
+        case SCL_PRINT_FORMAT_UTF8:
+        {
+          char squareChar = SCL_squareIsWhite(i) ? '.' : ',';
+          char pieceChar = (*square == '.') ? squareChar : *square;
+
+          if (i == selectSquare)
+          {
+            putCharFunc('(');
+
+            if (*square == '.')
+              putCharFunc(')');
+            else
+              SCL_printSquareUTF8(pieceChar,putCharFunc);
+          }
+          else if (!SCL_squareSetContains(highlightSquares,i))
+          {
+            SCL_printSquareUTF8(squareChar,putCharFunc);
+            SCL_printSquareUTF8(pieceChar,putCharFunc);
+          }
+          else
+          {
+            putCharFunc('[');
+
+            if (*square == '.')
+              putCharFunc(']');
+            else
+              SCL_printSquareUTF8(*square,putCharFunc);
+          }
+
+          break;
+        }
+
+        case SCL_PRINT_FORMAT_COMPACT_UTF8:
+          SCL_printSquareUTF8(
+            (*square == '.') ? (
+              SCL_squareSetContains(highlightSquares,i) ? '*' :
+              (i == selectSquare ? '#' : ((SCL_squareIsWhite(i) ? '.' : ',')))
+            ) : *square,putCharFunc);
+          break;
+
+        case SCL_PRINT_FORMAT_NORMAL:
+        default:
+        {
+          uint8_t c = *square;
+
+          char squareColor = SCL_squareIsWhite(i) ? ' ' : ':';
+
+          putCharFunc((i != selectSquare) ?
+            (!SCL_squareSetContains(highlightSquares,i) ?
+            squareColor : '#') : '@');
+
+          putCharFunc(c == '.' ? squareColor : *square);
+          break;
+        }
+      }
+
+      i -= add;
+      square -= add;
+    }
+
+    putCharFunc('\n');
+
+    i += add * 16;
+  } // for rows
+}
+
+int16_t SCL_pieceValuePositive(char piece)
+{
+  switch (piece)
+  {
+    case 'p':
+    case 'P': return SCL_VALUE_PAWN; break;
+    case 'n':
+    case 'N': return SCL_VALUE_KNIGHT; break;
+    case 'b':
+    case 'B': return SCL_VALUE_BISHOP; break;
+    case 'r':
+    case 'R': return SCL_VALUE_ROOK; break;
+    case 'q':
+    case 'Q': return SCL_VALUE_QUEEN; break;
+    case 'k':
+    case 'K': return SCL_VALUE_KING; break;
+    default: break;
+  }
+
+  return 0;
+}
+
+int16_t SCL_pieceValue(char piece)
+{
+  switch (piece)
+  {
+    case 'P': return SCL_VALUE_PAWN; break;
+    case 'N': return SCL_VALUE_KNIGHT; break;
+    case 'B': return SCL_VALUE_BISHOP; break;
+    case 'R': return SCL_VALUE_ROOK; break;
+    case 'Q': return SCL_VALUE_QUEEN; break;
+    case 'K': return SCL_VALUE_KING; break;
+    case 'p': return -1 * SCL_VALUE_PAWN; break;
+    case 'n': return -1 * SCL_VALUE_KNIGHT; break;
+    case 'b': return -1 * SCL_VALUE_BISHOP; break;
+    case 'r': return -1 * SCL_VALUE_ROOK; break;
+    case 'q': return -1 * SCL_VALUE_QUEEN; break;
+    case 'k': return -1 * SCL_VALUE_KING; break;
+    default: break;
+  }
+
+  return 0;
+}
+
+#define ATTACK_BONUS 3
+#define MOBILITY_BONUS 10
+#define CENTER_BONUS 7
+#define CHECK_BONUS 5
+#define KING_CASTLED_BONUS 30
+#define KING_BACK_BONUS 15
+#define KING_NOT_CENTER_BONUS 15
+#define PAWN_NON_DOUBLE_BONUS 3
+#define PAWN_PAIR_BONUS 3
+#define KING_CENTERNESS 10
+
+int16_t _SCL_rateKingEndgamePosition(uint8_t position)
+{
+  int16_t result = 0;
+  uint8_t rank = position / 8;
+  position %= 8;
+
+  if (position > 1 && position < 6)
+    result += KING_CENTERNESS;
+
+  if (rank > 1 && rank < 6)
+    result += KING_CENTERNESS;
+
+  return result;
+}
+
+int16_t SCL_boardEvaluateStatic(SCL_Board board)
+{
+  uint8_t position = SCL_boardGetPosition(board);
+
+  int16_t total = 0;
+
+  switch (position)
+  {
+    case SCL_POSITION_MATE:
+      return SCL_boardWhitesTurn(board) ?
+        -1 * SCL_EVALUATION_MAX_SCORE : SCL_EVALUATION_MAX_SCORE;
+      break;
+
+    case SCL_POSITION_STALEMATE:
+    case SCL_POSITION_DEAD:
+      return 0;
+      break;
+
+    /*
+      main points are assigned as follows:
+      - points for material as a sum of all material on board
+      - for playing side: if a piece attacks piece of greater value, a fraction
+        of the value difference is gained (we suppose exchange), this is only
+        gained once per every attacking piece (maximum gain is taken), we only
+        take fraction so that actually taking the piece is favored
+      - ATTACK_BONUS points for any attacked piece
+
+      other points are assigned as follows (in total these shouldn't be more
+      than the value of one pawn)
+      - mobility: MOBILITY_BONUS points for each piece with at least 4 possible
+        moves
+      - center control: CENTER_BONUS points for a piece on a center square
+      - CHECK_BONUS points for check
+      - king:
+        - safety (non endgame): KING_BACK_BONUS points for king on staring rank,
+          additional KING_CASTLED_BONUS if the kind if on castled square or
+          closer to the edge, additional KING_NOT_CENTER_BONUS for king not on
+          its start neighbouring center square
+        - center closeness (endgame): up to 2 * KING_CENTERNESS points for
+          being closer to center
+      - non-doubled pawns: PAWN_NON_DOUBLE_BONUS points for each pawn without
+        same color pawn directly in front of it
+      - pawn structure: PAWN_PAIR_BONUS points for each pawn guarding own pawn
+      - advancing pawns: 1 point for each pawn's rank in its move
+        direction
+    */
+
+    case SCL_POSITION_CHECK:
+      total += SCL_boardWhitesTurn(board) ? -1 * CHECK_BONUS : CHECK_BONUS;
+      // fall through
+    case SCL_POSITION_NORMAL:
+    default:
+    {
+      SCL_SquareSet moves;
+
+      const char *p = board;
+
+      int16_t positiveMaterial = 0;
+      uint8_t endgame = 0;
+
+      // first count material to see if this is endgame or not
+      for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i, ++p)
+      {
+        char s = *p;
+
+        if (s != '.')
+        {
+          positiveMaterial += SCL_pieceValuePositive(s);
+          total += SCL_pieceValue(s);
+        }
+      }
+
+      endgame = positiveMaterial <= SCL_ENDGAME_MATERIAL_LIMIT;
+
+      p = board;
+
+      for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i, ++p)
+      {
+        char s = *p;
+
+        if (s != '.')
+        {
+          uint8_t white = SCL_pieceIsWhite(s);
+
+          switch (s)
+          {
+            case 'k': // king safety
+              if (endgame)
+                total -= _SCL_rateKingEndgamePosition(i);
+              else if (i >= 56)
+              {
+                total -= KING_BACK_BONUS;
+
+                if (i != 59)
+                {
+                  total -= KING_NOT_CENTER_BONUS;
+
+                  if (i >= 62 || i <= 58)
+                    total -= KING_CASTLED_BONUS;
+                }
+              }
+            break;
+
+            case 'K':
+              if (endgame)
+                total += _SCL_rateKingEndgamePosition(i);
+              else if (i <= 7)
+              {
+                total += KING_BACK_BONUS;
+
+                if (i != 3)
+                {
+                  total += KING_NOT_CENTER_BONUS;
+
+                  if (i <= 2 || i >= 6)
+                    total += KING_CASTLED_BONUS;
+                }
+              }
+            break;
+
+            case 'P': // pawns
+            case 'p':
+            {
+              int8_t rank = i / 8;
+
+              if (rank != 0 && rank != 7)
+              {
+                if (s == 'P')
+                {
+                  total += rank;
+
+                  char *tmp = board + i + 8;
+
+                  if (*tmp != 'P')
+                    total += PAWN_NON_DOUBLE_BONUS;
+
+                  if (i % 8 != 7)
+                  {
+                    tmp++;
+
+                    if (*tmp == 'P')
+                      total += PAWN_PAIR_BONUS;
+
+                    if (*(tmp - 16) == 'P')
+                      total += PAWN_PAIR_BONUS;
+                  }
+                }
+                else
+                {
+                  total -= 7 - rank;
+
+                  char *tmp = board + i - 8;
+
+                  if (*tmp != 'p')
+                    total -= PAWN_NON_DOUBLE_BONUS;
+
+                  if (i % 8 != 7)
+                  {
+                    tmp += 17;
+
+                    if (*tmp == 'p')
+                      total -= PAWN_PAIR_BONUS;
+
+                    if (*(tmp - 16) == 'p')
+                      total -= PAWN_PAIR_BONUS;
+                  }
+                }
+              }
+
+              break;
+            }
+
+            default: break;
+          }
+
+          if (i >= 27 && i <= 36 && (i >= 35 || i <= 28)) // center control
+            total += white ? CENTER_BONUS : (-1 * CENTER_BONUS);
+
+          // for performance we only take pseudo moves
+          SCL_boardGetPseudoMoves(board,i,0,moves);
+
+          if (SCL_squareSetSize(moves) >= 4) // mobility
+            total += white ?
+              MOBILITY_BONUS : (-1 * MOBILITY_BONUS);
+
+          int16_t exchangeBonus = 0;
+
+          SCL_SQUARE_SET_ITERATE_BEGIN(moves)
+
+            if (board[iteratedSquare] != '.')
+            {
+              total += white ?
+                ATTACK_BONUS : (- 1 * ATTACK_BONUS);
+
+              if (SCL_boardWhitesTurn(board) == white)
+              {
+                int16_t valueDiff =
+                  SCL_pieceValuePositive(board[iteratedSquare]) -
+                  SCL_pieceValuePositive(s);
+
+                valueDiff /= 4; // only take a fraction to favor taking
+
+                if (valueDiff > exchangeBonus)
+                  exchangeBonus = valueDiff;
+              }
+            }
+
+          SCL_SQUARE_SET_ITERATE_END
+
+          if (exchangeBonus != 0)
+            total += white ? exchangeBonus : -1 * exchangeBonus;
+        }
+      } // for each square
+
+      return total;
+
+      break;
+
+    } // normal position
+  } // switch
+
+  return 0;
+}
+
+#undef ATTACK_BONUS
+#undef MOBILITY_BONUS
+#undef CENTER_BONUS
+#undef CHECK_BONUS
+#undef KING_CASTLED_BONUS
+#undef KING_BACK_BONUS
+#undef PAWN_NON_DOUBLE_BONUS
+#undef PAWN_PAIR_BONUS
+#undef KING_CENTERNESS
+
+/**
+  Checks if there are only kings and at most one minor piece left.
+*/
+static inline uint8_t _SCL_positionMaterialDraw(const SCL_Position *position)
+{
+  return position->phase <= 1 && position->pieces[SCL_PIECE_PAWN] == 0;
+}
+
+#define _SCL_FILE_A 0x0101010101010101ULL
+#define _SCL_FILE_H 0x8080808080808080ULL
+
+/**
+  Returns the squares attacked by given pawns of given color.
+*/
+static inline SCL_Bitboard _SCL_pawnsAttacks(SCL_Bitboard pawns,
+  uint8_t white)
+{
+  return white ?
+    (((pawns & ~_SCL_FILE_A) << 7) | ((pawns & ~_SCL_FILE_H) << 9)) :
+    (((pawns & ~_SCL_FILE_A) >> 9) | ((pawns & ~_SCL_FILE_H) >> 7));
+}
+
+/**
+  Extends each set square of a bitboard to all squares above (fill up) or
+  below (fill down) it, the square itself included.
+*/
+static inline SCL_Bitboard _SCL_bitboardFillUp(SCL_Bitboard bitboard)
+{
+  bitboard |= bitboard << 8;
+  bitboard |= bitboard << 16;
+  return bitboard | (bitboard << 32);
+}
+
+static inline SCL_Bitboard _SCL_bitboardFillDown(SCL_Bitboard bitboard)
+{
+  bitboard |= bitboard >> 8;
+  bitboard |= bitboard >> 16;
+  return bitboard | (bitboard >> 32);
+}
+
+/** Pawn structure penalties, in 1/256 of a pawn, opening and endgame. */
+static const uint8_t _SCL_pawnDoubledPenalty[2] = {10, 20};
+static const uint8_t _SCL_pawnIsolatedPenalty[2] = {10, 15};
+static const uint8_t _SCL_pawnBackwardPenalty[2] = {8, 10};
+
+/** Passed pawn bonus by rank in the pawn's move direction, in 1/256 of a
+  pawn, opening and endgame. */
+static const uint8_t _SCL_passedPawnBonus[2][8] =
+{
+  {0, 2, 4,  8, 16, 32,  52, 0},
+  {0, 6, 10, 20, 40, 70, 110, 0}
+};
+
+static inline uint64_t _SCL_pawnEntryData(const SCL_PawnEntry *entry)
+{
+  return entry->passed ^ entry->attackSpans[0] ^
+    (entry->attackSpans[1] * 0x9e3779b97f4a7c15ULL) ^
+    (((uint64_t) (uint16_t) entry->score[0]) << 16) ^
+    ((uint64_t) (uint16_t) entry->score[1]);
+}
+
+/**
+  Evaluates the pawn structure of a position without the pawn table.
+*/
+void _SCL_pawnStructureCompute(const SCL_Position *position,
+  SCL_PawnEntry *entry)
+{
+  SCL_Bitboard pawns[2], attacks[2];
+
+  for (uint8_t color = 0; color < 2; ++color)
+  {
+    pawns[color] = position->pieces[SCL_PIECE_PAWN] & position->colors[color];
+    attacks[color] = _SCL_pawnsAttacks(pawns[color],color == 0);
+  }
+
+  entry->key = position->pawnKey;
+  entry->attackSpans[0] = _SCL_bitboardFillUp(attacks[0]);
+  entry->attackSpans[1] = _SCL_bitboardFillDown(attacks[1]);
+
+  // no enemy pawn in front on the same or neighbouring file
+
+  entry->passed =
+    (pawns[0] & ~(_SCL_bitboardFillDown(pawns[1] >> 8) |
+      entry->attackSpans[1])) |
+    (pawns[1] & ~(_SCL_bitboardFillUp(pawns[0] << 8) |
+      entry->attackSpans[0]));
+
+  entry->score[0] = 0;
+  entry->score[1] = 0;
+
+  for (uint8_t color = 0; color < 2; ++color)
+  {
+    SCL_Bitboard own = pawns[color];
+
+    SCL_Bitboard files = _SCL_bitboardFillUp(own) | _SCL_bitboardFillDown(own);
+
+    SCL_Bitboard isolated = own &
+      ~(((files & ~_SCL_FILE_H) << 1) | ((files & ~_SCL_FILE_A) >> 1));
+
+    // pawns with an own pawn behind them
+    SCL_Bitboard doubled = own & (color == 0 ?
+      _SCL_bitboardFillUp(own << 8) : _SCL_bitboardFillDown(own >> 8));
+
+    /* Pawns whose stop square is attacked by an enemy pawn and no own pawn
+       can ever guard it, i.e. which can't advance safely. */
+    SCL_Bitboard backward = color == 0 ?
+      (((own << 8) & ~entry->attackSpans[0] & attacks[1]) >> 8) :
+      (((own >> 8) & ~entry->attackSpans[1] & attacks[0]) << 8);
+
+    backward &= ~isolated;
+
+    SCL_Bitboard passed = entry->passed & own;
+
+    for (uint8_t phase = 0; phase < 2; ++phase)
+    {
+      int16_t score = -1 * (
+        SCL_bitboardCount(doubled) * _SCL_pawnDoubledPenalty[phase] +
+        SCL_bitboardCount(isolated) * _SCL_pawnIsolatedPenalty[phase] +
+        SCL_bitboardCount(backward) * _SCL_pawnBackwardPenalty[phase]);
+
+      SCL_Bitboard b = passed;
+
+      while (b != 0)
+      {
+        uint8_t square = SCL_bitboardFirst(b);
+
+        b &= b - 1;
+
+        score += _SCL_passedPawnBonus[phase][color == 0 ?
+          square / 8 : 7 - square / 8];
+      }
+
+      score = ((int32_t) score) * SCL_VALUE_PAWN / 256;
+
+      entry->score[phase] += color == 0 ? score : -1 * score;
+    }
+  }
+}
+
+void SCL_positionPawnStructure(const SCL_Position *position,
+  SCL_PawnEntry *entry)
+{
+#if SCL_PAWN_TABLE_SIZE != 0
+  SCL_PawnEntry *slot = SCL_pawnTable.entries +
+    (position->pawnKey & (SCL_PAWN_TABLE_SIZE - 1));
+
+  SCL_pawnTable.probes++;
+
+  *entry = *slot;
+
+  if ((entry->key ^ _SCL_pawnEntryData(entry)) == position->pawnKey)
+  {
+    entry->key = position->pawnKey;
+    SCL_pawnTable.hits++;
+    return;
+  }
+#endif
+
+  _SCL_pawnStructureCompute(position,entry);
+
+#if SCL_PAWN_TABLE_SIZE != 0
+  *slot = *entry;
+  slot->key ^= _SCL_pawnEntryData(entry);
+#endif
+}
+
+/**
+  SCL_positionEvaluateTapered which also returns the pawn structure it used.
+*/
+int16_t _SCL_positionEvaluateTapered(const SCL_Position *position,
+  SCL_PawnEntry *pawns)
+{
+  uint8_t phase = position->phase < _SCL_PHASE_MAX ?
+    position->phase : _SCL_PHASE_MAX;
+
+  SCL_positionPawnStructure(position,pawns);
+
+  if (_SCL_positionMaterialDraw(position))
+    return 0;
+
+  return (((int32_t) position->score[0] + pawns->score[0]) * phase +
+    ((int32_t) position->score[1] + pawns->score[1]) *
+    (_SCL_PHASE_MAX - phase)) / _SCL_PHASE_MAX;
+}
+
+int16_t SCL_positionEvaluateTapered(const SCL_Position *position)
+{
+  SCL_PawnEntry pawns;
+
+  return _SCL_positionEvaluateTapered(position,&pawns);
+}
+
+#define _SCL_LAZY_EVALUATION_MARGIN (SCL_VALUE_PAWN * 2)
+#define _SCL_ATTACK_BONUS 4
+
+/** Mobility bonus per attacked square of N B R Q and the usual square count
+  which is subtracted from the count first. */
+static const uint8_t _SCL_mobilityWeights[4] = {8, 6, 4, 2};
+static const uint8_t _SCL_mobilityBaselines[4] = {4, 6, 7, 13};
+
+/** Bonus of a knight and bishop on an outpost. */
+static const uint8_t _SCL_outpostBonus[2] = {16, 8};
+
+/** Ranks 4 to 6 of white (0) and black (1), where outposts can be. */
+static const SCL_Bitboard _SCL_outpostRanks[2] =
+  {0x0000ffffff000000ULL, 0x000000ffffff0000ULL};
+
+/**
+  Mobility and attack terms of SCL_positionEvaluate, positive favoring white
+  and bounded by _SCL_LAZY_EVALUATION_MARGIN. Pieces get points for attacked
+  squares not occupied by own pieces and for attacked enemy pieces, the player
+  to move also gets a fraction of the value he'd likely win by taking a piece
+  with a less valuable one. Knights and bishops get points for outposts, i.e.
+  squares in the enemy half guarded by own pawns which no enemy pawn can
+  attack.
+*/
+int16_t _SCL_positionEvaluateActivity(const SCL_Position *position,
+  const SCL_PawnEntry *pawnStructure)
+{
+  const int16_t values[6] = {SCL_VALUE_PAWN, SCL_VALUE_KNIGHT,
+    SCL_VALUE_BISHOP, SCL_VALUE_ROOK, SCL_VALUE_QUEEN, SCL_VALUE_KING};
+
+  const SCL_Bitboard *p = position->pieces;
+  uint8_t whitesTurn = SCL_positionWhitesTurn(position);
+  int16_t total = 0;
+
+  for (uint8_t color = 0; color < 2; ++color)
+  {
+    SCL_Bitboard own = position->colors[color];
+    SCL_Bitboard enemy = position->colors[!color];
+    SCL_Bitboard attacked[5]; // by piece type, P to Q
+    int16_t score = 0;
+
+    attacked[SCL_PIECE_PAWN] =
+      _SCL_pawnsAttacks(own & p[SCL_PIECE_PAWN],color == 0);
+
+    SCL_Bitboard outposts = attacked[SCL_PIECE_PAWN] &
+      _SCL_outpostRanks[color] & ~pawnStructure->attackSpans[!color];
+
+    score += _SCL_outpostBonus[0] *
+      SCL_bitboardCount(outposts & own & p[SCL_PIECE_KNIGHT]) +
+      _SCL_outpostBonus[1] *
+      SCL_bitboardCount(outposts & own & p[SCL_PIECE_BISHOP]);
+
+    for (uint8_t type = SCL_PIECE_KNIGHT; type <= SCL_PIECE_QUEEN; ++type)
+    {
+      SCL_Bitboard pieces = own & p[type];
+
+      attacked[type] = 0;
+
+      while (pieces != 0)
+      {
+        uint8_t square = SCL_bitboardFirst(pieces);
+        SCL_Bitboard attacks = 0;
+
+        pieces &= pieces - 1;
+
+        if (type == SCL_PIECE_KNIGHT)
+          attacks = _SCL_knightAttacks[square];
+
+        if (type == SCL_PIECE_BISHOP || type == SCL_PIECE_QUEEN)
+          attacks |= _SCL_bishopAttacks(square,position->occupied);
+
+        if (type == SCL_PIECE_ROOK || type == SCL_PIECE_QUEEN)
+          attacks |= _SCL_rookAttacks(square,position->occupied);
+
+        attacked[type] |= attacks;
+
+        score += _SCL_mobilityWeights[type - 1] *
+          (SCL_bitboardCount(attacks & ~own) -
+          _SCL_mobilityBaselines[type - 1]);
+      }
+    }
+
+    SCL_Bitboard all = attacked[0] | attacked[1] | attacked[2] |
+      attacked[3] | attacked[4];
+
+    score += _SCL_ATTACK_BONUS * SCL_bitboardCount(all & enemy);
+
+    if (whitesTurn == (color == 0))
+    {
+      int16_t exchangeBonus = 0;
+
+      for (uint8_t victim = SCL_PIECE_KNIGHT; victim <= SCL_PIECE_QUEEN;
+        ++victim)
+        for (uint8_t attacker = SCL_PIECE_PAWN; attacker < victim; ++attacker)
+          if (enemy & p[victim] & attacked[attacker])
+          {
+            // only take a fraction to favor taking
+
+            int16_t valueDiff = (values[victim] - values[attacker]) / 4;
+
+            if (valueDiff > exchangeBonus)
+              exchangeBonus = valueDiff;
+
+            break;
+          }
+
+      score += exchangeBonus;
+    }
+
+    total += color == 0 ? score : -1 * score;
+  }
+
+  if (total > _SCL_LAZY_EVALUATION_MARGIN)
+    total = _SCL_LAZY_EVALUATION_MARGIN;
+  else if (total < -1 * _SCL_LAZY_EVALUATION_MARGIN)
+    total = -1 * _SCL_LAZY_EVALUATION_MARGIN;
+
+  return total;
+}
+
+int16_t SCL_positionEvaluate(const SCL_Position *position)
+{
+  SCL_PawnEntry pawns;
+  int16_t score = _SCL_positionEvaluateTapered(position,&pawns);
+
+  return _SCL_positionMaterialDraw(position) ? 0 :
+    score + _SCL_positionEvaluateActivity(position,&pawns);
+}
+
+int16_t SCL_boardEvaluateTapered(SCL_Board board)
+{
+  switch (SCL_boardGetPosition(board))
+  {
+    case SCL_POSITION_MATE:
+      return SCL_boardWhitesTurn(board) ?
+        -1 * SCL_EVALUATION_MAX_SCORE : SCL_EVALUATION_MAX_SCORE;
+      break;
+
+    case SCL_POSITION_STALEMATE:
+    case SCL_POSITION_DEAD:
+      return 0;
+      break;
+
+    default: break;
+  }
+
+  SCL_Position position;
+
+  SCL_positionFromBoard(&position,board);
+
+  return SCL_positionEvaluate(&position);
+}
+
+#if SCL_NNUE
+int16_t SCL_positionEvaluateNNUE(SCL_Position *position)
+{
+  if (_SCL_positionMaterialDraw(position))
+    return 0;
+
+  SCL_NNUEAccumulator *accumulator = &position->nnue;
+
+  if (!accumulator->active)
+    SCL_positionNNUERefresh(position);
+
+  for (uint8_t p = 0; p < 2; ++p)
+    if (accumulator->stale[p])
+      _SCL_nnueRefreshPerspective(position,p);
+
+  uint8_t us = !SCL_positionWhitesTurn(position);
+
+  int32_t score = (_SCL_nnueOutput(accumulator->values[us],
+    SCL_nnueNetwork.outputWeights) + _SCL_nnueOutput(accumulator->values[!us],
+    SCL_nnueNetwork.outputWeights + SCL_NNUE_HIDDEN) +
+    SCL_nnueNetwork.outputBias) / SCL_nnueNetwork.outputDivisor;
+
+  if (score > _SCL_NNUE_MAX_SCORE)
+    score = _SCL_NNUE_MAX_SCORE;
+  else if (score < -1 * _SCL_NNUE_MAX_SCORE)
+    score = -1 * _SCL_NNUE_MAX_SCORE;
+
+  return us == 0 ? score : -1 * score;
+}
+
+int16_t SCL_boardEvaluateNNUE(SCL_Board board)
+{
+  switch (SCL_boardGetPosition(board))
+  {
+    case SCL_POSITION_MATE:
+      return SCL_boardWhitesTurn(board) ?
+        -1 * SCL_EVALUATION_MAX_SCORE : SCL_EVALUATION_MAX_SCORE;
+      break;
+
+    case SCL_POSITION_STALEMATE:
+    case SCL_POSITION_DEAD:
+      return 0;
+      break;
+
+    default: break;
+  }
+
+  SCL_Position position;
+
+  SCL_positionFromBoard(&position,board);
+
+  return SCL_positionEvaluateNNUE(&position);
+}
+#endif
+
+void _SCL_searchContextInit(SCL_SearchContext *context,
+  SCL_StaticEvaluationFunction evalFunction, uint8_t extensionExtraDepth)
+{
+  uint8_t *byte = (uint8_t *) context;
+
+  for (uint32_t i = 0; i < sizeof(SCL_SearchContext); ++i)
+    byte[i] = 0; // SCL_MOVE_NONE is 0
+
+  context->evalFunction = evalFunction;
+  context->depthHardLimit = -1 * extensionExtraDepth;
+  context->limits = 0;
+  context->stop = 0;
+}
+
+/**
+  Returns the time limit of a search, which may have been changed by another
+  thread through SCL_SearchLimits.newTime.
+*/
+uint32_t _SCL_searchTimeLimit(const SCL_SearchLimits *limits)
+{
+  uint32_t time = limits->newTime != 0 ? *limits->newTime : 0;
+
+  return time != 0 ? time : limits->time;
+}
+
+void _SCL_checkSearchLimits(SCL_SearchContext *context)
+{
+  const SCL_SearchLimits *limits = context->limits;
+  uint32_t time = _SCL_searchTimeLimit(limits);
+
+  if ((limits->nodes != 0 && context->nodes >= limits->nodes) ||
+    (time != 0 && limits->timeFunction != 0 &&
+    limits->timeFunction() - context->startTime >= time) ||
+    (limits->stop != 0 && *limits->stop))
+    context->abort = 1;
+}
+
+/**
+  Clears the transposition table and the evaluation cache if the search is
+  going to use a different evaluation function than the one with which the
+  stored scores were computed.
+*/
+void _SCL_transpositionTableCheckFunction(
+  SCL_StaticEvaluationFunction evalFunction)
+{
+  if (evalFunction != SCL_transpositionTable.evaluationFunction)
+  {
+    SCL_transpositionTableClear(&SCL_transpositionTable);
+    SCL_transpositionTable.evaluationFunction = evalFunction;
+  }
+
+  if (evalFunction != SCL_evaluationCache.evaluationFunction)
+  {
+    SCL_evaluationCacheClear(&SCL_evaluationCache);
+    SCL_evaluationCache.evaluationFunction = evalFunction;
+  }
+}
+
+/**
+  Gets the transposition table key of a search node. Besides the position the
+  search result depends on the quiescence search depth limit, so it is mixed
+  in.
+*/
+uint64_t _SCL_searchKey(const SCL_Board board, int8_t depthLimit)
+{
+  return SCL_boardKey(board) ^
+    (0x9e3779b97f4a7c15 * (1 + (uint16_t) (uint8_t) depthLimit));
+}
+
+/**
+  Gets the transposition table key of the root of _SCL_getAIMove. Root result
+  also depends on the repetition move, which gets 0 score, and on the root
+  moves excluded from the search.
+*/
+uint64_t _SCL_rootKey(const SCL_SearchContext *context, const SCL_Board board,
+  uint8_t extensionExtraDepth, uint8_t repetitionMoveFrom,
+  uint8_t repetitionMoveTo)
+{
+  uint64_t key = _SCL_searchKey(board,-1 * extensionExtraDepth)
+    ^ (0xc2b2ae3d27d4eb4f * (1 + repetitionMoveFrom +
+    (((uint16_t) repetitionMoveTo) << 8)));
+
+  for (uint8_t i = 0; i < context->excludedCount; ++i)
+    key ^= 0xd6e8feb86659fd93 * (1 + (uint64_t) context->excludedMoves[i]);
+
+  return key;
+}
+
+/**
+  Removes the context's excluded moves from a root move list.
+*/
+void _SCL_removeExcludedMoves(const SCL_SearchContext *context,
+  SCL_MoveList *moves)
+{
+  uint16_t count = 0;
+
+  for (uint16_t i = 0; i < moves->count; ++i)
+  {
+    uint8_t excluded = 0;
+
+    for (uint8_t j = 0; j < context->excludedCount; ++j)
+      if (moves->moves[i] == context->excludedMoves[j])
+      {
+        excluded = 1;
+        break;
+      }
+
+    if (!excluded)
+    {
+      moves->moves[count] = moves->moves[i];
+      count++;
+    }
+  }
+
+  moves->count = count;
+}
+
+/**
+  Counts a searched node and checks the search limits and the stop flag,
+  returns 1 if the search should be aborted.
+*/
+uint8_t _SCL_searchNode(SCL_SearchContext *context)
+{
+#if SCL_CALL_WDT_RESET
+  wdt_reset();
+#endif
+
+  context->nodes++;
+
+  if ((context->nodes & 0xff) == 0) // not every node, getting time may be slow
+  {
+    if (context->limits != 0)
+      _SCL_checkSearchLimits(context);
+
+    if (context->stop != 0 && *context->stop)
+      context->abort = 1;
+  }
+
+  return context->abort;
+}
+
+#define _SCL_DELTA_MARGIN (SCL_VALUE_PAWN * 2) ///< for quiescence delta pruning
+
+/**
+  Static evaluation of a searched position from the point of view of the player
+  to move. SCL_boardEvaluateTapered isn't called but read from the score kept
+  in the position, and its mobility and attack terms are only added if the
+  score is close enough to the alpha-beta window for them to get it inside
+  (lazy evaluation). SCL_boardEvaluateNNUE is computed from the position's
+  accumulator.
+*/
+int16_t _SCL_searchEvaluate(SCL_SearchContext *context,
+  SCL_Position *position, int16_t alpha, int16_t beta)
+{
+  int8_t sign = SCL_positionWhitesTurn(position) ? 1 : -1;
+
+#ifndef SCL_EVALUATION_FUNCTION
+  SCL_StaticEvaluationFunction evalFunction = context->evalFunction;
+#else
+  SCL_StaticEvaluationFunction evalFunction = SCL_EVALUATION_FUNCTION;
+  SCL_UNUSED(context);
+#endif
+
+#if SCL_NNUE
+  if (evalFunction == SCL_boardEvaluateNNUE)
+    return sign * SCL_positionEvaluateNNUE(position);
+#endif
+
+  if (evalFunction != SCL_boardEvaluateTapered)
+    return sign * _SCL_evaluationCacheEvaluate(evalFunction,position->board);
+
+  SCL_PawnEntry pawns;
+  int16_t score = sign * _SCL_positionEvaluateTapered(position,&pawns);
+
+  if (score + _SCL_LAZY_EVALUATION_MARGIN <= alpha ||
+    score - _SCL_LAZY_EVALUATION_MARGIN >= beta ||
+    _SCL_positionMaterialDraw(position))
+    return score;
+
+  return score + sign * _SCL_positionEvaluateActivity(position,&pawns);
+}
+
+/**
+  Returns the material a move gains (captured piece plus promotion), 0 for
+  quiet moves.
+*/
+int16_t _SCL_moveGain(const SCL_Board board, SCL_Move move)
+{
+  switch (SCL_moveType(move))
+  {
+    case SCL_MOVE_EN_PASSANT: return SCL_VALUE_PAWN; break;
+    case SCL_MOVE_CASTLING: return 0; break; // in 960 "takes" own rook
+
+    case SCL_MOVE_PROMOTION:
+      return SCL_pieceValuePositive(board[SCL_moveTo(move)]) +
+        SCL_pieceValuePositive(SCL_movePromotion(move)) - SCL_VALUE_PAWN;
+      break;
+
+    default: break;
+  }
+
+  return SCL_pieceValuePositive(board[SCL_moveTo(move)]);
+}
+
+/**
+  Gives moves their order for _SCL_pickMove: the hash move first, then captures
+  and promotions from the most valuable victim and least valuable attacker
+  (MVV-LVA), then quiet moves.
+*/
+void _SCL_orderMoves(const SCL_Board board, const SCL_MoveList *moves,
+  int16_t *order, SCL_Move hashMove)
+{
+  for (uint16_t i = 0; i < moves->count; ++i)
+  {
+    SCL_Move m = moves->moves[i];
+    int16_t gain = _SCL_moveGain(board,m);
+
+    order[i] = (m == hashMove) ? 32767 : (gain == 0 ? 0 :
+      (gain * 4 - SCL_pieceValuePositive(board[SCL_moveFrom(m)]) / 4));
+  }
+}
+
+/**
+  Returns the i-th move in order given by _SCL_orderMoves, supposing moves
+  before it have already been picked, only considering moves before end.
+  Picking one by one is faster than sorting as there is often a cutoff after a
+  few moves.
+*/
+SCL_Move _SCL_pickMove(SCL_MoveList *moves, int16_t *order, uint16_t i,
+  uint16_t end)
+{
+  uint16_t pick = i;
+
+  for (uint16_t j = i + 1; j < end; ++j)
+    if (order[j] > order[pick])
+      pick = j;
+
+  SCL_Move result = moves->moves[pick];
+
+  moves->moves[pick] = moves->moves[i];
+  order[pick] = order[i];
+
+  return result;
+}
+
+/**
+  Quiescence search: instead of evaluating a position in the middle of an
+  exchange, only captures (and queen promotions) are searched further until the
+  position is quiet. The side to move can also choose not to capture and take
+  the static evaluation (stand pat), which is also a lower bound of the score.
+  In check all moves are searched as standing pat isn't possible. Captures are
+  tried in MVV-LVA order, ones that can't raise the score to alpha even when
+  winning the piece for free are skipped (delta pruning). Depth goes from 0 down
+  to the depth hard limit, ply is the distance from the root used for mate
+  scores. The score is from the point of view of the player to move.
+*/
+int16_t _SCL_quiescence(SCL_SearchContext *context, SCL_Position *position,
+  int16_t alpha, int16_t beta, int8_t depth, uint8_t ply)
+{
+  if (_SCL_searchNode(context))
+    return 0;
+
+  const char *board = position->board;
+  SCL_MoveList moves;
+  int16_t order[SCL_MOVE_LIST_MAX_LENGTH];
+  uint8_t whitesTurn = SCL_positionWhitesTurn(position);
+  int16_t standPat = _SCL_searchEvaluate(context,position,alpha,beta);
+
+  if (standPat == -1 * SCL_EVALUATION_MAX_SCORE)
+    return standPat + ply; // mated, prefer later mates
+
+  uint8_t check = SCL_positionCheck(position,whitesTurn);
+  int16_t best = check ? (-1 * SCL_EVALUATION_MAX_SCORE + ply) : standPat;
+
+  if (depth <= context->depthHardLimit || (!check && standPat >= beta))
+    return standPat;
+
+  if (best > alpha)
+    alpha = best;
+
+#if SCL_QUIESCENCE_CHECKS
+  if (check || depth == 0)
+#else
+  if (check)
+#endif
+    SCL_positionGetMoves(position,&moves);
+  else
+    SCL_positionGetCaptures(position,&moves);
+
+  _SCL_orderMoves(board,&moves,order,SCL_MOVE_NONE);
+
+  for (uint16_t i = 0; i < moves.count; ++i)
+  {
+    SCL_Move m = _SCL_pickMove(&moves,order,i,moves.count);
+    int16_t gain = _SCL_moveGain(board,m);
+    uint8_t from = SCL_moveFrom(m);
+    uint8_t to = SCL_moveTo(m);
+    char promotion = SCL_movePromotion(m);
+
+    if (!check)
+    {
+      if (SCL_moveType(m) == SCL_MOVE_PROMOTION && promotion != 'q')
+        continue; // underpromotions are too rare to be worth it
+
+      if (gain != 0 && standPat + gain + _SCL_DELTA_MARGIN <= alpha)
+        continue; // even winning the material for free can't help
+    }
+
+    SCL_PositionUndo undo = SCL_positionMakeMove(position,from,to,promotion);
+
+#if SCL_QUIESCENCE_CHECKS
+    if (!check && gain == 0 && !SCL_positionCheck(position,!whitesTurn))
+    {
+      SCL_positionUndoMove(position,undo); // only checks of the quiet moves
+      continue;
+    }
+#endif
+
+    int16_t value = -1 * _SCL_quiescence(context,position,-1 * beta,
+      -1 * alpha,depth - 1,ply + 1);
+
+    SCL_positionUndoMove(position,undo);
+
+    if (context->abort)
+      return 0;
+
+    if (value > best)
+    {
+      best = value;
+
+      if (value > alpha)
+      {
+        alpha = value;
+
+        if (value >= beta)
+          break;
+      }
+    }
+  }
+
+  return best;
+}
+
+#if SCL_SEARCH_NEGAMAX
+
+#define _SCL_SCORE_INFINITY (SCL_EVALUATION_MAX_SCORE + 1)
+#define _SCL_ASPIRATION_WINDOW (SCL_VALUE_PAWN / 4)
+#define _SCL_HISTORY_MAX 16384
+
+/**
+  Changes a history score by given bonus (or malus if negative) so that it
+  stays within _SCL_HISTORY_MAX, with bigger changes the further it is from it.
+*/
+void _SCL_historyUpdate(int16_t *history, int16_t bonus)
+{
+  *history += bonus - ((int32_t) *history) * (bonus < 0 ? -1 * bonus : bonus) /
+    _SCL_HISTORY_MAX;
+}
+
+#define _SCL_NULL_MOVE_MIN_DEPTH 3
+#define _SCL_REVERSE_FUTILITY_MAX_DEPTH 3
+#define _SCL_REVERSE_FUTILITY_MARGIN SCL_VALUE_PAWN ///< per depth
+#define _SCL_FUTILITY_MAX_DEPTH 2
+#define _SCL_FUTILITY_MARGIN (SCL_VALUE_PAWN * 3 / 2) ///< per depth
+#define _SCL_LMR_MIN_DEPTH 3
+#define _SCL_LMR_MIN_MOVES 3 ///< moves searched before reducing
+
+/// whether search needs the static evaluation of non-leaf positions
+#define _SCL_SEARCH_STATIC_EVALUATION (SCL_ALPHA_BETA && \
+  (SCL_NULL_MOVE_PRUNING || SCL_REVERSE_FUTILITY_PRUNING || \
+  SCL_FUTILITY_PRUNING))
+
+/**
+  Natural logarithms of 0 to 63 multiplied by 32 (0 for 0), for late move
+  reductions.
+*/
+static const uint8_t _SCL_log32[64] =
+{
+    0,   0,  22,  35,  44,  52,  57,  62,  67,  70,  74,  77,  80,  82,  84,
+   87,  89,  91,  92,  94,  96,  97,  99, 100, 102, 103, 104, 105, 107, 108,
+  109, 110, 111, 112, 113, 114, 115, 116, 116, 117, 118, 119, 120, 120, 121,
+  122, 123, 123, 124, 125, 125, 126, 126, 127, 128, 128, 129, 129, 130, 130,
+  131, 132, 132, 133
+};
+
+/**
+  Gets the depth by which to reduce a quiet move searched as the moveNumber-th
+  at given depth, which is about 1/2 + ln(depth) * ln(moveNumber) / 2.25.
+*/
+uint8_t _SCL_lateMoveReduction(int8_t depth, uint16_t moveNumber)
+{
+  return (((uint16_t) _SCL_log32[depth < 63 ? depth : 63]) *
+    _SCL_log32[moveNumber < 63 ? moveNumber : 63] + 1152) / 2304;
+}
+
+/**
+  Lets the player to move pass the turn to the opponent, which is used by null
+  move pruning. Undo with _SCL_positionUndoNullMove. The move counter is reset
+  so that repetitions aren't searched for across the null move.
+*/
+SCL_MoveUndo _SCL_positionMakeNullMove(SCL_Position *position)
+{
+  char *board = position->board;
+  SCL_MoveUndo undo;
+
+  undo.key = SCL_boardKey(board);
+  undo.enPassantCastle = board[SCL_BOARD_ENPASSANT_CASTLE_BYTE];
+  undo.moveCount = board[SCL_BOARD_MOVE_COUNT_BYTE];
+
+  uint64_t key = undo.key ^ _SCL_boardStateKey(board);
+
+  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] |= 0x0f;
+  board[SCL_BOARD_MOVE_COUNT_BYTE] = 0;
+  board[SCL_BOARD_PLY_BYTE]++;
+
+  _SCL_boardSetKey(board,key ^ _SCL_boardStateKey(board));
+
+  return undo;
+}
+
+void _SCL_positionUndoNullMove(SCL_Position *position, SCL_MoveUndo undo)
+{
+  char *board = position->board;
+
+  board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] = undo.enPassantCastle;
+  board[SCL_BOARD_MOVE_COUNT_BYTE] = undo.moveCount;
+  board[SCL_BOARD_PLY_BYTE]--;
+
+  _SCL_boardSetKey(board,undo.key);
+}
+
+#define _SCL_PICK_HASH             0
+#define _SCL_PICK_CAPTURES_PREPARE 1
+#define _SCL_PICK_CAPTURES         2
+#define _SCL_PICK_SPECIAL          3
+#define _SCL_PICK_QUIETS_PREPARE   4
+#define _SCL_PICK_QUIETS           5
+#define _SCL_PICK_REST             6
+
+/**
+  Staged move picker of the main search. It returns the hash move, then
+  captures in MVV-LVA order, then killer moves and the countermove and then
+  the other quiet moves by history score. Each stage is only prepared once the
+  previous one runs out, so after an early cutoff the later ones cost nothing.
+*/
+typedef struct
+{
+  SCL_MoveList moves;
+  int16_t order[SCL_MOVE_LIST_MAX_LENGTH];
+  SCL_Move special[4];            ///< hash move, two killers, countermove
+  uint16_t next;                  ///< moves before this were already returned
+  uint16_t stageEnd;
+  uint8_t stage;
+  uint8_t specialIndex;
+} _SCL_MovePicker;
+
+void _SCL_movePickerInit(_SCL_MovePicker *picker,
+  const SCL_Position *position, const SCL_SearchContext *context,
+  SCL_Move hashMove, uint8_t ply)
+{
+  SCL_positionGetMoves(position,&picker->moves);
+
+  picker->next = 0;
+  picker->stage = _SCL_PICK_HASH;
+  picker->special[0] = hashMove;
+  picker->special[1] = context->killers[ply][0];
+  picker->special[2] = context->killers[ply][1];
+  picker->special[3] = SCL_MOVE_NONE;
+
+  if (ply != 0 && context->moves[ply - 1] != SCL_MOVE_NONE)
+  {
+    uint8_t to = SCL_moveTo(context->moves[ply - 1]);
+    uint8_t piece = _SCL_zobristPieceIndex[(uint8_t) position->board[to]];
+
+    if (piece < 12) // may be empty after 960 castling
+      picker->special[3] = context->counterMoves[piece][to];
+  }
+}
+
+/**
+  If given move hasn't been returned yet, moves it to be returned next and
+  returns 1, otherwise returns 0.
+*/
+uint8_t _SCL_movePickerTake(_SCL_MovePicker *picker, SCL_Move move)
+{
+  if (move == SCL_MOVE_NONE)
+    return 0;
+
+  for (uint16_t i = picker->next; i < picker->moves.count; ++i)
+    if (picker->moves.moves[i] == move)
+    {
+      picker->moves.moves[i] = picker->moves.moves[picker->next];
+      picker->moves.moves[picker->next] = move;
+      return 1;
+    }
+
+  return 0;
+}
+
+/**
+  Returns the next move to search or SCL_MOVE_NONE if there are no more.
+*/
+SCL_Move _SCL_movePickerNext(_SCL_MovePicker *picker, const SCL_Board board,
+  const SCL_SearchContext *context)
+{
+  SCL_MoveList *moves = &picker->moves;
+
+  while (picker->next < moves->count)
+    switch (picker->stage)
+    {
+      case _SCL_PICK_HASH:
+        picker->stage =
+          SCL_ORDER_MOVES ? _SCL_PICK_CAPTURES_PREPARE : _SCL_PICK_REST;
+
+        if (_SCL_movePickerTake(picker,picker->special[0]))
+          return moves->moves[picker->next++];
+
+        break;
+
+      case _SCL_PICK_CAPTURES_PREPARE:
+        // put captures (and promotions) at the start of the remaining moves
+
+        picker->stageEnd = picker->next;
+
+        for (uint16_t i = picker->next; i < moves->count; ++i)
+        {
+          SCL_Move m = moves->moves[i];
+          int16_t gain = _SCL_moveGain(board,m);
+
+          if (gain != 0)
+          {
+            moves->moves[i] = moves->moves[picker->stageEnd];
+            moves->moves[picker->stageEnd] = m;
+            picker->order[picker->stageEnd] = gain * 4 -
+              SCL_pieceValuePositive(board[SCL_moveFrom(m)]) / 4;
+            picker->stageEnd++;
+          }
+        }
+
+        picker->stage = _SCL_PICK_CAPTURES;
+        break;
+
+      case _SCL_PICK_CAPTURES:
+        if (picker->next < picker->stageEnd)
+          return _SCL_pickMove(moves,picker->order,picker->next++,
+            picker->stageEnd);
+
+        picker->stage = SCL_QUIET_MOVE_ORDERING ?
+          _SCL_PICK_SPECIAL : _SCL_PICK_REST;
+        picker->specialIndex = 1;
+        break;
+
+      case _SCL_PICK_SPECIAL:
+        // captures were all returned, so these are only taken if quiet
+
+        while (picker->specialIndex < 4)
+          if (_SCL_movePickerTake(picker,
+            picker->special[picker->specialIndex++]))
+            return moves->moves[picker->next++];
+
+        picker->stage = _SCL_PICK_QUIETS_PREPARE;
+        break;
+
+      case _SCL_PICK_QUIETS_PREPARE:
+        for (uint16_t i = picker->next; i < moves->count; ++i)
+        {
+          SCL_Move m = moves->moves[i];
+
+          picker->order[i] = context->history[
+            _SCL_zobristPieceIndex[(uint8_t) board[SCL_moveFrom(m)]]][
+            SCL_moveTo(m)];
+        }
+
+        picker->stage = _SCL_PICK_QUIETS;
+        break;
+
+      case _SCL_PICK_QUIETS:
+        return _SCL_pickMove(moves,picker->order,picker->next++,moves->count);
+        break;
+
+      default: // _SCL_PICK_REST
+        return moves->moves[picker->next++];
+        break;
+    }
+
+  return SCL_MOVE_NONE;
+}
+
+/**
+  Mate scores in search are relative to the root (mate in fewer ply is
+  better), in the transposition table they are relative to the stored
+  position, these convert between the two.
+*/
+int16_t _SCL_scoreToTable(int16_t score, uint8_t ply)
+{
+  return score > SCL_EVALUATION_MAX_SCORE - SCL_SEARCH_MAX_PLY ? score + ply :
+    (score < SCL_SEARCH_MAX_PLY - SCL_EVALUATION_MAX_SCORE ?
+    score - ply : score);
+}
+
+int16_t _SCL_scoreFromTable(int16_t score, uint8_t ply)
+{
+  return score > SCL_EVALUATION_MAX_SCORE - SCL_SEARCH_MAX_PLY ? score - ply :
+    (score < SCL_SEARCH_MAX_PLY - SCL_EVALUATION_MAX_SCORE ?
+    score + ply : score);
+}
+
+/**
+  Main search function: negamax alpha-beta search with principal variation
+  search, i.e. after the first move the others are only searched with a null
+  window to prove they are worse, and only searched again with the full window
+  if they turn out better. The score is from the point of view of the player
+  to move and ply is the distance from the root.
+*/
+int16_t _SCL_search(SCL_SearchContext *context, SCL_Position *position,
+  int16_t alpha, int16_t beta, int8_t depth, uint8_t ply)
+{
+  if (_SCL_searchNode(context))
+    return 0;
+
+  const char *board = position->board;
+  uint64_t boardKey = SCL_boardKey(board);
+  uint8_t whitesTurn = SCL_positionWhitesTurn(position);
+  uint8_t halfmoves = (uint8_t) board[SCL_BOARD_MOVE_COUNT_BYTE];
+
+  if (ply != 0)
+  {
+    if (halfmoves >= 100)
+      return 0; // 50 move rule
+
+    for (int16_t i = ((int16_t) ply) - 4; i >= 0 && i >= ply - halfmoves;
+      i -= 2)
+      if (context->keys[i] == boardKey)
+        return 0; // repetition, draw
+  }
+
+  if (ply >= SCL_SEARCH_MAX_PLY - 1)
+    return _SCL_searchEvaluate(context,position,alpha,beta);
+
+#if SCL_ALPHA_BETA && SCL_MATE_DISTANCE_PRUNING
+  if (ply != 0)
+  {
+    // being mated here is the worst, mating in the next ply the best result
+
+    if (alpha < ply - SCL_EVALUATION_MAX_SCORE)
+      alpha = ply - SCL_EVALUATION_MAX_SCORE;
+
+    if (beta > SCL_EVALUATION_MAX_SCORE - ply - 1)
+      beta = SCL_EVALUATION_MAX_SCORE - ply - 1;
+
+    if (alpha >= beta)
+      return alpha;
+  }
+#endif
+
+  context->keys[ply] = boardKey;
+
+  int16_t alphaOriginal = alpha;
+  uint64_t key = 0;
+  SCL_Move hashMove = SCL_MOVE_NONE;
+
+  if (SCL_transpositionTable.slots != 0)
+  {
+    SCL_TranspositionEntry entry;
+
+    key = _SCL_searchKey(board,context->depthHardLimit);
+
+    if (SCL_transpositionTableProbe(&SCL_transpositionTable,key,&entry))
+    {
+      int16_t score = _SCL_scoreFromTable(entry.score,ply);
+      uint8_t bound = entry.info & 0x03;
+
+      if (entry.depth >= depth && (bound == SCL_BOUND_EXACT ||
+        (bound == SCL_BOUND_LOWER && score >= beta) ||
+        (bound == SCL_BOUND_UPPER && score <= alpha)))
+        return score;
+
+      hashMove = entry.move;
+    }
+  }
+
+  int16_t best = -1 * _SCL_SCORE_INFINITY;
+  SCL_Move bestMove = SCL_MOVE_NONE;
+
+  if (depth <= 0)
+    best = _SCL_quiescence(context,position,alpha,beta,0,ply);
+  else
+  {
+    _SCL_MovePicker picker;
+#if SCL_ALPHA_BETA && SCL_QUIET_MOVE_ORDERING
+    SCL_Move quiets[64]; // searched quiet moves, to lower their history
+    uint8_t quietCount = 0;
+#endif
+    uint16_t searched = 0;
+    uint8_t check = SCL_positionCheck(position,whitesTurn);
+    uint8_t pvNode = beta - alpha > 1;
+    SCL_Move m;
+
+    SCL_UNUSED(pvNode); // with all selective search options off
+
+#if _SCL_SEARCH_STATIC_EVALUATION
+    int16_t staticEval = check ? 0 :
+      _SCL_searchEvaluate(context,position,alpha,beta);
+#endif
+
+#if SCL_ALPHA_BETA && SCL_REVERSE_FUTILITY_PRUNING
+    if (!pvNode && !check && depth <= _SCL_REVERSE_FUTILITY_MAX_DEPTH &&
+      beta < SCL_EVALUATION_MAX_SCORE - SCL_SEARCH_MAX_PLY &&
+      staticEval - depth * _SCL_REVERSE_FUTILITY_MARGIN >= beta)
+      return staticEval; // the opponent is unlikely to make up for this
+#endif
+
+#if SCL_ALPHA_BETA && SCL_NULL_MOVE_PRUNING
+    if (!pvNode && !check && depth >= _SCL_NULL_MOVE_MIN_DEPTH &&
+      staticEval >= beta &&
+      beta < SCL_EVALUATION_MAX_SCORE - SCL_SEARCH_MAX_PLY &&
+      ply != 0 && context->moves[ply - 1] != SCL_MOVE_NONE && // no 2 in a row
+      (position->colors[!whitesTurn] & ~(position->pieces[SCL_PIECE_PAWN] |
+      position->pieces[SCL_PIECE_KING])))
+    {
+      context->moves[ply] = SCL_MOVE_NONE;
+
+      SCL_MoveUndo undo = _SCL_positionMakeNullMove(position);
+
+      int16_t value = -1 * _SCL_search(context,position,-1 * beta,
+        -1 * beta + 1,depth - 3 - depth / 4,ply + 1);
+
+      _SCL_positionUndoNullMove(position,undo);
+
+      if (context->abort)
+        return 0;
+
+      if (value >= beta) // even passing doesn't help the opponent
+        return value > SCL_EVALUATION_MAX_SCORE - SCL_SEARCH_MAX_PLY ?
+          beta : value; // mate found this way isn't proven
+    }
+#endif
+
+    _SCL_movePickerInit(&picker,position,context,hashMove,ply);
+
+    if (picker.moves.count == 0) // mate or stalemate
+      return check ? (ply - SCL_EVALUATION_MAX_SCORE) : 0;
+
+    while ((m = _SCL_movePickerNext(&picker,board,context)) != SCL_MOVE_NONE)
+    {
+#if SCL_ALPHA_BETA && (SCL_QUIET_MOVE_ORDERING || SCL_FUTILITY_PRUNING || \
+  SCL_LATE_MOVE_REDUCTIONS)
+      uint8_t quiet = _SCL_moveGain(board,m) == 0;
+#endif
+      int16_t value;
+
+      context->moves[ply] = m;
+
+      SCL_PositionUndo undo = SCL_positionMakeMove(position,SCL_moveFrom(m),
+        SCL_moveTo(m),SCL_movePromotion(m));
+
+#if SCL_ALPHA_BETA && (SCL_FUTILITY_PRUNING || SCL_LATE_MOVE_REDUCTIONS)
+      uint8_t givesCheck = quiet && SCL_positionCheck(position,!whitesTurn);
+#endif
+
+#if SCL_ALPHA_BETA && SCL_FUTILITY_PRUNING
+      if (quiet && searched != 0 && !check && !givesCheck &&
+        depth <= _SCL_FUTILITY_MAX_DEPTH &&
+        staticEval + depth * _SCL_FUTILITY_MARGIN <= alpha)
+      {
+        SCL_positionUndoMove(position,undo); // unlikely to raise alpha
+        continue;
+      }
+#endif
+
+#if SCL_ALPHA_BETA
+      if (searched == 0)
+        value = -1 * _SCL_search(context,position,-1 * beta,-1 * alpha,
+          depth - 1,ply + 1);
+      else
+      {
+        int8_t reduction = 0;
+
+  #if SCL_LATE_MOVE_REDUCTIONS
+        if (quiet && !check && !givesCheck && depth >= _SCL_LMR_MIN_DEPTH &&
+          searched >= _SCL_LMR_MIN_MOVES && picker.stage >= _SCL_PICK_QUIETS)
+        {
+          // not killers or countermove, those are quiet moves likely good
+
+          reduction = _SCL_lateMoveReduction(depth,searched + 1) - pvNode;
+
+          if (reduction > depth - 2)
+            reduction = depth - 2;
+        }
+  #endif
+
+        value = -1 * _SCL_search(context,position,-1 * alpha - 1,-1 * alpha,
+          depth - 1 - reduction,ply + 1);
+
+        if (reduction > 0 && value > alpha) // verify without reduction
+          value = -1 * _SCL_search(context,position,-1 * alpha - 1,
+            -1 * alpha,depth - 1,ply + 1);
+
+        if (value > alpha && value < beta) // better than expected
+          value = -1 * _SCL_search(context,position,-1 * beta,-1 * alpha,
+            depth - 1,ply + 1);
+      }
+#else
+      value = -1 * _SCL_search(context,position,-1 * _SCL_SCORE_INFINITY,
+        _SCL_SCORE_INFINITY,depth - 1,ply + 1);
+#endif
+
+      SCL_positionUndoMove(position,undo);
+
+      if (context->abort)
+        return 0; // don't store the unfinished result
+
+      searched++;
+
+      if (value > best)
+      {
+        best = value;
+        bestMove = m;
+
+        if (value > alpha)
+        {
+          alpha = value;
+
+#if SCL_ALPHA_BETA
+          if (value >= beta)
+          {
+            context->cutoffs++;
+
+            if (searched == 1)
+              context->firstMoveCutoffs++;
+
+  #if SCL_QUIET_MOVE_ORDERING
+            if (quiet)
+            {
+              int16_t bonus = depth < 20 ? depth * depth : 400;
+
+              if (context->killers[ply][0] != m)
+              {
+                context->killers[ply][1] = context->killers[ply][0];
+                context->killers[ply][0] = m;
+              }
+
+              if (ply != 0 && context->moves[ply - 1] != SCL_MOVE_NONE)
+              {
+                uint8_t to = SCL_moveTo(context->moves[ply - 1]);
+                uint8_t piece = _SCL_zobristPieceIndex[(uint8_t) board[to]];
+
+                if (piece < 12)
+                  context->counterMoves[piece][to] = m;
+              }
+
+              _SCL_historyUpdate(&context->history[
+                _SCL_zobristPieceIndex[(uint8_t) board[SCL_moveFrom(m)]]][
+                SCL_moveTo(m)],bonus);
+
+              for (uint8_t i = 0; i < quietCount; ++i)
+                _SCL_historyUpdate(&context->history[_SCL_zobristPieceIndex[
+                  (uint8_t) board[SCL_moveFrom(quiets[i])]]][
+                  SCL_moveTo(quiets[i])],-1 * bonus);
+            }
+  #endif
+
+            break;
+          }
+#endif
+        }
+      }
+
+#if SCL_ALPHA_BETA && SCL_QUIET_MOVE_ORDERING
+      if (quiet && quietCount < 64)
+      {
+        quiets[quietCount] = m;
+        quietCount++;
+      }
+#endif
+    }
+  }
+
+  if (context->abort)
+    return 0;
+
+  if (key != 0 && !context->readOnlyTable)
+    SCL_transpositionTableStore(&SCL_transpositionTable,key,depth,
+      best >= beta ? SCL_BOUND_LOWER :
+      (best > alphaOriginal ? SCL_BOUND_EXACT : SCL_BOUND_UPPER),
+      _SCL_scoreToTable(best,ply),
+      bestMove != SCL_MOVE_NONE ? bestMove : hashMove);
+
+  return best;
+}
+
+int16_t SCL_boardEvaluateDynamic(SCL_Board board, uint8_t baseDepth,
+  uint8_t extensionExtraDepth, SCL_StaticEvaluationFunction evalFunction)
+{
+  SCL_Position position;
+  SCL_SearchContext context;
+
+  _SCL_transpositionTableCheckFunction(evalFunction);
+  _SCL_searchContextInit(&context,evalFunction,extensionExtraDepth);
+
+  SCL_positionFromBoard(&position,board);
+
+  int16_t result = _SCL_search(&context,&position,-1 * _SCL_SCORE_INFINITY,
+    _SCL_SCORE_INFINITY,baseDepth,0) * (SCL_boardWhitesTurn(board) ? 1 : -1);
+
+#if SCL_COUNT_EVALUATED_POSITIONS
+  SCL_positionsEvaluated += context.nodes;
+#endif
+
+  return result;
+}
+
+#else // old simple search, only uses one bound for alpha-beta pruning
+
+/**
+  Inner recursive function for SCL_boardEvaluateDynamic.
+*/
+int16_t _SCL_boardEvaluateDynamic(SCL_SearchContext *context,
+  SCL_Board board, int8_t depth, int16_t alphaBeta)
+{
+  if (_SCL_searchNode(context))
+    return 0; // result will be thrown away
+
+  uint8_t whitesTurn = SCL_boardWhitesTurn(board);
+  int8_t valueMultiply = whitesTurn ? 1 : -1;
+  int16_t bestMoveValue = -1 * SCL_EVALUATION_MAX_SCORE;
+  uint64_t key = 0;
+  SCL_Move hashMove = SCL_MOVE_NONE;
+  SCL_Move bestMove = SCL_MOVE_NONE;
+  uint8_t bound = SCL_BOUND_NONE;
+  int8_t searchDepth = depth;
+
+  if (SCL_transpositionTable.slots != 0)
+  {
+    /* All nodes use the table, even leaves, for which it saves the quite
+       expensive static evaluation. */
+
+    SCL_TranspositionEntry entry;
+
+    key = _SCL_searchKey(board,context->depthHardLimit);
+
+    if (SCL_transpositionTableProbe(&SCL_transpositionTable,key,&entry))
+    {
+      if (entry.depth >= depth &&
+        ((entry.info & 0x03) == SCL_BOUND_EXACT ||
+        ((entry.info & 0x03) == SCL_BOUND_LOWER &&
+        entry.score > alphaBeta * valueMultiply)))
+        return entry.score * valueMultiply;
+
+      hashMove = entry.move;
+    }
+  }
+
+  uint8_t positionType =
+    depth > 0 ? SCL_boardGetPosition(board) : SCL_POSITION_NORMAL;
+
+#if SCL_DEBUG_AI
+  char moveStr[8];
+  uint8_t debugFirst = 1;
+#endif
+
+  if (depth <= 0)
+  {
+#if SCL_ALPHA_BETA
+    // the cutoff below is value > alphaBeta, hence + 1
+    int16_t beta = alphaBeta * valueMultiply + 1;
+#else
+    int16_t beta = SCL_EVALUATION_MAX_SCORE + 1;
+#endif
+
+    SCL_Position position;
+
+    SCL_positionFromBoard(&position,board);
+
+    bestMoveValue = _SCL_quiescence(context,&position,
+      -1 * SCL_EVALUATION_MAX_SCORE - 1,beta,0,0);
+
+    bound = bestMoveValue >= beta ? SCL_BOUND_LOWER : SCL_BOUND_EXACT;
+  }
+  else if (
+    positionType == SCL_POSITION_NORMAL || positionType == SCL_POSITION_CHECK)
+  {
+#if SCL_DEBUG_AI
+    putchar('(');
+#endif
+
+    alphaBeta *= valueMultiply;
+    uint8_t end = 0;
+    SCL_MoveList moves;
+
+    SCL_boardGetMoveList(board,&moves);
+
+    if (hashMove != SCL_MOVE_NONE)
+    {
+      // put the hash move first, keeping the order of others
+
+      uint16_t i = 0;
+
+      while (i < moves.count && moves.moves[i] != hashMove)
+        i++;
+
+      if (i < moves.count)
+        for (; i > 0; --i)
+          moves.moves[i] = moves.moves[i - 1];
+      else
+        hashMove = SCL_MOVE_NONE; // not legal here, key collision
+
+      moves.moves[0] = hashMove;
+    }
+
+    depth--;
+
+#if SCL_ORDER_MOVES
+    for (int j = 0; j < 2; ++j)
+    {
+      // two iteration: first check "usually better moves", then the rest
+#endif
+
+      for (uint16_t i = 0; i < moves.count; ++i)
+      {
+        uint8_t from = SCL_moveFrom(moves.moves[i]);
+        uint8_t to = SCL_moveTo(moves.moves[i]);
+        char promotion = SCL_movePromotion(moves.moves[i]);
+
+#if SCL_ORDER_MOVES
+        if (i == 0 && hashMove != SCL_MOVE_NONE)
+        {
+          if (j != 0)
+            continue; // hash move goes first
+        }
+        else if ((board[to] != '.' && // taking with less valuable piece?
+            (SCL_pieceValuePositive(board[from]) + SCL_VALUE_PAWN / 2 <=
+            SCL_pieceValuePositive(board[to]))) != j)
+          continue;
+#endif
+
+        SCL_MoveUndo undo = SCL_boardMakeMove(board,from,to,promotion);
+
+#if SCL_DEBUG_AI
+        if (debugFirst)
+          debugFirst = 0;
+        else
+          putchar(',');
+
+        printf("%s ",SCL_moveToString(board,from,to,promotion,moveStr));
+#endif
+
+        int16_t value = _SCL_boardEvaluateDynamic(
+          context,
+          board,
+          depth, // this is depth - 1, we decremented it
+#if SCL_ALPHA_BETA
+          valueMultiply * bestMoveValue
+#else
+          0
+#endif
+          ) * valueMultiply;
+
+        SCL_boardUndoMove(board,undo);
+
+        if (context->abort)
+          return 0; // don't store the unfinished result
+
+        if (value > bestMoveValue)
+        {
+          bestMoveValue = value;
+          bestMove = moves.moves[i];
+
+#if SCL_ALPHA_BETA
+          // alpha-beta pruning:
+
+          if (value > alphaBeta) // no, >= can't be here
+          {
+            end = 1;
+            break;
+          }
+#endif
+        }
+      } // for each move
+
+#if SCL_ORDER_MOVES
+      if (end)
+        break;
+    }
+#endif
+
+    bound = end ? SCL_BOUND_LOWER : SCL_BOUND_EXACT;
+
+#if SCL_DEBUG_AI
+  putchar(')');
+#endif
+  }
+  else // don't dive recursively, evaluate statically
+  {
+    bestMoveValue = valueMultiply *
+  #ifndef SCL_EVALUATION_FUNCTION
+      _SCL_evaluationCacheEvaluate(context->evalFunction,board);
+  #else
+      _SCL_evaluationCacheEvaluate(SCL_EVALUATION_FUNCTION,board);
+  #endif
+
+    /* For stalemate return the opposite value of the board, i.e. if the
+       position is good for white, then stalemate is good for black and vice
+       versa. */
+    if (positionType == SCL_POSITION_STALEMATE)
+      bestMoveValue *= -1;
+
+    bound = SCL_BOUND_EXACT;
+  }
+
+  /* Here we either improve (if the move worsens the situation) or devalve (if
+     it improves the situation) the result: this needs to be done so that good
+     moves far away are seen as worse compared to equally good moves achieved
+     in fewer moves. Without this an AI in winning situation may just repeat
+     random moves and draw by repetition even if it has mate in 1 (it sees all
+     moves as leading to mate). */
+  bestMoveValue +=
+    bestMoveValue > context->rootEvaluation * valueMultiply ? -1 : 1;
+
+  if (key != 0 && bound != SCL_BOUND_NONE)
+    SCL_transpositionTableStore(&SCL_transpositionTable,key,searchDepth,bound,
+      bestMoveValue,bestMove);
+
+#if SCL_DEBUG_AI
+  printf("%d",bestMoveValue * valueMultiply);
+#endif
+
+  return bestMoveValue * valueMultiply;
+}
+
+/**
+  Searches given board with given context, the score is from the point of view
+  of white.
+*/
+int16_t _SCL_evaluateDynamic(SCL_SearchContext *context, SCL_Board board,
+  uint8_t baseDepth)
+{
+  context->rootEvaluation = context->evalFunction(board);
+
+  return _SCL_boardEvaluateDynamic(
+    context,
+    board,
+    baseDepth,
+    SCL_boardWhitesTurn(board) ?
+      SCL_EVALUATION_MAX_SCORE : (-1 * SCL_EVALUATION_MAX_SCORE));
+}
+
+int16_t SCL_boardEvaluateDynamic(SCL_Board board, uint8_t baseDepth,
+  uint8_t extensionExtraDepth, SCL_StaticEvaluationFunction evalFunction)
+{
+  SCL_SearchContext context;
+
+  _SCL_transpositionTableCheckFunction(evalFunction);
+  _SCL_searchContextInit(&context,evalFunction,extensionExtraDepth);
+
+  int16_t result = _SCL_evaluateDynamic(&context,board,baseDepth);
+
+#if SCL_COUNT_EVALUATED_POSITIONS
+  SCL_positionsEvaluated += context.nodes;
+#endif
+
+  return result;
+}
+
+#endif // SCL_SEARCH_NEGAMAX
+
+void SCL_boardRandomMove(SCL_Board board, SCL_RandomFunction randFunc,
+  uint8_t *squareFrom, uint8_t *squareTo, char *resultProm)
+{
+  SCL_MoveList moves;
+  SCL_Move move = SCL_MOVE_NONE;
+
+  SCL_boardGetMoveList(board,&moves);
+
+  if (moves.count != 0)
+    move = moves.moves[
+      (((uint16_t) randFunc()) << 8 | randFunc()) % moves.count];
+
+  *squareFrom = SCL_moveFrom(move);
+  *squareTo = SCL_moveTo(move);
+  *resultProm = SCL_movePromotion(move);
+}
+
+void SCL_printBoardSimple(
+  SCL_Board board,
+  SCL_PutCharFunction putCharFunc,
+  uint8_t selectSquare,
+  uint8_t format)
+{
+  SCL_SquareSet s;
+
+  SCL_squareSetClear(s);
+
+  SCL_printBoard(board,putCharFunc,s,selectSquare,format,1,1,0);
+}
+
+uint8_t _SCL_threadCount = 1;
+
+uint8_t SCL_setThreads(uint8_t count)
+{
+#if SCL_THREADS
+  _SCL_threadCount = count == 0 ? 1 :
+    (count > SCL_MAX_THREADS ? SCL_MAX_THREADS : count);
+#else
+  SCL_UNUSED(count);
+#endif
+
+  return _SCL_threadCount;
+}
+
+#if SCL_THREADS
+/**
+  Starts a thread running given function (declared with _SCL_THREAD_FUNCTION)
+  with given data, returns 1 on success.
+*/
+#ifdef _WIN32
+uint8_t _SCL_threadStart(_SCL_Thread *thread,
+  DWORD (WINAPI *function)(LPVOID), void *data)
+{
+  *thread = CreateThread(0,0,function,data,0,0);
+  return *thread != 0;
+}
+#else
+uint8_t _SCL_threadStart(_SCL_Thread *thread, void *(*function)(void *),
+  void *data)
+{
+  return pthread_create(thread,0,function,data) == 0;
+}
+#endif
+
+void _SCL_threadJoin(_SCL_Thread thread)
+{
+#ifdef _WIN32
+  WaitForSingleObject(thread,INFINITE);
+  CloseHandle(thread);
+#else
+  pthread_join(thread,0);
+#endif
+}
+
+void _SCL_lockInit(_SCL_Lock *lock)
+{
+#ifdef _WIN32
+  InitializeCriticalSection(&lock->lock);
+#else
+  pthread_mutex_init(&lock->lock,0);
+#endif
+}
+
+void _SCL_lockFree(_SCL_Lock *lock)
+{
+#ifdef _WIN32
+  DeleteCriticalSection(&lock->lock);
+#else
+  pthread_mutex_destroy(&lock->lock);
+#endif
+}
+
+void _SCL_lock(_SCL_Lock *lock)
+{
+#ifdef _WIN32
+  EnterCriticalSection(&lock->lock);
+#else
+  pthread_mutex_lock(&lock->lock);
+#endif
+}
+
+void _SCL_unlock(_SCL_Lock *lock)
+{
+#ifdef _WIN32
+  LeaveCriticalSection(&lock->lock);
+#else
+  pthread_mutex_unlock(&lock->lock);
+#endif
+}
+#endif // SCL_THREADS
+
+#if SCL_SEARCH_NEGAMAX
+/**
+  Searches the root moves with given window for _SCL_getAIMove, returns the
+  best score (from the point of view of the player to move) and move.
+*/
+int16_t _SCL_searchRoot(SCL_SearchContext *context,
+  SCL_Position *position, SCL_MoveList *moves,
+  int16_t *order, int16_t alpha, int16_t beta, uint8_t depth,
+  SCL_RandomFunction randFunc, uint8_t randomness, uint8_t repetitionMoveFrom,
+  uint8_t repetitionMoveTo, SCL_Move *bestMove)
+{
+#if SCL_DEBUG_AI
+  char moveStr[8];
+  putchar('(');
+#endif
+
+  int16_t bestScore = -1 * _SCL_SCORE_INFINITY;
+
+  *bestMove = SCL_MOVE_NONE;
+
+  for (uint16_t i = 0; i < moves->count; ++i)
+  {
+    SCL_Move m = _SCL_pickMove(moves,order,i,moves->count);
+    uint8_t from = SCL_moveFrom(m);
+    uint8_t to = SCL_moveTo(m);
+    int16_t score = 0;
+
+#if SCL_DEBUG_AI
+    if (i != 0)
+      putchar(',');
+
+    printf("%s ",SCL_moveToString(position->board,from,to,
+      SCL_movePromotion(m),moveStr));
+#endif
 
-    case SCL_POSITION_CHECK:
-      total += SCL_boardWhitesTurn(board) ? -1 * CHECK_BONUS : CHECK_BONUS;
-      // fall through
-    case SCL_POSITION_NORMAL:
-    default:
+    if (from != repetitionMoveFrom || to != repetitionMoveTo)
     {
-      SCL_SquareSet moves;
-
-      const char *p = board;
+      context->moves[0] = m;
 
-      int16_t positiveMaterial = 0;
-      uint8_t endgame = 0;
+      SCL_PositionUndo undo = SCL_positionMakeMove(position,from,to,
+        SCL_movePromotion(m));
 
-      // first count material to see if this is endgame or not
-      for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i, ++p)
+      if (i == 0 || (randFunc != 0 && randomness > 1))
+        score = -1 * _SCL_search(context,position,-1 * beta,-1 * alpha,
+          depth - 1,1);
+      else
       {
-        char s = *p;
+        /* With randomness moves as good as the best one are also needed, so
+           the null window is below the best score. */
+        int16_t a = (randFunc == 0 || bestScore <= alpha) ?
+          alpha : (bestScore - 1);
 
-        if (s != '.')
-        {
-          positiveMaterial += SCL_pieceValuePositive(s);
-          total += SCL_pieceValue(s);
-        }
+        score = -1 * _SCL_search(context,position,-1 * a - 1,-1 * a,
+          depth - 1,1);
+
+        if (score > a && score < beta)
+          score = -1 * _SCL_search(context,position,-1 * beta,-1 * a,
+            depth - 1,1);
       }
 
-      endgame = positiveMaterial <= SCL_ENDGAME_MATERIAL_LIMIT;
+      SCL_positionUndoMove(position,undo);
 
-      p = board;
+      if (context->abort)
+        return 0;
+    }
 
-      for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i, ++p)
-      {
-        char s = *p;
+#if SCL_DEBUG_AI
+    printf("%d",score);
+#endif
 
-        if (s != '.')
-        {
-          uint8_t white = SCL_pieceIsWhite(s);
+    if (randFunc != 0 &&
+      randomness > 1 &&
+      score < 16000 &&
+      score > -16000)
+    {
+      /*^ We limit randomizing by about half the max score for two reasons:
+        to prevent over/under flows and secondly we don't want to alter
+        the highest values for checkmate -- these are modified by tiny
+        values depending on their depth so as to prevent endless loops in
+        which most moves are winning, biasing such values would completely
+        kill that algorithm */
+
+      int16_t bias = randFunc();
+      bias = (bias - 128) / 2;
+      bias *= randomness - 1;
+      score += bias;
+    }
 
-          switch (s)
-          {
-            case 'k': // king safety
-              if (endgame)
-                total -= _SCL_rateKingEndgamePosition(i);
-              else if (i >= 56)
-              {
-                total -= KING_BACK_BONUS;
+    if (score > bestScore ||
+      (score == bestScore && randFunc != 0 && randFunc() < 160))
+      // ^ not uniform distr. but simple
+    {
+      bestScore = score;
+      *bestMove = m;
 
-                if (i != 59)
-                {
-                  total -= KING_NOT_CENTER_BONUS;
+      if (score > alpha)
+        alpha = score;
 
-                  if (i >= 62 || i <= 58)
-                    total -= KING_CASTLED_BONUS;
-                }
-              }
-            break;
+      if (score >= beta)
+        break; // aspiration window failed high
+    }
+  }
 
-            case 'K':
-              if (endgame)
-                total += _SCL_rateKingEndgamePosition(i);
-              else if (i <= 7)
-              {
-                total += KING_BACK_BONUS;
+#if SCL_DEBUG_AI
+  putchar(')');
+#endif
 
-                if (i != 3)
-                {
-                  total += KING_NOT_CENTER_BONUS;
+  return bestScore;
+}
 
-                  if (i <= 2 || i >= 6)
-                    total += KING_CASTLED_BONUS;
-                }
-              }
-            break;
+#if SCL_THREADS
+/**
+  Root moves shared by the threads of root parallel search.
+*/
+typedef struct
+{
+  const SCL_SearchContext *main;  ///< context of the main thread
+  SCL_Position position;
+  const SCL_Move *moves;
+  int16_t *scores;
+  uint16_t moveCount;
+  uint16_t next;                  ///< first move not taken yet, under lock
+  int16_t bound;
+  uint8_t depth;
+  uint8_t repetitionMoveFrom;
+  uint8_t repetitionMoveTo;
+  _SCL_Lock lock;
+} _SCL_RootWork;
 
-            case 'P': // pawns
-            case 'p':
-            {
-              int8_t rank = i / 8;
+typedef struct
+{
+  _SCL_RootWork *work;
+  SCL_SearchContext context;
+  uint64_t nodes;                 ///< of all moves, the context is reset
+  uint8_t aborted;
+  _SCL_Thread thread;
+} _SCL_RootWorker;
 
-              if (rank != 0 && rank != 7)
-              {
-                if (s == 'P')
-                {
-                  total += rank;
+/**
+  Takes root moves one by one until there are none left (so that threads that
+  get easier moves take more of them) and searches each with a null window at
+  the bound. Each move gets a new context and the table is only read, so that
+  the score only depends on the move and not on which thread searches it or
+  when.
+*/
+_SCL_THREAD_FUNCTION(_SCL_rootWorker)
+{
+  _SCL_RootWorker *worker = (_SCL_RootWorker *) data;
+  _SCL_RootWork *work = worker->work;
+  SCL_Position position = work->position;
 
-                  char *tmp = board + i + 8;
+  worker->nodes = 0;
+  worker->aborted = 0;
 
-                  if (*tmp != 'P')
-                    total += PAWN_NON_DOUBLE_BONUS;
+  while (1)
+  {
+    _SCL_lock(&work->lock);
 
-                  if (i % 8 != 7)
-                  {
-                    tmp++;
+    uint16_t i = work->next;
 
-                    if (*tmp == 'P')
-                      total += PAWN_PAIR_BONUS;
+    if (i < work->moveCount)
+      work->next++;
 
-                    if (*(tmp - 16) == 'P')
-                      total += PAWN_PAIR_BONUS;
-                  }
-                }
-                else
-                {
-                  total -= 7 - rank;
+    _SCL_unlock(&work->lock);
 
-                  char *tmp = board + i - 8;
+    if (i >= work->moveCount)
+      break;
 
-                  if (*tmp != 'p')
-                    total -= PAWN_NON_DOUBLE_BONUS;
+    SCL_Move m = work->moves[i];
+    SCL_SearchContext *context = &worker->context;
+    uint8_t from = SCL_moveFrom(m);
+    uint8_t to = SCL_moveTo(m);
 
-                  if (i % 8 != 7)
-                  {
-                    tmp += 17;
+    if (from == work->repetitionMoveFrom && to == work->repetitionMoveTo)
+    {
+      work->scores[i] = 0;
+      continue;
+    }
 
-                    if (*tmp == 'p')
-                      total -= PAWN_PAIR_BONUS;
+    _SCL_searchContextInit(context,work->main->evalFunction,0);
 
-                    if (*(tmp - 16) == 'p')
-                      total -= PAWN_PAIR_BONUS;
-                  }
-                }
-              }
+    context->depthHardLimit = work->main->depthHardLimit;
+    context->stop = work->main->stop;
+    context->readOnlyTable = 1;
+    context->keys[0] = SCL_boardKey(position.board);
+    context->moves[0] = m;
 
-              break;
-            }
+    SCL_PositionUndo undo = SCL_positionMakeMove(&position,from,to,
+      SCL_movePromotion(m));
 
-            default: break;
-          }
+    work->scores[i] = -1 * _SCL_search(context,&position,-1 * work->bound - 1,
+      -1 * work->bound,work->depth - 1,1);
 
-          if (i >= 27 && i <= 36 && (i >= 35 || i <= 28)) // center control
-            total += white ? CENTER_BONUS : (-1 * CENTER_BONUS);
+    SCL_positionUndoMove(&position,undo);
 
-          // for performance we only take pseudo moves
-          SCL_boardGetPseudoMoves(board,i,0,moves);
+    worker->nodes += context->nodes;
 
-          if (SCL_squareSetSize(moves) >= 4) // mobility
-            total += white ?
-              MOBILITY_BONUS : (-1 * MOBILITY_BONUS);
+    if (context->abort)
+    {
+      worker->aborted = 1;
+      break;
+    }
+  }
 
-          int16_t exchangeBonus = 0;
+  return 0;
+}
 
-          SCL_SQUARE_SET_ITERATE_BEGIN(moves)
+/**
+  Root parallel version of _SCL_searchRoot with a full window and no
+  randomness, used with 2 or more threads. The first move is searched
+  normally, which sets the bound, then all threads search the other moves with
+  a null window at this bound, and finally the ones that turned out better are
+  searched again in order by the calling thread. The bound isn't raised during
+  the parallel part and the other threads don't store to the table, so the
+  result is the same for any number of threads above 1 and in every run. With
+  1 thread _SCL_searchRoot raises the bound with every better move and stores
+  every move's result, which prunes differently, so the result may differ.
+  It is simpler than a full root splitting search: there is no pool of threads
+  stealing work from each other (the threads take moves from one shared index
+  and are started on every call), and the bound stays at the first move's
+  score, so the moves are searched at a lower bound than they could be.
+*/
+int16_t _SCL_searchRootParallel(SCL_SearchContext *context,
+  SCL_Position *position, SCL_MoveList *moves, int16_t *order, uint8_t depth,
+  uint8_t repetitionMoveFrom, uint8_t repetitionMoveTo, SCL_Move *bestMove)
+{
+  _SCL_RootWork work;
+  int16_t scores[SCL_MOVE_LIST_MAX_LENGTH];
+  uint8_t workerCount = context->threads;
 
-            if (board[iteratedSquare] != '.')
-            {
-              total += white ?
-                ATTACK_BONUS : (- 1 * ATTACK_BONUS);
+  if (workerCount > moves->count - 1)
+    workerCount = moves->count - 1;
 
-              if (SCL_boardWhitesTurn(board) == white)
-              {
-                int16_t valueDiff =
-                  SCL_pieceValuePositive(board[iteratedSquare]) -
-                  SCL_pieceValuePositive(s);
+  _SCL_RootWorker *workers = workerCount == 0 ? 0 :
+    (_SCL_RootWorker *) malloc(workerCount * sizeof(_SCL_RootWorker));
 
-                valueDiff /= 4; // only take a fraction to favor taking
+  if (workers == 0) // one move or no memory
+    return _SCL_searchRoot(context,position,moves,order,
+      -1 * _SCL_SCORE_INFINITY,_SCL_SCORE_INFINITY,depth,0,0,
+      repetitionMoveFrom,repetitionMoveTo,bestMove);
 
-                if (valueDiff > exchangeBonus)
-                  exchangeBonus = valueDiff;
-              }
-            }
+  for (uint16_t i = 0; i < moves->count; ++i) // sort now, order must be fixed
+    moves->moves[i] = _SCL_pickMove(moves,order,i,moves->count);
 
-          SCL_SQUARE_SET_ITERATE_END
+  // first move sets the bound:
 
-          if (exchangeBonus != 0)
-            total += white ? exchangeBonus : -1 * exchangeBonus;
-        }
-      } // for each square
+  SCL_MoveList first = *moves;
 
-      return total;
+  first.count = 1;
 
-      break;
+  int16_t bestScore = _SCL_searchRoot(context,position,&first,order,
+    -1 * _SCL_SCORE_INFINITY,_SCL_SCORE_INFINITY,depth,0,0,repetitionMoveFrom,
+    repetitionMoveTo,bestMove);
 
-    } // normal position
-  } // switch
+  if (context->abort)
+  {
+    free(workers);
+    return bestScore;
+  }
 
-  return 0;
-}
+  work.main = context;
+  work.position = *position;
+  work.moves = moves->moves + 1;
+  work.scores = scores;
+  work.moveCount = moves->count - 1;
+  work.next = 0;
+  work.bound = bestScore;
+  work.depth = depth;
+  work.repetitionMoveFrom = repetitionMoveFrom;
+  work.repetitionMoveTo = repetitionMoveTo;
 
-#undef ATTACK_BONUS
-#undef MOBILITY_BONUS
-#undef CENTER_BONUS
-#undef CHECK_BONUS
-#undef KING_CASTLED_BONUS
-#undef KING_BACK_BONUS
-#undef PAWN_NON_DOUBLE_BONUS
-#undef PAWN_PAIR_BONUS
-#undef KING_CENTERNESS
+  _SCL_lockInit(&work.lock);
 
-SCL_StaticEvaluationFunction _SCL_staticEvaluationFunction;
-int16_t _SCL_currentEval;
-int8_t _SCL_depthHardLimit;
+  uint8_t started = 1; // the calling thread is worker 0
 
-/**
-  Inner recursive function for SCL_boardEvaluateDynamic. It is passed a square
-  (or -1) at which last capture happened, to implement capture extension.
-*/
-int16_t _SCL_boardEvaluateDynamic(SCL_Board board, int8_t depth,
-  int16_t alphaBeta, int8_t takenSquare)
-{
-#if SCL_COUNT_EVALUATED_POSITIONS
-  SCL_positionsEvaluated++;
-#endif
+  for (uint8_t i = 0; i < workerCount; ++i)
+  {
+    workers[i].work = &work;
 
-#if SCL_CALL_WDT_RESET
-  wdt_reset();
-#endif
+    if (i != 0 && started == i &&
+      _SCL_threadStart(&workers[i].thread,_SCL_rootWorker,workers + i))
+      started++;
+  }
 
-  uint8_t whitesTurn = SCL_boardWhitesTurn(board);
-  int8_t valueMultiply = whitesTurn ? 1 : -1;
-  int16_t bestMoveValue = -1 * SCL_EVALUATION_MAX_SCORE;
-  uint8_t shouldCompute = depth > 0;
-  uint8_t extended = 0;
-  uint8_t positionType = SCL_boardGetPosition(board);
+  _SCL_rootWorker(workers);
+
+  for (uint8_t i = 1; i < started; ++i)
+    _SCL_threadJoin(workers[i].thread);
 
-  if (!shouldCompute)
+  _SCL_lockFree(&work.lock);
+
+  for (uint8_t i = 0; i < started; ++i)
   {
-    /* here we do two extensions (deeper search): taking on a same square
-      (exchanges) and checks (good for mating and preventing mates): */
-    extended =
-      (depth > _SCL_depthHardLimit) &&
-      (takenSquare >= 0 ||
-      (SCL_boardGetPosition(board) == SCL_POSITION_CHECK));
+    context->nodes += workers[i].nodes;
 
-    shouldCompute = extended;
+    if (workers[i].aborted)
+      context->abort = 1;
   }
 
+  free(workers);
+
+  if (context->abort)
+    return 0;
+
+  // search the moves that beat the bound again, in order:
+
+  for (uint16_t i = 0; i < work.moveCount; ++i)
+    if (scores[i] > work.bound)
+    {
+      SCL_Move m = work.moves[i];
+      uint8_t from = SCL_moveFrom(m);
+      uint8_t to = SCL_moveTo(m);
+      int16_t score = 0;
+
+      if (from != repetitionMoveFrom || to != repetitionMoveTo)
+      {
+        context->moves[0] = m;
+
+        SCL_PositionUndo undo = SCL_positionMakeMove(position,from,to,
+          SCL_movePromotion(m));
+
+        score = -1 * _SCL_search(context,position,-1 * _SCL_SCORE_INFINITY,
+          -1 * bestScore,depth - 1,1);
+
+        SCL_positionUndoMove(position,undo);
+
+        if (context->abort)
+          return 0;
+      }
+
+      if (score > bestScore)
+      {
+        bestScore = score;
+        *bestMove = m;
+      }
+    }
+
+  return bestScore;
+}
+#endif // SCL_THREADS
+
+/**
+  Implements SCL_getAIMove after the depth is decided. If previousScore is not
+  0, it is the score of the previous iteration of iterative deepening (from
+  the point of view of white) and the search starts with a narrow window around
+  it (aspiration window), widening it if the score falls outside. The context
+  is kept between the iterations. If the search is aborted, the result is not
+  valid. The caller has to prepare the transposition table for the search.
+*/
+int16_t _SCL_getAIMove(
+  SCL_Board board,
+  uint8_t baseDepth,
+  uint8_t extensionExtraDepth,
+  SCL_StaticEvaluationFunction evalFunc,
+  SCL_RandomFunction randFunc,
+  uint8_t randomness,
+  uint8_t repetitionMoveFrom,
+  uint8_t repetitionMoveTo,
+  const int16_t *previousScore,
+  SCL_SearchContext *context,
+  SCL_Move *result)
+{
 #if SCL_DEBUG_AI
+  puts("===== AI debug =====");
   char moveStr[8];
-  uint8_t debugFirst = 1;
 #endif
 
-  if (shouldCompute &&
-    (positionType == SCL_POSITION_NORMAL || positionType == SCL_POSITION_CHECK))
-  {
-#if SCL_DEBUG_AI
-    putchar('(');
-#endif
+  SCL_Position position;
+  SCL_MoveList moves;
+  int16_t order[SCL_MOVE_LIST_MAX_LENGTH];
+  int8_t valueMultiply = SCL_boardWhitesTurn(board) ? 1 : -1;
+  SCL_Move hashMove = SCL_MOVE_NONE;
+  uint64_t key = 0;
 
-    alphaBeta *= valueMultiply;
-    uint8_t end = 0;
-    const char *b;
+  *result = SCL_MOVE_NONE;
 
-    depth--;
+  SCL_positionFromBoard(&position,board);
+  SCL_positionGetMoves(&position,&moves);
+  _SCL_removeExcludedMoves(context,&moves);
 
-#if SCL_ORDER_MOVES
-    for (int j = 0; j < 2; ++j)
+  if (SCL_transpositionTable.slots != 0)
+  {
+    key = _SCL_rootKey(context,board,extensionExtraDepth,repetitionMoveFrom,
+      repetitionMoveTo);
+
+    SCL_TranspositionEntry entry;
+
+    if (SCL_transpositionTableProbe(&SCL_transpositionTable,key,&entry))
     {
-      // two iteration: first check "usually better moves", then the rest
+      // check the move is legal in case of a key collision
+
+      for (uint16_t i = 0; i < moves.count; ++i)
+        if (moves.moves[i] == entry.move)
+        {
+          /* With no randomness the result would be the same as before,
+             otherwise at least search the previous best move first. */
+          if (randFunc == 0 && entry.depth >= baseDepth &&
+            (entry.info & 0x03) == SCL_BOUND_EXACT)
+          {
+            *result = entry.move;
+            return entry.score * valueMultiply;
+          }
+
+          hashMove = entry.move;
+          break;
+        }
+    }
+  }
+
+  if (moves.count == 0)
+    return
+#ifndef SCL_EVALUATION_FUNCTION
+      evalFunc(board);
+#else
+      SCL_EVALUATION_FUNCTION(board);
+
+  SCL_UNUSED(evalFunc);
 #endif
 
-      b = board;
+  context->keys[0] = SCL_boardKey(board);
 
-      for (int i = 0; i < SCL_BOARD_SQUARES; ++i, ++b)
-      {
-        char s = *b;
+  int32_t window = _SCL_ASPIRATION_WINDOW;
+  int32_t alpha = -1 * _SCL_SCORE_INFINITY;
+  int32_t beta = _SCL_SCORE_INFINITY;
+  int16_t bestScore;
+  SCL_Move bestMove;
 
-        if (s != '.' && SCL_pieceIsWhite(s) == whitesTurn)
-        {
-          SCL_SquareSet moves;
+#if SCL_ALPHA_BETA
+  // with randomness all scores must be exact, so no aspiration windows
+  if (previousScore != 0 && randFunc == 0)
+  {
+    alpha = *previousScore * valueMultiply - window;
+    beta = *previousScore * valueMultiply + window;
+  }
+#else
+  SCL_UNUSED(previousScore);
+#endif
 
-          SCL_squareSetClear(moves);
+  while (1)
+  {
+    if (alpha < -1 * _SCL_SCORE_INFINITY)
+      alpha = -1 * _SCL_SCORE_INFINITY;
 
-          SCL_boardGetMoves(board,i,moves);
+    if (beta > _SCL_SCORE_INFINITY)
+      beta = _SCL_SCORE_INFINITY;
 
-          if (!SCL_squareSetEmpty(moves))
-          {
-            SCL_SQUARE_SET_ITERATE_BEGIN(moves)
+    _SCL_orderMoves(board,&moves,order,hashMove);
 
-#if SCL_ORDER_MOVES
-            if ((board[iteratedSquare] != '.' && (
-                ( // taking with less valuable piece?
-                  (iteratedSquare == takenSquare) ||
-                  (SCL_pieceValuePositive(board[i]) + SCL_VALUE_PAWN / 2 <=
-                  SCL_pieceValuePositive(board[iteratedSquare]))
-                ))) != j)
-            {
+#if SCL_THREADS
+    // deterministic for 2 and more threads, see _SCL_searchRootParallel
+    if (context->threads > 1 && randFunc == 0 && previousScore == 0)
+      bestScore = _SCL_searchRootParallel(context,&position,&moves,order,
+        baseDepth,repetitionMoveFrom,repetitionMoveTo,&bestMove);
+    else
 #endif
-              int8_t captureExtension = -1;
+    bestScore = _SCL_searchRoot(context,&position,&moves,order,alpha,beta,
+      baseDepth,randFunc,randomness,repetitionMoveFrom,repetitionMoveTo,&bestMove);
 
-              if (board[iteratedSquare] != '.' &&   // takes a piece
-                (takenSquare == -1 ||               // extend on first taken sq.
-                (extended && takenSquare != -1) ||  // ignore check extension
-                (iteratedSquare == takenSquare)))   // extend on same sq. taken
-                captureExtension = iteratedSquare;
-
-              SCL_MoveUndo undo = SCL_boardMakeMove(board,i,iteratedSquare,'q');
+    if (context->abort)
+      return 0;
 
-              uint8_t s0Dummy, s1Dummy;
-              char pDummy;
+    if (bestScore <= alpha && alpha > -1 * _SCL_SCORE_INFINITY)
+      alpha -= window; // failed low, search again with wider window
+    else if (bestScore >= beta && beta < _SCL_SCORE_INFINITY)
+    {
+      beta += window;
+      hashMove = bestMove;
+    }
+    else
+      break;
 
-              SCL_UNUSED(s0Dummy);
-              SCL_UNUSED(s1Dummy);
-              SCL_UNUSED(pDummy);
+    window *= 4;
+  }
 
-#if SCL_DEBUG_AI
-              if (debugFirst)
-                debugFirst = 0;
-              else
-                putchar(',');
+  if (key != 0 && bestMove != SCL_MOVE_NONE &&
+    (randFunc == 0 || randomness <= 1)) // random bias makes the score inexact
+    SCL_transpositionTableStore(&SCL_transpositionTable,key,baseDepth,
+      SCL_BOUND_EXACT,bestScore,bestMove);
 
-              if (extended)
-                putchar('*');
+  *result = bestMove;
 
-              printf("%s ",SCL_moveToString(board,i,iteratedSquare,'q',moveStr));
+#if SCL_DEBUG_AI
+  printf("%d %s\n",bestScore * valueMultiply,SCL_moveToString(board,
+    SCL_moveFrom(bestMove),SCL_moveTo(bestMove),SCL_movePromotion(bestMove),
+    moveStr));
+  puts("===== AI debug end ===== ");
 #endif
 
-              int16_t value = _SCL_boardEvaluateDynamic(
-                board,
-                depth, // this is depth - 1, we decremented it
-#if SCL_ALPHA_BETA
-                valueMultiply * bestMoveValue,
+  return bestScore * valueMultiply;
+}
 #else
-                0,
-#endif
-                captureExtension
-                ) * valueMultiply;
+int16_t _SCL_getAIMove(
+  SCL_Board board,
+  uint8_t baseDepth,
+  uint8_t extensionExtraDepth,
+  SCL_StaticEvaluationFunction evalFunc,
+  SCL_RandomFunction randFunc,
+  uint8_t randomness,
+  uint8_t repetitionMoveFrom,
+  uint8_t repetitionMoveTo,
+  const int16_t *previousScore,
+  SCL_SearchContext *context,
+  SCL_Move *result)
+{
+  SCL_UNUSED(previousScore);
+  SCL_UNUSED(evalFunc); // the context has it
 
-              SCL_boardUndoMove(board,undo);
+#if SCL_DEBUG_AI
+  puts("===== AI debug =====");
+  putchar('(');
+  unsigned char debugFirst = 1;
+  char moveStr[8];
+#endif
 
-              if (value > bestMoveValue)
-              {
-                bestMoveValue = value;
+  *result = SCL_MOVE_NONE;
 
-#if SCL_ALPHA_BETA
-                // alpha-beta pruning:
+  int16_t bestScore =
+    SCL_boardWhitesTurn(board) ?
+    -1 * SCL_EVALUATION_MAX_SCORE - 1 : (SCL_EVALUATION_MAX_SCORE + 1);
 
-                if (value > alphaBeta) // no, >= can't be here
-                {
-                  end = 1;
-                  iterationEnd = 1;
-                }
-#endif
-              }
+  SCL_MoveList moves;
+  SCL_Move bestMove = SCL_MOVE_NONE;
+  uint64_t key = 0;
 
-#if SCL_ORDER_MOVES
-            }
-#endif
+  SCL_boardGetMoveList(board,&moves);
+  _SCL_removeExcludedMoves(context,&moves);
 
-            SCL_SQUARE_SET_ITERATE_END
-          } // !squre set empty?
-        } // valid piece?
+  if (SCL_transpositionTable.slots != 0)
+  {
+    key = _SCL_rootKey(context,board,extensionExtraDepth,repetitionMoveFrom,
+      repetitionMoveTo);
 
-        if (end)
-          break;
+    SCL_TranspositionEntry entry;
 
-      } // for each square
+    if (randFunc == 0 &&
+      SCL_transpositionTableProbe(&SCL_transpositionTable,key,&entry) &&
+      entry.depth >= baseDepth && (entry.info & 0x03) == SCL_BOUND_EXACT)
+    {
+      /* With no randomness the result would be the same as before, but still
+         check the move is legal in case of a key collision. */
 
-#if SCL_ORDER_MOVES
+      for (uint16_t i = 0; i < moves.count; ++i)
+        if (moves.moves[i] == entry.move)
+        {
+          *result = entry.move;
+          return entry.score * (SCL_boardWhitesTurn(board) ? 1 : -1);
+        }
+    }
   }
-#endif
 
-#if SCL_DEBUG_AI
-  putchar(')');
-#endif
-  }
-  else // don't dive recursively, evaluate statically
+  for (uint16_t i = 0; i < moves.count; ++i)
   {
-    bestMoveValue = valueMultiply *
-  #ifndef SCL_EVALUATION_FUNCTION
-      _SCL_staticEvaluationFunction(board);
-  #else
-      SCL_EVALUATION_FUNCTION(board);
-  #endif
-
-    /* For stalemate return the opposite value of the board, i.e. if the
-       position is good for white, then stalemate is good for black and vice
-       versa. */
-    if (positionType == SCL_POSITION_STALEMATE)
-      bestMoveValue *= -1;
-  }
-
-  /* Here we either improve (if the move worsens the situation) or devalve (if
-     it improves the situation) the result: this needs to be done so that good
-     moves far away are seen as worse compared to equally good moves achieved
-     in fewer moves. Without this an AI in winning situation may just repeat
-     random moves and draw by repetition even if it has mate in 1 (it sees all
-     moves as leading to mate). */
-  bestMoveValue += bestMoveValue > _SCL_currentEval * valueMultiply ? -1 : 1;
+    uint8_t from = SCL_moveFrom(moves.moves[i]);
+    uint8_t to = SCL_moveTo(moves.moves[i]);
+    char promotion = SCL_movePromotion(moves.moves[i]);
+    int16_t score = 0;
 
 #if SCL_DEBUG_AI
-  printf("%d",bestMoveValue * valueMultiply);
-#endif
+    if (debugFirst)
+      debugFirst = 0;
+    else
+      putchar(',');
 
-  return bestMoveValue * valueMultiply;
-}
+    printf("%s ",SCL_moveToString(board,from,to,promotion,moveStr));
+#endif
 
-int16_t SCL_boardEvaluateDynamic(SCL_Board board, uint8_t baseDepth,
-  uint8_t extensionExtraDepth, SCL_StaticEvaluationFunction evalFunction)
-{
-  _SCL_staticEvaluationFunction = evalFunction;
-  _SCL_currentEval = evalFunction(board);
-  _SCL_depthHardLimit = 0;
-  _SCL_depthHardLimit -= extensionExtraDepth;
+    if (from != repetitionMoveFrom || to != repetitionMoveTo)
+    {
+      SCL_MoveUndo undo = SCL_boardMakeMove(board,from,to,promotion);
 
-  return _SCL_boardEvaluateDynamic(
-    board,
-    baseDepth,
-    SCL_boardWhitesTurn(board) ?
-      SCL_EVALUATION_MAX_SCORE : (-1 * SCL_EVALUATION_MAX_SCORE),-1);
-}
+      score = _SCL_evaluateDynamic(context,board,baseDepth - 1);
 
-void SCL_boardRandomMove(SCL_Board board, SCL_RandomFunction randFunc,
-  uint8_t *squareFrom, uint8_t *squareTo, char *resultProm)
-{
-  *resultProm = (randFunc() < 128) ?
-    ((randFunc() < 128) ? 'r' : 'n') :
-    ((randFunc() < 128) ? 'b' : 'q');
+      SCL_boardUndoMove(board,undo);
 
-  SCL_SquareSet set;
-  uint8_t white = SCL_boardWhitesTurn(board);
-  const char *s = board;
+      if (context->abort)
+        return 0;
+    }
 
-  SCL_squareSetClear(set);
+    if (randFunc != 0 &&
+      randomness > 1 &&
+      score < 16000 &&
+      score > -16000)
+    {
+      /*^ We limit randomizing by about half the max score for two reasons:
+        to prevent over/under flows and secondly we don't want to alter
+        the highest values for checkmate -- these are modified by tiny
+        values depending on their depth so as to prevent endless loops in
+        which most moves are winning, biasing such values would completely
+        kill that algorithm */
+
+      int16_t bias = randFunc();
+      bias = (bias - 128) / 2;
+      bias *= randomness - 1;
+      score += bias;
+    }
 
-  // find squares with pieces that have legal moves
+    uint8_t comparison =
+      score == bestScore;
 
-  for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i, ++s)
-  {
-    char c = *s;
+    if ((comparison != 1) &&
+      (
+        (SCL_boardWhitesTurn(board) && score > bestScore) ||
+        (!SCL_boardWhitesTurn(board) && score < bestScore)
+      ))
+      comparison = 2;
 
-    if (c != '.' && SCL_pieceIsWhite(c) == white)
-    {
-      SCL_SquareSet moves;
+    uint8_t replace = 0;
 
-      SCL_boardGetMoves(board,i,moves);
+    if (randFunc == 0)
+      replace = comparison == 2;
+    else
+      replace = (comparison == 2) ||
+      ((comparison == 1) && (randFunc() < 160)); // not uniform distr. but simple
 
-      if (SCL_squareSetSize(moves) != 0)
-        SCL_squareSetAdd(set,i);
+    if (replace)
+    {
+      bestScore = score;
+      bestMove = moves.moves[i];
     }
   }
 
-  *squareFrom = SCL_squareSetGetRandom(set,randFunc);
-
-  SCL_boardGetMoves(board,*squareFrom,set);
-
-  *squareTo = SCL_squareSetGetRandom(set,randFunc);
-}
+  if (key != 0 && bestMove != SCL_MOVE_NONE &&
+    (randFunc == 0 || randomness <= 1)) // random bias makes the score inexact
+    SCL_transpositionTableStore(&SCL_transpositionTable,key,baseDepth,
+      SCL_BOUND_EXACT,bestScore * (SCL_boardWhitesTurn(board) ? 1 : -1),
+      bestMove);
 
-void SCL_printBoardSimple(
-  SCL_Board board,
-  SCL_PutCharFunction putCharFunc,
-  uint8_t selectSquare,
-  uint8_t format)
-{
-  SCL_SquareSet s;
+  *result = bestMove;
 
-  SCL_squareSetClear(s);
+#if SCL_DEBUG_AI
+  printf(")%d %s\n",bestScore,SCL_moveToString(board,SCL_moveFrom(bestMove),
+    SCL_moveTo(bestMove),SCL_movePromotion(bestMove),moveStr));
+  puts("===== AI debug end ===== ");
+#endif
 
-  SCL_printBoard(board,putCharFunc,s,selectSquare,format,1,1,0);
+  return bestScore;
 }
+#endif // SCL_SEARCH_NEGAMAX
 
 int16_t SCL_getAIMove(
   SCL_Board board,
@@ -2916,13 +8002,6 @@ int16_t SCL_getAIMove(
   uint8_t *resultTo,
   char *resultProm)
 {
-#if SCL_DEBUG_AI
-  puts("===== AI debug =====");
-  putchar('(');
-  unsigned char debugFirst = 1;
-  char moveStr[8];
-#endif
-
   if (baseDepth == 0)
   {
     SCL_boardRandomMove(board,randFunc,resultFrom,resultTo,resultProm);
@@ -2936,101 +8015,289 @@ int16_t SCL_getAIMove(
   if (SCL_boardEstimatePhase(board) == SCL_PHASE_ENDGAME)
     baseDepth += endgameExtraDepth;
 
+  SCL_Move move;
+  SCL_SearchContext context;
+
+  _SCL_searchContextInit(&context,evalFunc,extensionExtraDepth);
+  context.threads = _SCL_threadCount;
+
+  SCL_transpositionTableNewSearch(&SCL_transpositionTable);
+  _SCL_transpositionTableCheckFunction(evalFunc);
+
+  int16_t result = _SCL_getAIMove(board,baseDepth,extensionExtraDepth,evalFunc,
+    randFunc,randomness,repetitionMoveFrom,repetitionMoveTo,0,&context,&move);
+
+#if SCL_COUNT_EVALUATED_POSITIONS
+  // root parallel workers' nodes are added to the context when they finish
+  SCL_positionsEvaluated += context.nodes;
+#endif
+
+  *resultFrom = SCL_moveFrom(move);
+  *resultTo = SCL_moveTo(move);
+  *resultProm = SCL_movePromotion(move);
+
+  return result;
+}
+
+#if SCL_THREADS
+/**
+  Helper thread of Lazy SMP search: it searches the same position as the main
+  thread, only to fill the shared transposition table for it, until the main
+  thread sets the stop flag.
+*/
+typedef struct
+{
+  SCL_SearchContext context;
+  SCL_Board board;                ///< own copy, the old search modifies it
+  uint8_t index;                  ///< 1 for the first helper
+  uint8_t extensionExtraDepth;
+  uint8_t repetitionMoveFrom;
+  uint8_t repetitionMoveTo;
+  _SCL_Thread thread;
+} _SCL_SearchThread;
+
+/* Helpers skip some depths so that they search different depths at a time
+   than the main thread and each other, sizes and phases of the skipped depth
+   blocks by helper. */
+static const uint8_t _SCL_helperSkipSize[20] =
+  {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+
+static const uint8_t _SCL_helperSkipPhase[20] =
+  {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+_SCL_THREAD_FUNCTION(_SCL_helperSearch)
+{
+  _SCL_SearchThread *helper = (_SCL_SearchThread *) data;
+  uint8_t skip = (helper->index - 1) % 20;
+  int16_t score = 0;
+
+  for (uint8_t depth = 1; depth <= SCL_SEARCH_MAX_PLY / 2; ++depth)
+  {
+    SCL_Move move;
+
+    if (((depth + _SCL_helperSkipPhase[skip]) /
+      _SCL_helperSkipSize[skip]) % 2)
+      continue;
+
+    // no randomness, the random function may not be thread safe
+    score = _SCL_getAIMove(helper->board,depth,helper->extensionExtraDepth,
+      helper->context.evalFunction,0,0,helper->repetitionMoveFrom,
+      helper->repetitionMoveTo,depth > 1 ? &score : 0,&helper->context,&move);
+
+    if (helper->context.abort || move == SCL_MOVE_NONE)
+      break;
+  }
+
+  return 0;
+}
+
+#endif // SCL_THREADS
+
+int16_t SCL_getAIMoveIterative(
+  SCL_Board board,
+  const SCL_SearchLimits *limits,
+  uint8_t extensionExtraDepth,
+  SCL_StaticEvaluationFunction evalFunc,
+  SCL_RandomFunction randFunc,
+  uint8_t randomness,
+  uint8_t repetitionMoveFrom,
+  uint8_t repetitionMoveTo,
+  SCL_SearchInfoFunction infoFunc,
+  uint8_t *resultFrom,
+  uint8_t *resultTo,
+  char *resultProm)
+{
+  SCL_SearchInfo info;
+  SCL_SearchContext context;
+  int16_t result = 0;
+
+  _SCL_searchContextInit(&context,evalFunc,extensionExtraDepth);
+
   *resultFrom = 0;
   *resultTo = 0;
   *resultProm = 'q';
 
-  int16_t bestScore =
-    SCL_boardWhitesTurn(board) ?
-    -1 * SCL_EVALUATION_MAX_SCORE - 1 : (SCL_EVALUATION_MAX_SCORE + 1);
+  uint8_t maxDepth = limits->depth != 0 ? limits->depth : 64;
+  uint8_t multiPV = limits->multiPV == 0 ? 1 :
+    (limits->multiPV > SCL_MAX_MULTI_PV ? SCL_MAX_MULTI_PV : limits->multiPV);
+  SCL_Move lineMoves[SCL_MAX_MULTI_PV];
+  int16_t lineScores[SCL_MAX_MULTI_PV];
 
-  for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i)
-    if (board[i] != '.' &&
-      SCL_boardWhitesTurn(board) == SCL_pieceIsWhite(board[i]))
-    {
-      SCL_SquareSet moves;
+  context.excludedMoves = lineMoves;
 
-      SCL_squareSetClear(moves);
+  for (uint8_t i = 0; i < SCL_MAX_MULTI_PV; ++i)
+    lineScores[i] = 0;
 
-      SCL_boardGetMoves(board,i,moves);
+  // limits are only checked after depth 1 is done
+  context.startTime = limits->timeFunction != 0 ? limits->timeFunction() : 0;
 
-      SCL_SQUARE_SET_ITERATE_BEGIN(moves)
+  uint32_t pawnTableProbes = SCL_pawnTable.probes;
+  uint32_t pawnTableHits = SCL_pawnTable.hits;
 
-        int16_t score = 0;
+  SCL_transpositionTableNewSearch(&SCL_transpositionTable);
+  _SCL_transpositionTableCheckFunction(evalFunc);
 
-#if SCL_DEBUG_AI
-      if (debugFirst)
-        debugFirst = 0;
-      else
-        putchar(',');
+#if SCL_THREADS
+  volatile uint8_t stop = 0;
+  uint8_t helperCount = 0;
+  _SCL_SearchThread *helpers = 0;
+
+  if (_SCL_threadCount > 1)
+    helpers = (_SCL_SearchThread *)
+      malloc((_SCL_threadCount - 1) * sizeof(_SCL_SearchThread));
+
+  if (helpers != 0) // if not, just search with one thread
+    for (uint8_t i = 0; i < _SCL_threadCount - 1; ++i)
+    {
+      _SCL_SearchThread *helper = helpers + helperCount;
+
+      _SCL_searchContextInit(&helper->context,evalFunc,extensionExtraDepth);
+      helper->context.stop = &stop;
+      SCL_boardCopy(board,helper->board);
+      helper->index = helperCount + 1;
+      helper->extensionExtraDepth = extensionExtraDepth;
+      helper->repetitionMoveFrom = repetitionMoveFrom;
+      helper->repetitionMoveTo = repetitionMoveTo;
 
-printf("%s ",SCL_moveToString(
-board,i,iteratedSquare,'q',moveStr));
+      if (!_SCL_threadStart(&helper->thread,_SCL_helperSearch,helper))
+        break;
 
+      helperCount++;
+    }
 #endif
 
-        if (i != repetitionMoveFrom || iteratedSquare != repetitionMoveTo)
-        {
-          SCL_MoveUndo undo = SCL_boardMakeMove(board,i,iteratedSquare,'q');
+  for (uint8_t depth = 1; depth <= maxDepth; ++depth)
+  {
+    SCL_Move move;
 
-          score = SCL_boardEvaluateDynamic(board,baseDepth - 1,
-            extensionExtraDepth,evalFunc);
+    int16_t score = _SCL_getAIMove(board,depth,extensionExtraDepth,evalFunc,
+      randFunc,randomness,repetitionMoveFrom,repetitionMoveTo,
+      depth > 1 ? &result : 0,&context,&move);
 
-          SCL_boardUndoMove(board,undo);
-        }
+    if (context.abort)
+      break;
 
-        if (randFunc != 0 &&
-          randomness > 1 &&
-          score < 16000 &&
-          score > -16000)
-        {
-          /*^ We limit randomizing by about half the max score for two reasons:
-            to prevent over/under flows and secondly we don't want to alter
-            the highest values for checkmate -- these are modified by tiny
-            values depending on their depth so as to prevent endless loops in
-            which most moves are winning, biasing such values would completely
-            kill that algorithm */
-
-          int16_t bias = randFunc();
-          bias = (bias - 128) / 2;
-          bias *= randomness - 1;
-          score += bias;
-        }
+    result = score;
+    *resultFrom = SCL_moveFrom(move);
+    *resultTo = SCL_moveTo(move);
+    *resultProm = SCL_movePromotion(move);
 
-        uint8_t comparison =
-          score == bestScore;
+    lineMoves[0] = move;
+    lineScores[0] = score;
 
-        if ((comparison != 1) &&
-          (
-            (SCL_boardWhitesTurn(board) && score > bestScore) ||
-            (!SCL_boardWhitesTurn(board) && score < bestScore)
-          ))
-          comparison = 2;
+    uint8_t lines = 1;
 
-        uint8_t replace = 0;
+    /* Each further line searches the root without the moves of the previous
+       lines (with no randomness) to find the next best move. */
+    while (lines < multiPV && move != SCL_MOVE_NONE)
+    {
+      SCL_Move lineMove;
 
-        if (randFunc == 0)
-          replace = comparison == 2;
-        else
-          replace = (comparison == 2) ||
-          ((comparison == 1) && (randFunc() < 160)); // not uniform distr. but simple
+      context.excludedCount = lines;
 
-        if (replace)
-        {
-          *resultFrom = i;
-          *resultTo = iteratedSquare;
-          bestScore = score;
-        }
+      int16_t lineScore = _SCL_getAIMove(board,depth,extensionExtraDepth,
+        evalFunc,0,0,repetitionMoveFrom,repetitionMoveTo,
+        depth > 1 ? lineScores + lines : 0,&context,&lineMove);
 
-      SCL_SQUARE_SET_ITERATE_END
+      context.excludedCount = 0;
+
+      if (context.abort || lineMove == SCL_MOVE_NONE)
+        break;
+
+      lineMoves[lines] = lineMove;
+      lineScores[lines] = lineScore;
+      lines++;
     }
 
-#if SCL_DEBUG_AI
-  printf(")%d %s\n",bestScore,SCL_moveToString(board,*resultFrom,*resultTo,'q',moveStr));
-  puts("===== AI debug end ===== ");
+    info.depth = depth;
+    info.nodes = context.nodes;
+    info.time = limits->timeFunction != 0 ?
+      limits->timeFunction() - context.startTime : 0;
+    info.cutoffs = context.cutoffs;
+    info.firstMoveCutoffs = context.firstMoveCutoffs;
+    info.pawnTableProbes = SCL_pawnTable.probes - pawnTableProbes;
+    info.pawnTableHits = SCL_pawnTable.hits - pawnTableHits;
+
+#if SCL_THREADS
+    for (uint8_t i = 0; i < helperCount; ++i)
+      info.nodes += helpers[i].context.nodes; // approximate while they run
 #endif
 
-  return bestScore;
+    if (infoFunc != 0)
+      for (uint8_t i = 0; i < lines; ++i)
+      {
+        info.score = lineScores[i];
+        info.move = lineMoves[i];
+        info.multiPV = i + 1;
+        infoFunc(&info);
+      }
+
+    if (move == SCL_MOVE_NONE) // no legal moves
+      break;
+
+    // a mate within the searched depth is proven, deeper search can't change it
+    if (score >= SCL_EVALUATION_MAX_SCORE - depth ||
+      score <= depth - SCL_EVALUATION_MAX_SCORE)
+      break;
+
+    context.limits = limits;
+
+    _SCL_checkSearchLimits(&context);
+
+    /* Next iteration usually takes several times longer than this one, so
+       don't start it if it very likely wouldn't finish. */
+    uint32_t time = _SCL_searchTimeLimit(limits);
+
+    if (context.abort || (time != 0 && info.time * 2 >= time))
+      break;
+  }
+
+  SCL_searchNodes = context.nodes;
+
+#if SCL_THREADS
+  stop = 1;
+
+  for (uint8_t i = 0; i < helperCount; ++i)
+  {
+    _SCL_threadJoin(helpers[i].thread);
+    SCL_searchNodes += helpers[i].context.nodes;
+  }
+
+  free(helpers);
+#endif
+
+#if SCL_COUNT_EVALUATED_POSITIONS
+  SCL_positionsEvaluated += SCL_searchNodes;
+#endif
+
+  return result;
+}
+
+SCL_Move SCL_getAIPonderMove(SCL_Board board, uint8_t from, uint8_t to,
+  char promotion, uint8_t extensionExtraDepth)
+{
+  SCL_Position position;
+  SCL_MoveList moves;
+  SCL_TranspositionEntry entry;
+
+  if (SCL_transpositionTable.slots == 0)
+    return SCL_MOVE_NONE;
+
+  SCL_positionFromBoard(&position,board);
+  SCL_positionMakeMove(&position,from,to,promotion);
+
+  if (!SCL_transpositionTableProbe(&SCL_transpositionTable,
+    _SCL_searchKey(position.board,-1 * extensionExtraDepth),&entry))
+    return SCL_MOVE_NONE;
+
+  SCL_positionGetMoves(&position,&moves);
+
+  // check the move is legal in case of a key collision
+  for (uint16_t i = 0; i < moves.count; ++i)
+    if (moves.moves[i] == entry.move)
+      return entry.move;
+
+  return SCL_MOVE_NONE;
 }
 
 uint8_t SCL_boardToFEN(SCL_Board board, char *string)
@@ -3139,6 +8406,8 @@ uint8_t SCL_boardToFEN(SCL_Board board, char *string)
 
 uint8_t SCL_boardFromFEN(SCL_Board board, const char *string)
 {
+  SCL_init();
+
   uint8_t square = 56;
 
   while (1)
@@ -3195,6 +8464,7 @@ uint8_t SCL_boardFromFEN(SCL_Board board, const char *string)
       case 'Q': castleEnPassant |= 0x20; break;
       case 'k': castleEnPassant |= 0x40; break;
       case 'q': castleEnPassant |= 0x80; break;
+      case '-': break;
       default: castleEnPassant |= 0xf0; break;  // for partial XFEN compat.
     }
 
@@ -3246,6 +8516,8 @@ uint8_t SCL_boardFromFEN(SCL_Board board, const char *string)
   _SCL_board960RememberRookPositions(board);
 #endif
 
+  SCL_boardUpdateKey(board);
+
   return 1;
 #undef nextChar
 }
@@ -3380,44 +8652,15 @@ void SCL_drawBoard(
 
 uint32_t SCL_boardHash32(const SCL_Board board)
 {
-  uint32_t result = (board[SCL_BOARD_PLY_BYTE] & 0x01) +
-    (((uint32_t) ((uint8_t) board[SCL_BOARD_ENPASSANT_CASTLE_BYTE])) << 24) +
-    board[SCL_BOARD_MOVE_COUNT_BYTE];
-
-  const char *b = board;
-
-  for (uint8_t i = 0; i < SCL_BOARD_SQUARES; ++i, ++b)
-  {
-    switch (*b)
-    {
-#define C(p,n) case p: result ^= (i + 1) * n; break;
-      // the below number are primes
-      C('P',4003)
-      C('R',84673)
-      C('N',93911)
-      C('B',999331)
-      C('Q',909091)
-      C('K',2796203)
-      C('p',4793)
-      C('r',19391)
-      C('n',391939)
-      C('b',108301)
-      C('q',174763)
-      C('k',2474431)
-#undef C
-      default: break;
-    }
-  }
+  uint64_t key = SCL_boardKey(board);
 
-  // for extra spread of values we swap the low/high parts:
-  result = (result >> 16) | (result << 16);
-
-  return result;
+  return (uint32_t) (key ^ (key >> 32));
 }
 
 void SCL_boardDisableCastling(SCL_Board board)
 {
   board[SCL_BOARD_ENPASSANT_CASTLE_BYTE] &= 0x0f;
+  SCL_boardUpdateKey(board);
 }
 
 uint8_t SCL_boardMoveResetsCount(SCL_Board board,
@@ -3501,22 +8744,29 @@ void SCL_printPGN(SCL_Record r, SCL_PutCharFunction putCharFunc,
 
         // disambiguation:
 
-        uint8_t specify = 0;
+        uint8_t specify = 0; // bits: ambiguous, same file, same rank
+        SCL_MoveList moves;
 
-        for (int i = 0; i < SCL_BOARD_SQUARES; ++i)
-          if (i != s0 && board[i] == board[s0])
-          {
-            SCL_SquareSet s;
+        SCL_boardGetMoveList(board,&moves);
+
+        for (uint16_t i = 0; i < moves.count; ++i)
+        {
+          uint8_t from = SCL_moveFrom(moves.moves[i]);
 
-            SCL_squareSetClear(s);
+          if (from != s0 && board[from] == board[s0] &&
+            SCL_moveTo(moves.moves[i]) == s1)
+          {
+            specify |= 0x01;
 
-            SCL_boardGetMoves(board,i,s);
+            if (from % 8 == s0 % 8)
+              specify |= 0x02;
 
-            if (SCL_squareSetContains(s,s1))
-              specify |= (s0 % 8 != s1 % 8) ? 1 : 2;
+            if (from / 8 == s0 / 8)
+              specify |= 0x04;
           }
+        }
 
-        if (specify & 0x01)
+        if ((specify & 0x01) && (!(specify & 0x02) || (specify & 0x04)))
           putCharFunc('a' + s0 % 8);
 
         if (specify & 0x02)
@@ -3572,6 +8822,8 @@ void SCL_recordCopy(SCL_Record recordFrom, SCL_Record recordTo)
 
 void SCL_gameInit(SCL_Game *game, const SCL_Board startState)
 {
+  SCL_init();
+
   game->startState = startState;
 
   if (startState != 0)
@@ -0,0 +1,403 @@
+// UCI (Universal Chess Interface) engine, build with build.sh. Reads commands
+// from stdin so that the library's AI can be plugged into chess GUIs and
+// tournament managers. The search runs on its own thread (engine.h) so that
+// stop and ponderhit are handled while it searches.
+
+#define SCL_TRANSPOSITION_TABLE_SIZE 16 // the default Hash
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <mutex>
+
+#include "smallchesslib.h"
+#include "engine.h"
+
+#define EXTRA_DEPTH 3
+#define MOVE_OVERHEAD 20 // ms kept for the GUI communication
+
+SCL_Game game;
+SCL_Board start_board;
+SCL_Board search_board; // position of the last go, for printing moves
+engine ai = {};
+int multi_pv = 1;
+
+// Infinite and ponder searches mustn't print bestmove before stop or ponderhit
+// even if they end, so the result is held until then. Output comes from both
+// threads, the mutex also keeps the lines whole.
+std::mutex output_mutex;
+bool hold_result = false;
+bool discard_result = false; // set while a search is cancelled, its move mustn't be printed
+bool result_held = false;
+engine_result held_result;
+uint32_t ponder_time = 0; // time given to a ponder search on ponderhit
+
+void send(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    putchar('\n');
+    fflush(stdout);
+}
+
+void send_locked(const char* format, ...) {
+    std::lock_guard<std::mutex> lock(output_mutex);
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    putchar('\n');
+    fflush(stdout);
+}
+
+void send_bestmove(const engine_result* result) {
+    char move_string[8];
+    char ponder_string[8];
+    SCL_Board board;
+
+    // the iterations' info only counts nodes up to the last completed one
+    send("info nodes %llu nps %llu time %lu", (unsigned long long)result->nodes,
+         result->time ? (unsigned long long)(result->nodes * 1000 / result->time) : 0ULL,
+         (unsigned long)result->time);
+
+    if (result->from == result->to) { // no legal moves
+        send("bestmove 0000");
+        return;
+    }
+
+    SCL_moveToString(search_board, result->from, result->to, result->promotion, move_string);
+
+    if (result->ponder == SCL_MOVE_NONE) {
+        send("bestmove %s", move_string);
+        return;
+    }
+
+    SCL_boardCopy(search_board, board);
+    SCL_boardMakeMove(board, result->from, result->to, result->promotion);
+    SCL_moveToString(board, SCL_moveFrom(result->ponder), SCL_moveTo(result->ponder),
+                     SCL_movePromotion(result->ponder), ponder_string);
+    send("bestmove %s ponder %s", move_string, ponder_string);
+}
+
+// called on the search thread
+void search_done(const engine_result* result) {
+    std::lock_guard<std::mutex> lock(output_mutex);
+
+    if (discard_result) {
+        return;
+    }
+
+    if (hold_result) {
+        held_result = *result;
+        result_held = true;
+    } else {
+        send_bestmove(result);
+    }
+}
+
+// Ends the running search without printing its move, unlike stop.
+void cancel_search() {
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        discard_result = true;
+    }
+
+    engine_cancel(&ai);
+
+    std::lock_guard<std::mutex> lock(output_mutex);
+    discard_result = false;
+}
+
+void release_result() {
+    std::lock_guard<std::mutex> lock(output_mutex);
+
+    hold_result = false;
+
+    if (result_held) {
+        result_held = false;
+        send_bestmove(&held_result);
+    }
+}
+
+// called on the search thread after each iteration (and each line of MultiPV)
+void search_info(const SCL_SearchInfo* info) {
+    char pv[1024];
+    char* end = pv;
+    SCL_Board board;
+    SCL_Move move = info->move;
+
+    // the rest of the principal variation comes from the transposition table
+    SCL_boardCopy(search_board, board);
+
+    for (int i = 0; i < info->depth && move != SCL_MOVE_NONE; i++) {
+        uint8_t from = SCL_moveFrom(move), to = SCL_moveTo(move);
+        char promotion = SCL_movePromotion(move);
+
+        *end++ = ' ';
+        SCL_moveToString(board, from, to, promotion, end);
+        end += strlen(end);
+
+        move = SCL_getAIPonderMove(board, from, to, promotion, EXTRA_DEPTH);
+        SCL_boardMakeMove(board, from, to, promotion);
+    }
+
+    *end = 0;
+
+    // the library's scores are from white's view, UCI's from the side to move's
+    int score = SCL_boardWhitesTurn(search_board) ? info->score : -info->score;
+    char score_string[32];
+
+    if (score > SCL_EVALUATION_MAX_SCORE - SCL_SEARCH_MAX_PLY) {
+        sprintf(score_string, "mate %d", (SCL_EVALUATION_MAX_SCORE - score + 1) / 2);
+    } else if (score < SCL_SEARCH_MAX_PLY - SCL_EVALUATION_MAX_SCORE) {
+        sprintf(score_string, "mate %d", -(SCL_EVALUATION_MAX_SCORE + score) / 2);
+    } else {
+        sprintf(score_string, "cp %d", score * 100 / SCL_VALUE_PAWN);
+    }
+
+    send_locked("info depth %d multipv %d score %s nodes %llu nps %llu time %lu pv%s", info->depth,
+                info->multiPV, score_string, (unsigned long long)info->nodes,
+                info->time ? (unsigned long long)(info->nodes * 1000 / info->time) : 0ULL,
+                (unsigned long)info->time, pv);
+}
+
+void position(char* args) {
+    char* token = strtok(args, " \t\n");
+
+    if (token && strcmp(token, "fen") == 0) {
+        char fen[128] = { 0 };
+
+        while ((token = strtok(0, " \t\n")) && strcmp(token, "moves") != 0) {
+            if (strlen(fen) + strlen(token) + 2 < sizeof(fen)) {
+                strcat(fen, token);
+                strcat(fen, " ");
+            }
+        }
+
+        if (!SCL_boardFromFEN(start_board, fen)) {
+            send_locked("info string bad FEN: %s", fen);
+            SCL_boardInit(start_board);
+        }
+
+        SCL_gameInit(&game, start_board);
+    } else {
+        SCL_gameInit(&game, 0);
+        token = strtok(0, " \t\n"); // "moves"
+    }
+
+    while ((token = strtok(0, " \t\n"))) {
+        uint8_t from, to;
+        char promotion;
+
+        if (!SCL_stringToMove(token, &from, &to, &promotion)) {
+            send_locked("info string bad move: %s", token);
+            break;
+        }
+
+        SCL_gameMakeMove(&game, from, to, promotion);
+    }
+}
+
+void go(char* args) {
+    SCL_SearchLimits limits = {};
+    bool white = SCL_boardWhitesTurn(game.board);
+    long times[2] = { 0, 0 }, increments[2] = { 0, 0 };
+    long moves_to_go = 0, move_time = 0;
+    bool infinite = false, ponder = false;
+    uint8_t rs0, rs1;
+
+    for (char* token = strtok(args, " \t\n"); token; token = strtok(0, " \t\n")) {
+        char* value = 0;
+
+        if (strcmp(token, "infinite") == 0) {
+            infinite = true;
+        } else if (strcmp(token, "ponder") == 0) {
+            ponder = true;
+        } else if ((value = strtok(0, " \t\n"))) {
+            long number = atol(value);
+
+            if (strcmp(token, "depth") == 0) {
+                limits.depth = number > 0 && number < 64 ? number : 64;
+            } else if (strcmp(token, "nodes") == 0) {
+                limits.nodes = number;
+            } else if (strcmp(token, "movetime") == 0) {
+                move_time = number;
+            } else if (strcmp(token, "wtime") == 0) {
+                times[0] = number;
+            } else if (strcmp(token, "btime") == 0) {
+                times[1] = number;
+            } else if (strcmp(token, "winc") == 0) {
+                increments[0] = number;
+            } else if (strcmp(token, "binc") == 0) {
+                increments[1] = number;
+            } else if (strcmp(token, "movestogo") == 0) {
+                moves_to_go = number;
+            }
+        }
+    }
+
+    long time = move_time;
+    long remaining = times[white ? 0 : 1];
+
+    if (time == 0 && remaining > 0) {
+        // the search stops once half of it is used up without finishing a depth
+        time = remaining / (moves_to_go > 0 ? moves_to_go + 1 : 30) + increments[white ? 0 : 1] * 3 / 4;
+
+        if (time > remaining / 2) {
+            time = remaining / 2;
+        }
+    }
+
+    if (time > MOVE_OVERHEAD * 2) {
+        time -= MOVE_OVERHEAD;
+    } else if (time > 0) {
+        time = time / 2 + 1;
+    }
+
+    if (!infinite && !ponder) {
+        limits.time = time;
+    }
+
+    limits.multiPV = multi_pv;
+    ponder_time = infinite ? 0 : time;
+
+    cancel_search();
+
+    {
+        std::lock_guard<std::mutex> lock(output_mutex);
+        hold_result = infinite || ponder;
+        result_held = false;
+    }
+
+    SCL_boardCopy(game.board, search_board);
+    SCL_gameGetRepetiotionMove(&game, &rs0, &rs1);
+    engine_start(&ai, game.board, &limits, EXTRA_DEPTH, 0, rs0, rs1);
+}
+
+#if SCL_NNUE
+// Switches the evaluation to the NNUE network in the file, an empty name goes
+// back to the default evaluation.
+void load_network(const char* file) {
+    static uint8_t data[SCL_NNUE_FILE_SIZE + 1];
+
+    if (*file == 0 || strcmp(file, "<empty>") == 0) {
+        ai.evaluation = 0;
+        return;
+    }
+
+    FILE* f = fopen(file, "rb");
+    size_t size = f ? fread(data, 1, sizeof(data), f) : 0;
+
+    if (f) {
+        fclose(f);
+    }
+
+    if (SCL_nnueLoad(&SCL_nnueNetwork, data, (uint32_t)size)) {
+        ai.evaluation = SCL_boardEvaluateNNUE;
+        send_locked("info string NNUE network %s, %s", file, SCL_nnueImplementationName(SCL_nnueImplementation));
+    } else {
+        send_locked("info string %s is not a network with %d features and %d neurons", file, SCL_NNUE_FEATURES,
+                    SCL_NNUE_HIDDEN);
+    }
+}
+#endif
+
+void set_option(char* args) {
+    char* name = strstr(args, "name ");
+    char* value = strstr(args, " value ");
+
+    if (!name) {
+        return;
+    }
+
+    name += 5;
+
+    if (value) {
+        *value = 0;
+        value += 7;
+    } else if (strlen(args) > 6 && strcmp(args + strlen(args) - 6, " value") == 0) { // empty value
+        value = args + strlen(args) - 6;
+        *value = 0;
+        value += 6;
+    }
+
+    long number = value ? atol(value) : 0;
+
+    if (strcmp(name, "Hash") == 0 && value) {
+        cancel_search();
+        SCL_transpositionTableInit(&SCL_transpositionTable, number > 0 ? (number < 4096 ? number : 4096) : 0);
+    } else if (strcmp(name, "Threads") == 0 && value) {
+        SCL_setThreads(number > 0 ? (number < SCL_MAX_THREADS ? number : SCL_MAX_THREADS) : 1);
+    } else if (strcmp(name, "MultiPV") == 0 && value) {
+        multi_pv = number > 0 ? (number < SCL_MAX_MULTI_PV ? number : SCL_MAX_MULTI_PV) : 1;
+#if SCL_NNUE
+    } else if (strcmp(name, "EvalFile") == 0) {
+        cancel_search();
+        load_network(value ? value : "");
+#endif
+    }
+}
+
+int main() {
+    static char line[65536];
+
+    SCL_init();
+    SCL_gameInit(&game, 0);
+    SCL_boardCopy(game.board, search_board);
+    ai.info_function = search_info;
+    ai.done_function = search_done;
+
+    while (fgets(line, sizeof(line), stdin)) {
+        line[strcspn(line, "\r\n")] = 0;
+
+        char* args = line + strcspn(line, " \t");
+        char* command = line;
+
+        if (*args) {
+            *args++ = 0;
+        }
+
+        if (strcmp(command, "uci") == 0) {
+            send_locked("id name smallchesslib\n"
+                        "id author drummyfish, mfbulut\n"
+                        "option name Hash type spin default %d min 0 max 4096\n"
+                        "option name Threads type spin default 1 min 1 max %d\n"
+                        "option name MultiPV type spin default 1 min 1 max %d\n"
+                        "option name Ponder type check default false\n"
+#if SCL_NNUE
+                        "option name EvalFile type string default <empty>\n"
+#endif
+                        "uciok", SCL_TRANSPOSITION_TABLE_SIZE, SCL_THREADS ? SCL_MAX_THREADS : 1,
+                        SCL_MAX_MULTI_PV);
+        } else if (strcmp(command, "isready") == 0) {
+            send_locked("readyok");
+        } else if (strcmp(command, "setoption") == 0) {
+            set_option(args);
+        } else if (strcmp(command, "ucinewgame") == 0) {
+            cancel_search();
+            SCL_transpositionTableClear(&SCL_transpositionTable);
+        } else if (strcmp(command, "position") == 0) {
+            position(args);
+        } else if (strcmp(command, "go") == 0) {
+            go(args);
+        } else if (strcmp(command, "stop") == 0) {
+            engine_result result;
+            release_result();
+            engine_stop(&ai, &result); // the search thread prints bestmove
+        } else if (strcmp(command, "ponderhit") == 0) {
+            if (ponder_time != 0) {
+                engine_ponderhit(&ai, ponder_time);
+            }
+
+            release_result();
+        } else if (strcmp(command, "quit") == 0) {
+            break;
+        }
+    }
+
+    cancel_search();
+
+    return 0;
+}